@@ -0,0 +1,314 @@
+//
+// Created by deity on 17.10.2026.
+//
+// Приём файлов по SPP от начала до конца: spp_client -> TCP stand-in из
+// ble_host.c -> spp_link -> кольцо файла -> задача spp_file -> файл на диске.
+//
+// Для каждого размера клиент шлёт FILE_OPEN и данные и ждёт FILE_STATUS;
+// время - до статуса, то есть вместе с fsync. Принятый файл сверяется
+// с отправленным. В конце передача рвётся посреди файла: недописанный файл
+// должен быть удалён.
+//
+// Затем кадры не по протоколу прямо в сокет: FILE_OPEN неверной длины должен
+// получить FILE_STATUS с ошибкой и ACK своего номера, кадр DATA длиннее
+// остатка файла - ACK прошлого кадра, FILE_STATUS и ABORT, после чего
+// файл удалён, а следующий кадр с тем же номером принимается. Файл, который
+// нельзя открыть (на его месте каталог), получает ровно один FILE_STATUS.
+//
+// Переменные окружения: SPP_FILE_DIR (spp_rx), SPP_FILE_MAX_KB (4096),
+// SPP_FILE_SEED (время).
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ble.h"
+#include "msg_bus.h"
+#include "spp_client.h"
+
+#define ABORT_SIZE      (64 * 1024)
+
+static const char *dir;
+
+static spp_client_t *connect_client(void)
+{
+    // сервер принимает следующего клиента после опроса раз в 100 мс
+    for (int i = 0; i < 20; i++) {
+        spp_client_t *c = spp_client_connect(BT_SPP_HOST_PORT);
+        if (c) return c;
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    return NULL;
+}
+
+static bool same_file(const char *path, const uint8_t *data, uint32_t size)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+
+    uint8_t buf[4096];
+    uint32_t off = 0;
+    size_t n;
+    bool same = true;
+    while (same && (n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        same = off + n <= size && memcmp(buf, data + off, n) == 0;
+        off += n;
+    }
+    fclose(f);
+    return same && off == size;
+}
+
+static bool transfer(spp_client_t *c, uint32_t size)
+{
+    char name[13], path[64];
+    uint8_t *data = malloc(size);
+    if (!data) return false;
+    for (uint32_t i = 0; i < size; i++) {
+        data[i] = (uint8_t)rand();
+    }
+    snprintf(name, sizeof(name), "F%lu.BIN", (unsigned long)(size / 1024));
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    spp_client_stats_t before, after;
+    spp_client_get_stats(c, &before);
+    uint8_t status = 0xff;
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = spp_client_send_file(c, name, data, size, &status);
+    int64_t us = esp_timer_get_time() - start;
+    spp_client_get_stats(c, &after);
+
+    bool ok = ret == ESP_OK && status == BT_SPP_FILE_OK && same_file(path, data, size);
+    printf("%5lu KB: %6.0f KB/s, %lld ms, status %u, %lu resent, %lu probes%s\n",
+           (unsigned long)(size / 1024), size / 1024.0 / (us / 1e6), (long long)us / 1000, status,
+           (unsigned long)(after.resent - before.resent), (unsigned long)(after.probes - before.probes),
+           ok ? "" : ", MISMATCH");
+    if (ret != ESP_OK) printf("client error %s\n", esp_err_to_name(ret));
+    free(data);
+    return ok;
+}
+
+// FILE_OPEN и начало первого кадра DATA, затем разрыв
+static bool aborted_removed(void)
+{
+    const char *name = "ABORT.BIN";
+    char path[64];
+    uint8_t buf[BT_SPP_HDR_SIZE + 8 + 9 + BT_SPP_HDR_SIZE + 1000];
+    uint8_t *p = buf;
+    uint32_t size = ABORT_SIZE;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    *p++ = BT_SPP_MAGIC;
+    *p++ = BT_SPP_FILE_OPEN;
+    *p++ = 0;
+    *p++ = 0;
+    *p++ = 8 + 9;
+    *p++ = 0;
+    for (int i = 0; i < 4; i++) *p++ = size >> (8 * i);
+    for (int i = 0; i < 4; i++) *p++ = 0;
+    memcpy(p, name, 9);
+    p += 9;
+    *p++ = BT_SPP_MAGIC;
+    *p++ = BT_SPP_DATA;
+    *p++ = 1;
+    *p++ = 0;
+    *p++ = BT_SPP_FRAME_MAX & 0xff;
+    *p++ = BT_SPP_FRAME_MAX >> 8;
+    memset(p, 0x5a, 1000);
+
+    spp_client_t *c = connect_client();
+    if (!c) return false;
+    spp_client_write_raw(c, buf, sizeof(buf));
+    spp_client_poll(c, 100);
+
+    struct stat st;
+    bool started = stat(path, &st) == 0;
+    spp_client_close(c);
+    // разрыв сервер увидит на следующем опросе сокета
+    vTaskDelay(pdMS_TO_TICKS(500));
+    bool removed = stat(path, &st) != 0;
+    printf("aborted transfer: file %s while receiving, %s after disconnect\n",
+           started ? "created" : "NOT created", removed ? "removed" : "LEFT");
+    return started && removed;
+}
+
+/* ---------- Кадры не по протоколу ---------- */
+
+typedef struct {
+    uint8_t  type;
+    uint16_t seq;
+    uint8_t  status;        // FILE_STATUS
+} reply_t;
+
+typedef struct {
+    reply_t  r[16];
+    int      count;
+    int      acked;         // seq последнего ACK, -1 - не было
+} replies_t;
+
+static size_t put_frame(uint8_t *p, uint8_t type, uint16_t seq, const void *data, uint16_t len)
+{
+    p[0] = BT_SPP_MAGIC;
+    p[1] = type;
+    p[2] = seq & 0xff;
+    p[3] = seq >> 8;
+    p[4] = len & 0xff;
+    p[5] = len >> 8;
+    if (len) memcpy(p + BT_SPP_HDR_SIZE, data, len);
+    return BT_SPP_HDR_SIZE + len;
+}
+
+// Кадры и PROBE в сокет, затем все ответы устройства до тишины
+static void exchange(int fd, const uint8_t *data, size_t len, replies_t *out)
+{
+    uint8_t buf[4096];
+    size_t n = len;
+    memcpy(buf, data, len);
+    n += put_frame(buf + n, BT_SPP_PROBE, 0, NULL, 0);
+    send(fd, buf, n, MSG_NOSIGNAL);
+
+    memset(out, 0, sizeof(*out));
+    out->acked = -1;
+    size_t have = 0;
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    while (poll(&pfd, 1, 300) > 0) {
+        ssize_t got = recv(fd, buf + have, sizeof(buf) - have, 0);
+        if (got <= 0) break;
+        have += got;
+        // кадры целиком, хвост ждёт следующего recv
+        size_t pos = 0;
+        while (have - pos >= BT_SPP_HDR_SIZE && buf[pos] == BT_SPP_MAGIC) {
+            uint16_t pl = buf[pos + 4] | (buf[pos + 5] << 8);
+            if (have - pos < BT_SPP_HDR_SIZE + pl) break;
+            reply_t r = { .type = buf[pos + 1], .seq = buf[pos + 2] | (buf[pos + 3] << 8) };
+            if (r.type == BT_SPP_FILE_STATUS && pl) r.status = buf[pos + BT_SPP_HDR_SIZE];
+            if (r.type == BT_SPP_ACK) {
+                out->acked = r.seq;
+            } else if (out->count < 16) {
+                out->r[out->count++] = r;
+            }
+            pos += BT_SPP_HDR_SIZE + pl;
+        }
+        memmove(buf, buf + pos, have - pos);
+        have -= pos;
+    }
+}
+
+static bool reply_is(const replies_t *rp, int i, uint8_t type, uint16_t seq, uint8_t status)
+{
+    return i < rp->count && rp->r[i].type == type && rp->r[i].seq == seq && rp->r[i].status == status;
+}
+
+static bool bad_frames(void)
+{
+    const char *name = "BAD.BIN";
+    char path[64];
+    uint8_t buf[BT_SPP_HDR_SIZE * 2 + 8 + 7 + 200], ctl[8 + 7] = { 100 }, data[200] = { 0 };
+    replies_t rp;
+    size_t n;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    memcpy(ctl + 8, name, 7);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(BT_SPP_HOST_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        printf("bad frames: connect failed\n");
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    vTaskDelay(pdMS_TO_TICKS(200));
+
+    // FILE_OPEN без имени: номер принят, статус - ошибка
+    exchange(fd, buf, put_frame(buf, BT_SPP_FILE_OPEN, 0, ctl, 4), &rp);
+    bool open_ok = reply_is(&rp, 0, BT_SPP_FILE_STATUS, 0, BT_SPP_FILE_BAD_FRAME) && rp.acked == 0;
+
+    // файл на 100 байт и кадр на 200
+    n = put_frame(buf, BT_SPP_FILE_OPEN, 1, ctl, sizeof(ctl));
+    n += put_frame(buf + n, BT_SPP_DATA, 2, data, sizeof(data));
+    exchange(fd, buf, n, &rp);
+    struct stat st;
+    bool data_ok = reply_is(&rp, 0, BT_SPP_FILE_STATUS, 0, BT_SPP_FILE_BAD_FRAME)
+                   && reply_is(&rp, 1, BT_SPP_ABORT, 2, 0) && rp.acked == 1;
+    bool removed = stat(path, &st) != 0;
+
+    // связь цела: тот же номер принимается обычным сообщением
+    exchange(fd, buf, put_frame(buf, BT_SPP_DATA, 2, "after", 5), &rp);
+    bool resumed = rp.count == 0 && rp.acked == 2;
+
+    // open() не проходит: статус сразу, после данных второго нет
+    memcpy(ctl + 8, "DIR.BIN", 7);
+    snprintf(path, sizeof(path), "%s/DIR.BIN", dir);
+    mkdir(path, 0775);
+    n = put_frame(buf, BT_SPP_FILE_OPEN, 3, ctl, sizeof(ctl));
+    n += put_frame(buf + n, BT_SPP_DATA, 4, data, 100);
+    exchange(fd, buf, n, &rp);
+    bool one_status = reply_is(&rp, 0, BT_SPP_FILE_STATUS, 0, BT_SPP_FILE_IO) && rp.count == 1 && rp.acked == 4;
+    rmdir(path);
+    close(fd);
+
+    printf("bad frames: file open %s, oversized data %s, file %s, next frame %s; unopenable file: %d statuses\n",
+           open_ok ? "refused" : "WRONG REPLY", data_ok ? "aborted" : "WRONG REPLY",
+           removed ? "removed" : "LEFT", resumed ? "accepted" : "NOT accepted", rp.count);
+    return open_ok && data_ok && removed && resumed && one_status;
+}
+
+void app_main(void)
+{
+    dir = getenv("SPP_FILE_DIR");
+    if (!dir) dir = "spp_rx";
+    const char *env = getenv("SPP_FILE_MAX_KB");
+    uint32_t max_kb = env ? (uint32_t)atoi(env) : 4096;
+    env = getenv("SPP_FILE_SEED");
+    unsigned seed = env ? (unsigned)atoi(env) : (unsigned)esp_timer_get_time();
+    srand(seed);
+
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    msg_bus_init();
+    bt_app_gatt_start();
+    if (bt_spp_file_init(dir) != ESP_OK) {
+        printf("spp file init failed\n");
+        exit(1);
+    }
+
+    spp_client_t *c = connect_client();
+    if (!c) {
+        printf("connect failed\n");
+        exit(1);
+    }
+    int files = 0, bad = 0;
+    uint64_t bytes = 0;
+    int64_t us = 0;
+    for (uint32_t kb = 64; kb <= max_kb; kb *= 4) {
+        int64_t start = esp_timer_get_time();
+        bad += !transfer(c, kb * 1024);
+        us += esp_timer_get_time() - start;
+        bytes += kb * 1024;
+        files++;
+    }
+    spp_client_close(c);
+    vTaskDelay(pdMS_TO_TICKS(200));
+
+    bool removed = aborted_removed();
+    vTaskDelay(pdMS_TO_TICKS(200));
+    bool rejected = bad_frames();
+    bool ok = !bad && removed && rejected;
+    printf("%d files, %llu KB at %.0f KB/s, %d bad; aborted transfer %s, error replies %s (seed %u): %s\n",
+           files, (unsigned long long)bytes / 1024, bytes / 1024.0 / (us / 1e6), bad,
+           removed ? "removed" : "NOT removed", rejected ? "right" : "WRONG", seed, ok ? "OK" : "FAILED");
+    fflush(stdout);
+    exit(ok ? 0 : 1);
+}
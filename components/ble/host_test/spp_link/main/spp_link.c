@@ -0,0 +1,203 @@
+//
+// Created by deity on 17.10.2026.
+//
+// Канал SPP целиком: TCP stand-in из ble_host.c, spp_link, кольцо приёма,
+// потребитель по уведомлениям шины, как в main, и клиент spp_client.
+//
+// 1. Оборванные кадры: SPP_LINK_ABORTS раз подключаемся, шлём заголовок DATA
+//    и половину данных (байты 0xEE) и рвём соединение. Потребитель не должен
+//    увидеть ни одного такого кадра.
+// 2. Поток: SPP_LINK_FRAMES кадров случайной длины, сначала с быстрым
+//    потребителем, затем с медленным (окно закрывается, ACK о свободном
+//    месте шлёт задача потребителя). Кадры должны прийти по порядку и без
+//    порчи, клиент - не зависнуть на закрытом окне.
+//
+// Переменные окружения: SPP_LINK_ABORTS (8), SPP_LINK_FRAMES (5000),
+// SPP_LINK_SEED (время).
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdatomic.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ble.h"
+#include "msg_bus.h"
+#include "spp_client.h"
+
+#define ABORT_BYTE      0xEE
+#define DRAIN_MS        5000
+#define SLOW_US         300     // на кадр у медленного потребителя
+
+static atomic_uint received;
+static atomic_uint bad;
+static atomic_uint aborted_seen;
+static atomic_int  consumer_delay_us;
+
+// Данные кадра: u32 номер, дальше байты от номера. Старший бит не ставится,
+// чтобы 0xEE оборванного кадра не совпал с данными
+static void fill(uint8_t *buf, uint32_t index, size_t len)
+{
+    memcpy(buf, &index, sizeof(index));
+    for (size_t i = sizeof(index); i < len; i++) {
+        buf[i] = (uint8_t)(index + i) & 0x7f;
+    }
+}
+
+static void check(const uint8_t *data, size_t len)
+{
+    uint8_t expect[BT_SPP_FRAME_MAX];
+    uint32_t index = atomic_load(&received);
+
+    if (len > sizeof(index) && memchr(data + sizeof(index), ABORT_BYTE, len - sizeof(index))) {
+        atomic_fetch_add(&aborted_seen, 1);
+    }
+    fill(expect, index, len);
+    if (len < sizeof(index) || memcmp(data, expect, len) != 0) {
+        if (!atomic_load(&bad)) printf("frame %lu: bad data, len %u\n", (unsigned long)index, (unsigned)len);
+        atomic_fetch_add(&bad, 1);
+    }
+    atomic_fetch_add(&received, 1);
+}
+
+// Как handle_spp_data() в main: по уведомлению забираем всё из кольца
+static void consumer_task(void *arg)
+{
+    msg_sub_t *sub = arg;
+    for (;;) {
+        msg_t *msg = msg_bus_receive(sub, pdMS_TO_TICKS(100));
+        if (msg) msg_bus_release(msg);
+
+        size_t len;
+        uint8_t *data;
+        while ((data = bt_spp_receive(&len, 0)) != NULL) {
+            check(data, len);
+            int delay = atomic_load(&consumer_delay_us);
+            if (delay) usleep(delay);
+            bt_spp_return(data);
+        }
+    }
+}
+
+static spp_client_t *connect_client(void)
+{
+    // сервер принимает следующего клиента после опроса раз в 100 мс
+    for (int i = 0; i < 20; i++) {
+        spp_client_t *c = spp_client_connect(BT_SPP_HOST_PORT);
+        if (c) return c;
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    return NULL;
+}
+
+static int abort_frames(int count)
+{
+    uint8_t buf[BT_SPP_HDR_SIZE + 700];
+    uint16_t len = 1500;
+
+    memset(buf, ABORT_BYTE, sizeof(buf));
+    buf[0] = BT_SPP_MAGIC;
+    buf[1] = BT_SPP_DATA;
+    buf[2] = buf[3] = 0;
+    buf[4] = len & 0xff;
+    buf[5] = len >> 8;
+
+    for (int i = 0; i < count; i++) {
+        spp_client_t *c = connect_client();
+        if (!c) return -1;
+        spp_client_write_raw(c, buf, sizeof(buf));
+        spp_client_poll(c, 50);
+        spp_client_close(c);
+        // разрыв сервер увидит на следующем опросе сокета
+        vTaskDelay(pdMS_TO_TICKS(150));
+    }
+    return 0;
+}
+
+static bool wait_received(uint32_t count)
+{
+    int64_t deadline = esp_timer_get_time() + DRAIN_MS * 1000LL;
+    while (atomic_load(&received) < count && esp_timer_get_time() < deadline) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return atomic_load(&received) == count;
+}
+
+// Один прогон потока; false, если клиент встал или кадры не дошли
+static bool stream(const char *name, uint32_t frames, int delay_us)
+{
+    uint8_t buf[BT_SPP_FRAME_MAX];
+    spp_client_t *c = connect_client();
+    if (!c) {
+        printf("%s: connect failed\n", name);
+        return false;
+    }
+
+    atomic_store(&consumer_delay_us, delay_us);
+    uint32_t first = atomic_load(&received);
+    uint32_t dropped = bt_spp_dropped();
+    int64_t start = esp_timer_get_time();
+
+    esp_err_t ret = ESP_OK;
+    for (uint32_t i = 0; i < frames && ret == ESP_OK; i++) {
+        size_t len = 4 + rand() % (BT_SPP_FRAME_MAX - 3);
+        fill(buf, first + i, len);
+        ret = spp_client_send(c, buf, len);
+    }
+    if (ret == ESP_OK) ret = spp_client_flush(c);
+    bool all = ret == ESP_OK && wait_received(first + frames);
+    int64_t us = esp_timer_get_time() - start;
+
+    spp_client_stats_t st;
+    spp_client_get_stats(c, &st);
+    spp_client_close(c);
+
+    printf("%s: %lu frames, %llu KB in %lld ms (%.0f KB/s), %lu resent, %lu probes, %lu acks, "
+           "%lu dropped by device%s\n",
+           name, (unsigned long)st.frames, (unsigned long long)st.bytes / 1024, (long long)us / 1000,
+           st.bytes / 1024.0 / (us / 1e6), (unsigned long)st.resent, (unsigned long)st.probes,
+           (unsigned long)st.acks, (unsigned long)(bt_spp_dropped() - dropped),
+           all ? "" : ", INCOMPLETE");
+    if (ret != ESP_OK) printf("%s: client error %s\n", name, esp_err_to_name(ret));
+    return all;
+}
+
+void app_main(void)
+{
+    const char *env = getenv("SPP_LINK_ABORTS");
+    int aborts = env ? atoi(env) : 8;
+    env = getenv("SPP_LINK_FRAMES");
+    uint32_t frames = env ? (uint32_t)atoi(env) : 5000;
+    env = getenv("SPP_LINK_SEED");
+    unsigned seed = env ? (unsigned)atoi(env) : (unsigned)esp_timer_get_time();
+    srand(seed);
+
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    msg_bus_init();
+    msg_sub_t *sub = msg_bus_sub_create(4);
+    msg_bus_subscribe(sub, MSG_TOPIC_SPP);
+    msg_bus_set_depth(MSG_TOPIC_SPP, 2);
+    xTaskCreate(consumer_task, "consumer", 4096, sub, 5, NULL);
+    bt_app_gatt_start();
+
+    if (abort_frames(aborts) != 0) {
+        printf("connect failed\n");
+        exit(1);
+    }
+    vTaskDelay(pdMS_TO_TICKS(200));
+    unsigned after_aborts = atomic_load(&received);
+
+    bool ok = stream("fast consumer", frames, 0);
+    ok = stream("slow consumer", frames / 5, SLOW_US) && ok;
+
+    unsigned seen = atomic_load(&aborted_seen) + after_aborts;
+    ok = ok && !seen && !atomic_load(&bad);
+    printf("%d aborted frames, %u reached the consumer; %u frames received, %u bad (seed %u): %s\n",
+           aborts, seen, atomic_load(&received), atomic_load(&bad), seed, ok ? "OK" : "FAILED");
+    fflush(stdout);
+    exit(ok ? 0 : 1);
+}
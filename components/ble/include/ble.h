@@ -4,10 +4,115 @@
 #pragma once
 
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
 #ifndef BLE_H
 #define BLE_H
 
-void bt_app_gatt_start(QueueHandle_t q);
+// Кольцо приёма SPP: пакеты целиком, без обрезки до размера сообщения шины
+#define BT_SPP_RX_RING_SIZE (8 * 1024)
+
+// Кадрированный протокол SPP (клиент начинает кадр с BT_SPP_MAGIC, иначе
+// пакет целиком считается одним сообщением и подтверждается "OK\n"):
+//
+//   [magic][type][seq lo][seq hi][len lo][len hi][payload ...]
+//
+// DATA  - seq растёт на 1 с нуля от каждого подключения. Принимаются только
+//         кадры по порядку, остальные отбрасываются (go-back-N).
+// ACK   - от устройства: seq = последний принятый кадр, payload = u16 credit,
+//         свободное место в кольце приёма в байтах. Клиент держит в полёте
+//         не больше credit байт. ACK шлётся каждые BT_SPP_ACK_EVERY кадров,
+//         когда принята половина credit из прошлого ACK, сразу при
+//         отброшенном кадре и при освобождении места в кольце, если окно
+//         перед этим было почти закрыто.
+// PROBE - запрос ACK (например, после тайм-аута у клиента).
+// ABORT - от устройства: кадр seq на своём месте, но не будет принят никогда
+//         (длина 0, больше BT_SPP_FRAME_MAX или остатка файла). Перед ним
+//         ACK с последним принятым. Клиент выбрасывает из окна этот кадр и
+//         все следующие; новый кадр снова получает этот seq.
+//
+// Передача файла: FILE_OPEN (нумеруется как DATA, payload = u32 size,
+// u32 crc32 (zlib), имя 8.3 без нуля), затем ровно size байт в кадрах DATA,
+// которые пишутся в файл, а не в кольцо приёма. Результат - FILE_STATUS
+// от устройства: u8 статус BT_SPP_FILE_*, u32 принято байт. Прервать
+// передачу можно только разрывом соединения, файл тогда удаляется. Кадр
+// DATA не по протоколу тоже прерывает её: FILE_STATUS с
+// BT_SPP_FILE_BAD_FRAME, затем ABORT. FILE_OPEN с неверной длиной
+// принимается по номеру и сразу получает FILE_STATUS с BT_SPP_FILE_BAD_FRAME.
+#define BT_SPP_MAGIC        0xA5
+#define BT_SPP_HDR_SIZE     6
+#define BT_SPP_DATA         0x01
+#define BT_SPP_ACK          0x02
+#define BT_SPP_PROBE        0x03
+#define BT_SPP_FILE_OPEN    0x04
+#define BT_SPP_FILE_STATUS  0x05
+#define BT_SPP_ABORT        0x06
+#define BT_SPP_FRAME_MAX    2048    // не больше половины кольца
+#define BT_SPP_ACK_EVERY    4
+
+_Static_assert(BT_SPP_FRAME_MAX <= BT_SPP_RX_RING_SIZE / 2, "SPP frame must fit the rx ring twice");
+
+#define BT_SPP_FILE_OK          0
+#define BT_SPP_FILE_BUSY        1   // уже идёт другая передача
+#define BT_SPP_FILE_BAD_NAME    2
+#define BT_SPP_FILE_NO_MEM      3
+#define BT_SPP_FILE_IO          4   // ошибка открытия или записи на карту
+#define BT_SPP_FILE_CRC         5
+#define BT_SPP_FILE_BAD_FRAME   6   // FILE_OPEN или DATA файла неверной длины
+
+// Кольцо приёма файла живёт только во время передачи; запись на карту
+// блоками BT_SPP_FILE_BLOCK идёт в своей задаче, пока кольцо заполняется
+#define BT_SPP_FILE_RING_SIZE   (16 * 1024)
+#define BT_SPP_FILE_BLOCK       4096
+#define BT_SPP_FILE_STACK       4096
+#define BT_SPP_FILE_PRIO        4
+
+// Сборка под linux: SPP заменён TCP сервером на 127.0.0.1 (src/ble_host.c),
+// данные режутся на куски размера MTU SPP, как их отдаёт стек BT
+#define BT_SPP_HOST_PORT        7777
+#define BT_SPP_HOST_MTU         990
+
+void bt_app_gatt_start(void);
 void bt_app_gap_start_up(void);
 
+/**
+ * @brief Take the next received SPP packet, in place in the receive ring
+ *
+ * The data stays valid until ::bt_spp_return(). A MSG_SPP_DATA message is
+ * published on MSG_TOPIC_SPP for every packet.
+ *
+ * @param[out] len  packet length
+ * @param wait      ticks to wait, 0 to poll
+ * @return pointer to the data, or NULL if nothing was received
+ */
+uint8_t *bt_spp_receive(size_t *len, TickType_t wait);
+
+/**
+ * @brief Give a packet from ::bt_spp_receive() back to the ring
+ */
+void bt_spp_return(uint8_t *data);
+
+/**
+ * @brief Enable file transfers over SPP into \p dir
+ *
+ * Call after the card is mounted. See BT_SPP_FILE_OPEN for the protocol.
+ *
+ * @param dir directory for received files, created if missing
+ * @return ESP_OK on success
+ */
+esp_err_t bt_spp_file_init(const char *dir);
+
+/**
+ * @brief Number of frames dropped because the receive ring was full
+ *
+ * Framed clients resend these; for unframed ones the data is lost.
+ */
+uint32_t bt_spp_dropped(void);
+
+/**
+ * @brief Send text to the connected client as is, without framing
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_STATE if no client is connected
+ */
+esp_err_t bt_spp_send_text(const char *text);
+
 #endif //BLE_H
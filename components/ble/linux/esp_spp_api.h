@@ -0,0 +1,16 @@
+//
+// Created by deity on 17.10.2026.
+//
+#pragma once
+
+#ifndef ESP_SPP_API_H
+#define ESP_SPP_API_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// Сборка под linux: стека BT нет, spp_link отвечает клиенту через сокет,
+// handle - его дескриптор (см. ble_host.c)
+esp_err_t esp_spp_write(uint32_t handle, int len, uint8_t *p_data);
+
+#endif //ESP_SPP_API_H
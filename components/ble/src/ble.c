@@ -8,6 +8,9 @@
 #include "esp_log.h"
 #include "esp_spp_api.h"
 #include "esp_system.h"
+#include "freertos/ringbuf.h"
+#include "ble.h"
+#include "spp_link.h"
 const char* GAP_TAG = "bt";
 
 typedef enum {
@@ -28,22 +31,8 @@ static const esp_spp_cfg_t spp_cfg = {
 };
 
 typedef struct {
-    QueueHandle_t out_q;     // «куда отправлять»
+    RingbufHandle_t rx_ring; // принятые по SPP данные, читаются по ссылке
 } bt_ctx_t;
-typedef enum {
-    DISP_TEXT,
-    DISP_ICON,
-    DISP_CLEAR,
-} disp_msg_type_t;
-
-typedef struct {
-    disp_msg_type_t type;
-    union {
-        struct { char text[32]; } txt;
-        struct { uint8_t icon_id; } icon;
-    } payload;
-} disp_msg_t;
-
 static bt_ctx_t bt;
 
 typedef struct {
@@ -218,29 +207,19 @@ void bt_spp_cb(esp_spp_cb_event_t event, esp_spp_cb_param_t *param) {
         case ESP_SPP_START_EVT:
             ESP_LOGI(GAP_TAG, "SPP сервер запущен, канал %d", param->srv_open.fd);
             break;
+        case ESP_SPP_SRV_OPEN_EVT:
+            ESP_LOGI(GAP_TAG, "SPP соединение открыто");
+            spp_link_open(param->srv_open.handle);
+            break;
         case ESP_SPP_CLOSE_EVT:
             ESP_LOGI(GAP_TAG, "SPP соединение закрыто");
+            spp_link_close();
             break;
         case ESP_SPP_DATA_IND_EVT:
-            // сюда придут данные от Python-клиента
-            ESP_LOGI(GAP_TAG, "Принято %d байт: %.*s",
-                     param->data_ind.len,
-                     param->data_ind.len,
-                     (char*)param->data_ind.data);
-
-            disp_msg_t m = {
-                .type = DISP_TEXT,
-            };
-            size_t n = MIN(sizeof(m.payload.txt.text)-1, param->data_ind.len);
-            memcpy(m.payload.txt.text, param->data_ind.data, n);
-            m.payload.txt.text[n] = '\0';
-
-            xQueueSend(bt.out_q, &m, 0);   // обычный контекст (НЕ ISR)
-
-            // можно распарсить команду и ответить:
-            esp_spp_write(param->data_ind.handle,
-                          strlen("OK\n"),
-                          (uint8_t*)"OK\n");
+            // сюда придут данные от Python-клиента: кадры пишутся прямо в
+            // rx_ring, подтверждения и окно - см. spp_link.c
+            ESP_LOGD(GAP_TAG, "Принято %d байт", param->data_ind.len);
+            spp_link_feed(param->data_ind.handle, param->data_ind.data, param->data_ind.len);
             break;
         default:
             break;
@@ -321,7 +300,7 @@ void bt_app_gap_start_up(void)
     esp_bt_gap_start_discovery(ESP_BT_INQ_MODE_GENERAL_INQUIRY, 10, 0);
 }
 
-void bt_app_gatt_start(QueueHandle_t q)
+void bt_app_gatt_start(void)
 {
     char bda_str[18] = {0};
 
@@ -348,6 +327,11 @@ void bt_app_gatt_start(QueueHandle_t q)
     }
 
     ESP_LOGI(GAP_TAG, "Own address:[%s]", bda2str((uint8_t *)esp_bt_dev_get_address(), bda_str, sizeof(bda_str)));
-    bt.out_q = q;
+    bt.rx_ring = xRingbufferCreate(BT_SPP_RX_RING_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (!bt.rx_ring) {
+        ESP_LOGE(GAP_TAG, "%s rx ring allocation failed", __func__);
+        return;
+    }
+    spp_link_init(bt.rx_ring);
     bt_app_gap_start_up();
 }
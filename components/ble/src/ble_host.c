@@ -0,0 +1,126 @@
+//
+// Created by deity on 17.10.2026.
+//
+// Сборка под linux: вместо стека BT - TCP сервер на BT_SPP_HOST_PORT.
+// Соединение клиента - это SPP соединение, прочитанные куски по
+// BT_SPP_HOST_MTU байт идут в spp_link так же, как ESP_SPP_DATA_IND_EVT.
+//
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "esp_log.h"
+#include "esp_spp_api.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include "ble.h"
+#include "spp_link.h"
+
+static const char *TAG = "bt_host";
+
+#define POLL_MS         100
+
+static RingbufHandle_t rx_ring;
+
+esp_err_t esp_spp_write(uint32_t handle, int len, uint8_t *p_data)
+{
+    // клиент мог уже уйти - ошибку увидит цикл чтения
+    return send((int)handle, p_data, len, MSG_NOSIGNAL) == len ? ESP_OK : ESP_FAIL;
+}
+
+// poll с повтором: задачи FreeRTOS здесь - потоки, их прерывают сигналы
+static int wait_readable(int fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int ret;
+    do {
+        ret = poll(&pfd, 1, POLL_MS);
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+static int open_server(void)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(BT_SPP_HOST_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void serve(int fd)
+{
+    uint8_t buf[BT_SPP_HOST_MTU];
+
+    ESP_LOGI(TAG, "SPP соединение открыто");
+    spp_link_open(fd);
+
+    for (;;) {
+        int ret = wait_readable(fd);
+        if (ret < 0) break;
+        if (ret == 0) continue;
+
+        ssize_t n;
+        do {
+            n = recv(fd, buf, sizeof(buf), 0);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) break;
+
+        spp_link_feed(fd, buf, n);
+    }
+
+    spp_link_close();
+    close(fd);
+    ESP_LOGI(TAG, "SPP соединение закрыто");
+}
+
+static void server_task(void *arg)
+{
+    int srv = open_server();
+    if (srv < 0) {
+        ESP_LOGE(TAG, "Failed to listen on port %d: %s", BT_SPP_HOST_PORT, strerror(errno));
+        vTaskDelete(NULL);
+        return;
+    }
+    ESP_LOGI(TAG, "SPP stand-in on 127.0.0.1:%d", BT_SPP_HOST_PORT);
+
+    for (;;) {
+        if (wait_readable(srv) <= 0) continue;
+
+        int fd = accept(srv, NULL, NULL);
+        if (fd < 0) continue;
+        // один клиент, как у SPP сервера на устройстве
+        serve(fd);
+    }
+}
+
+void bt_app_gatt_start(void)
+{
+    rx_ring = xRingbufferCreate(BT_SPP_RX_RING_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (!rx_ring) {
+        ESP_LOGE(TAG, "%s rx ring allocation failed", __func__);
+        return;
+    }
+    spp_link_init(rx_ring);
+    bt_app_gap_start_up();
+}
+
+void bt_app_gap_start_up(void)
+{
+    xTaskCreate(server_task, "spp_host", 4096, NULL, 5, NULL);
+}
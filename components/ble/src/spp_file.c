@@ -0,0 +1,229 @@
+//
+// Created by deity on 17.10.2026.
+//
+#include "spp_file.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "ble.h"
+#include "spp_link.h"
+
+static const char *TAG = "spp_file";
+
+#define FILE_NAME_MAX   12      // 8.3, длинные имена в FATFS выключены
+
+static struct {
+    char            dir[32];
+    TaskHandle_t    task;
+    RingbufHandle_t ring;
+    volatile bool   busy;
+    volatile bool   abort;
+
+    char            name[FILE_NAME_MAX + 1];
+    uint32_t        size;
+    uint32_t        crc;
+} xfer;
+
+// Имя 8.3 из символов A-Z 0-9 _ -, приводится к верхнему регистру
+static bool copy_name(char *dst, const char *src, size_t len)
+{
+    size_t base = 0, ext = 0;
+    bool dot = false;
+
+    if (len == 0 || len > FILE_NAME_MAX) return false;
+    for (size_t i = 0; i < len; i++) {
+        char c = src[i];
+        if (c == '.') {
+            if (dot || base == 0) return false;
+            dot = true;
+        } else if (isalnum((unsigned char)c) || c == '_' || c == '-') {
+            if (dot ? ++ext > 3 : ++base > 8) return false;
+        } else {
+            return false;
+        }
+        dst[i] = (char)toupper((unsigned char)c);
+    }
+    dst[len] = '\0';
+    return !dot || ext > 0;
+}
+
+// Файл сразу растягивается до полного размера: FAT выделяет цепочку
+// кластеров один раз, а не на каждой записи
+static int open_file(const char *path, uint32_t size)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0664);
+    if (fd < 0) return -1;
+
+    if (size && (lseek(fd, size, SEEK_SET) != (off_t)size || lseek(fd, 0, SEEK_SET) != 0)) {
+        ESP_LOGW(TAG, "Preallocation of %lu bytes failed", (unsigned long)size);
+    }
+    return fd;
+}
+
+// *reported - статус уже ушёл клиенту, второй FILE_STATUS не нужен
+static uint8_t receive(const char *path, uint8_t *buf, uint32_t *got, bool *reported)
+{
+    uint8_t status = BT_SPP_FILE_OK;
+    uint32_t crc = 0;
+    size_t fill = 0;
+
+    int fd = open_file(path, xfer.size);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        status = BT_SPP_FILE_IO;
+        // клиент узнаёт сразу, данные дальше просто вычитываются из кольца
+        spp_link_file_status(status, 0);
+        *reported = true;
+    }
+
+    // приём идёт параллельно с записью: пока карта пишет блок, стек BT
+    // складывает следующие кадры в кольцо
+    while (*got < xfer.size && !xfer.abort) {
+        size_t n;
+        uint8_t *data = xRingbufferReceive(xfer.ring, &n, pdMS_TO_TICKS(100));
+        if (!data) continue;
+
+        *got += n;
+        if (status == BT_SPP_FILE_OK) {
+            crc = esp_rom_crc32_le(crc, data, n);
+            for (size_t pos = 0; pos < n; ) {
+                size_t chunk = MIN(n - pos, BT_SPP_FILE_BLOCK - fill);
+                memcpy(buf + fill, data + pos, chunk);
+                fill += chunk;
+                pos += chunk;
+                // целые блоки по смещениям, кратным сектору
+                if (fill == BT_SPP_FILE_BLOCK) {
+                    if (write(fd, buf, fill) != (ssize_t)fill) status = BT_SPP_FILE_IO;
+                    fill = 0;
+                }
+            }
+        }
+        vRingbufferReturnItem(xfer.ring, data);
+        spp_link_file_released(n);
+    }
+
+    if (fd >= 0) {
+        if (status == BT_SPP_FILE_OK && fill && write(fd, buf, fill) != (ssize_t)fill) {
+            status = BT_SPP_FILE_IO;
+        }
+        if (status == BT_SPP_FILE_OK && fsync(fd) != 0) {
+            status = BT_SPP_FILE_IO;
+        }
+        close(fd);
+    }
+    if (status == BT_SPP_FILE_OK && crc != xfer.crc) {
+        ESP_LOGE(TAG, "CRC mismatch: %08lx, expected %08lx", (unsigned long)crc, (unsigned long)xfer.crc);
+        status = BT_SPP_FILE_CRC;
+    }
+    return status;
+}
+
+static void file_task(void *arg)
+{
+    char path[sizeof(xfer.dir) + 1 + sizeof(xfer.name)];
+    uint8_t *buf = malloc(BT_SPP_FILE_BLOCK);
+    if (!buf) {
+        ESP_LOGE(TAG, "No memory for the write buffer");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!xfer.busy) continue;
+
+        snprintf(path, sizeof(path), "%s/%s", xfer.dir, xfer.name);
+        ESP_LOGI(TAG, "Receiving %s, %lu bytes", path, (unsigned long)xfer.size);
+
+        int64_t start = esp_timer_get_time();
+        uint32_t got = 0;
+        bool reported = false;
+        uint8_t status = receive(path, buf, &got, &reported);
+        int64_t us = esp_timer_get_time() - start;
+
+        if (xfer.abort) {
+            ESP_LOGW(TAG, "%s aborted after %lu bytes", path, (unsigned long)got);
+            unlink(path);
+        } else if (status != BT_SPP_FILE_OK) {
+            unlink(path);
+            if (!reported) spp_link_file_status(status, got);
+            spp_link_post_text(status == BT_SPP_FILE_CRC ? "File CRC error" : "File write error");
+        } else {
+            ESP_LOGI(TAG, "%s done, %lu KB/s", path,
+                     (unsigned long)(us > 0 ? (uint64_t)got * 1000000 / 1024 / us : 0));
+            spp_link_file_status(status, got);
+
+            char text[32];
+            snprintf(text, sizeof(text), "%s %luB", xfer.name, (unsigned long)got);
+            spp_link_post_text(text);
+        }
+
+        // spp_link к этому моменту уже пишет в основное кольцо
+        vRingbufferDelete(xfer.ring);
+        xfer.ring = NULL;
+        xfer.busy = false;
+    }
+}
+
+esp_err_t spp_file_init(const char *dir)
+{
+    if (!dir || strlen(dir) >= sizeof(xfer.dir)) return ESP_ERR_INVALID_ARG;
+    if (xfer.task) return ESP_ERR_INVALID_STATE;
+
+    strcpy(xfer.dir, dir);
+    mkdir(xfer.dir, 0775);
+
+    if (xTaskCreate(file_task, "spp_file", BT_SPP_FILE_STACK, NULL, BT_SPP_FILE_PRIO, &xfer.task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+RingbufHandle_t spp_file_begin(const char *name, size_t name_len, uint32_t size, uint32_t crc, uint8_t *status)
+{
+    if (!xfer.task) {
+        *status = BT_SPP_FILE_IO;
+        return NULL;
+    }
+    if (xfer.busy) {
+        *status = BT_SPP_FILE_BUSY;
+        return NULL;
+    }
+    if (!copy_name(xfer.name, name, name_len)) {
+        *status = BT_SPP_FILE_BAD_NAME;
+        return NULL;
+    }
+
+    xfer.ring = xRingbufferCreate(BT_SPP_FILE_RING_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (!xfer.ring) {
+        *status = BT_SPP_FILE_NO_MEM;
+        return NULL;
+    }
+    xfer.size = size;
+    xfer.crc = crc;
+    xfer.abort = false;
+    xfer.busy = true;
+    xTaskNotifyGive(xfer.task);
+
+    *status = BT_SPP_FILE_OK;
+    return xfer.ring;
+}
+
+void spp_file_abort(void)
+{
+    if (xfer.busy) {
+        xfer.abort = true;
+    }
+}
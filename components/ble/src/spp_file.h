@@ -0,0 +1,28 @@
+//
+// Created by deity on 17.10.2026.
+//
+#pragma once
+
+#ifndef SPP_FILE_H
+#define SPP_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/ringbuf.h"
+
+esp_err_t spp_file_init(const char *dir);
+
+/**
+ * Начать приём файла (вызывается из spp_link по кадру FILE_OPEN).
+ * Возвращает кольцо, в которое spp_link кладёт данные файла, или NULL,
+ * тогда в *status код ошибки BT_SPP_FILE_*.
+ */
+RingbufHandle_t spp_file_begin(const char *name, size_t name_len, uint32_t size, uint32_t crc, uint8_t *status);
+
+// Соединение разорвано или кадр файла не по протоколу: недописанный файл
+// удаляется, FILE_STATUS не шлётся
+void spp_file_abort(void);
+
+#endif //SPP_FILE_H
@@ -0,0 +1,497 @@
+//
+// Created by deity on 17.10.2026.
+//
+#include "spp_link.h"
+
+#include <string.h>
+#include <stdatomic.h>
+
+#include "esp_log.h"
+#include "esp_spp_api.h"
+#include "ble.h"
+#include "msg_bus.h"
+#include "spp_file.h"
+
+static const char *TAG = "spp_link";
+
+typedef enum {
+    RX_HDR,         // собираем заголовок кадра
+    RX_PAYLOAD,     // данные кадра идут прямо в элемент кольца
+    RX_SKIP,        // кадр отброшен, пропускаем его данные
+    RX_CTL,         // управляющий кадр, собирается в ctl
+} rx_state_t;
+
+// FILE_OPEN: u32 size, u32 crc32, имя 8.3
+#define FILE_OPEN_HDR   8
+#define CTL_MAX         (FILE_OPEN_HDR + 12)
+
+// Элемент основного кольца начинается с item_hdr_t. Кадр, оборванный
+// разрывом соединения, отменить в кольце нельзя - он уходит с ITEM_ABORTED,
+// и bt_spp_receive() молча возвращает его обратно.
+#define ITEM_ABORTED    0x01
+
+typedef struct {
+    uint16_t len;
+    uint8_t  flags;
+    uint8_t  reserved;
+} item_hdr_t;
+
+// Заголовок элемента в NOSPLIT кольце IDF - 8 байт, данные выравниваются на 4
+#define RING_ITEM_OVERHEAD  8
+#define RING_ITEM_SIZE(len) ((((len) + 3) & ~(size_t)3) + RING_ITEM_OVERHEAD)
+
+// Кольцо приёма и сколько в нём занято. xRingbufferGetCurFreeSize() для
+// NOSPLIT - самый большой элемент, который влезет целиком, а не свободное
+// место, поэтому занятое считаем сами: BT задача прибавляет, потребитель
+// вычитает при возврате элемента.
+typedef struct {
+    RingbufHandle_t handle;
+    size_t          size;
+    atomic_size_t   used;
+} rx_ring_t;
+
+static struct {
+    rx_ring_t       main;
+    rx_ring_t       file;
+    rx_ring_t *_Atomic rx;          // куда идут кадры DATA: main или file
+    uint32_t        file_size;
+    uint32_t        file_left;      // байт файла ещё не принято
+    atomic_uint_least32_t handle;   // пишет BT задача, ACK шлёт и потребитель
+    atomic_bool     connected;
+
+    rx_state_t      state;
+    uint8_t         hdr[BT_SPP_HDR_SIZE];
+    size_t          hdr_len;
+    uint8_t         type;
+    uint16_t        seq;
+    uint16_t        len;
+    size_t          got;
+    uint8_t        *item;
+    uint8_t         ctl[CTL_MAX];
+
+    // expected и unacked пишет только BT задача. Потребитель в другой задаче
+    // читает expected и забирает window_low, чтобы послать ACK о свободном месте.
+    atomic_uint_least16_t expected; // следующий ожидаемый seq
+    uint16_t        unacked;        // принято кадров с последнего ACK
+    uint32_t        unacked_bytes;  // и байт в них
+    uint16_t        acked_credit;   // credit в последнем ACK
+    atomic_bool     window_low;     // клиент ждёт расширения окна
+
+    uint32_t        dropped;
+} link;
+
+// Свободно в кольце за вычетом заголовков одного кадра
+static uint16_t credit(rx_ring_t *r)
+{
+    size_t used = atomic_load(&r->used) + RING_ITEM_SIZE(sizeof(item_hdr_t));
+    size_t free = r->size > used ? r->size - used : 0;
+    return free > UINT16_MAX ? UINT16_MAX : (uint16_t)free;
+}
+
+static void write_ack(uint16_t cr)
+{
+    uint16_t acked = atomic_load(&link.expected) - 1;
+    uint8_t frame[BT_SPP_HDR_SIZE + 2] = {
+        BT_SPP_MAGIC, BT_SPP_ACK,
+        acked & 0xff, acked >> 8,
+        2, 0,
+        cr & 0xff, cr >> 8,
+    };
+    esp_spp_write(atomic_load(&link.handle), sizeof(frame), frame);
+}
+
+// Только из BT задачи
+static void send_ack(void)
+{
+    if (!atomic_load(&link.connected)) return;
+
+    // window_low ставим до подсчёта credit: если потребитель вернул элемент
+    // между ними, он либо увидит флаг и пошлёт ACK сам, либо его место уже
+    // есть в cr - уведомление о свободном месте не теряется
+    atomic_store(&link.window_low, true);
+    uint16_t cr = credit(link.rx);
+    if (cr >= 2 * BT_SPP_FRAME_MAX) atomic_store(&link.window_low, false);
+    link.unacked = 0;
+    link.unacked_bytes = 0;
+    link.acked_credit = cr;
+    write_ack(cr);
+}
+
+static void *ring_acquire(rx_ring_t *r, size_t len)
+{
+    void *item = NULL;
+    if (xRingbufferSendAcquire(r->handle, &item, len, 0) != pdTRUE) return NULL;
+    atomic_fetch_add(&r->used, RING_ITEM_SIZE(len));
+    return item;
+}
+
+// Элемент вернулся в кольцо (любая задача). Если клиент ждал окна, а место
+// появилось, ACK уходит отсюда же: состояние BT задачи при этом не меняется,
+// window_low забирается атомарно, и ACK шлёт только одна задача.
+static void ring_released(rx_ring_t *r, size_t len)
+{
+    atomic_fetch_sub(&r->used, RING_ITEM_SIZE(len));
+    if (r != link.rx || !atomic_load(&link.window_low)) return;
+
+    uint16_t cr = credit(r);
+    if (cr >= 2 * BT_SPP_FRAME_MAX && atomic_exchange(&link.window_low, false)
+        && atomic_load(&link.connected)) {
+        write_ack(cr);
+    }
+}
+
+static void notify(void)
+{
+    // только уведомление; если тема заполнена, данные дождутся следующего
+    msg_bus_post(MSG_TOPIC_SPP, MSG_SPP_DATA, NULL, 0);
+}
+
+static void send_frame(uint8_t type, uint16_t seq, const uint8_t *payload, uint16_t len)
+{
+    uint8_t frame[BT_SPP_HDR_SIZE + 8];
+    if (!atomic_load(&link.connected) || len > sizeof(frame) - BT_SPP_HDR_SIZE) return;
+
+    frame[0] = BT_SPP_MAGIC;
+    frame[1] = type;
+    frame[2] = seq & 0xff;
+    frame[3] = seq >> 8;
+    frame[4] = len & 0xff;
+    frame[5] = len >> 8;
+    if (len) memcpy(frame + BT_SPP_HDR_SIZE, payload, len);
+    esp_spp_write(atomic_load(&link.handle), BT_SPP_HDR_SIZE + len, frame);
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Клиент ждёт ACK, когда его окно (credit из прошлого ACK) кончается, даже
+// если потребитель успел всё забрать - поэтому ACK и по половине окна
+static void frame_done(void)
+{
+    atomic_fetch_add(&link.expected, 1);
+    link.unacked_bytes += RING_ITEM_SIZE(sizeof(item_hdr_t) + link.len);
+    if (++link.unacked >= BT_SPP_ACK_EVERY || 2 * link.unacked_bytes >= link.acked_credit ||
+        credit(link.rx) < 2 * BT_SPP_FRAME_MAX) {
+        send_ack();
+    }
+}
+
+// Кадр DATA на своём месте, но принять его нельзя: повтор ничего не изменит,
+// поэтому прерываем передачу файла и просим клиента выбросить кадр
+static void reject_data(void)
+{
+    send_ack();
+    if (link.file_left) {
+        uint32_t got = link.file_size - link.file_left;
+        link.rx = &link.main;
+        link.file_left = 0;
+        spp_file_abort();
+        spp_link_file_status(BT_SPP_FILE_BAD_FRAME, got);
+    }
+    send_frame(BT_SPP_ABORT, link.seq, NULL, 0);
+}
+
+// Заголовок собран: решаем, принимать кадр или пропускать
+static void frame_start(void)
+{
+    link.type = link.hdr[1];
+    link.seq = link.hdr[2] | (link.hdr[3] << 8);
+    link.len = link.hdr[4] | (link.hdr[5] << 8);
+    link.got = 0;
+    link.item = NULL;
+    link.state = link.len ? RX_SKIP : RX_HDR;
+
+    if (link.type == BT_SPP_PROBE) {
+        send_ack();
+        return;
+    }
+    if (link.type != BT_SPP_DATA && link.type != BT_SPP_FILE_OPEN) {
+        ESP_LOGW(TAG, "Bad frame type %u len %u", link.type, link.len);
+        return;
+    }
+    if (link.seq != atomic_load(&link.expected)) {
+        // повтор или дыра: отбрасываем, ACK с последним принятым -> go-back-N
+        send_ack();
+        return;
+    }
+    if (link.type == BT_SPP_FILE_OPEN) {
+        if (link.len <= FILE_OPEN_HDR || link.len > CTL_MAX) {
+            // номер принимаем, иначе клиент слал бы кадр снова и снова
+            ESP_LOGW(TAG, "Bad file open frame, len %u", link.len);
+            spp_link_file_status(BT_SPP_FILE_BAD_FRAME, 0);
+            frame_done();
+        } else {
+            link.state = RX_CTL;
+        }
+        return;
+    }
+    if (link.len == 0 || link.len > BT_SPP_FRAME_MAX || (link.file_left && link.len > link.file_left)) {
+        ESP_LOGW(TAG, "Bad data frame %u, len %u", link.seq, link.len);
+        reject_data();
+        return;
+    }
+
+    // в основном кольце перед данными заголовок элемента
+    size_t hdr = link.rx == &link.main ? sizeof(item_hdr_t) : 0;
+    uint8_t *item = ring_acquire(link.rx, hdr + link.len);
+    if (!item) {
+        link.dropped++;
+        ESP_LOGW(TAG, "Rx ring full, frame %u will be resent", link.seq);
+        send_ack();
+        return;
+    }
+    if (hdr) {
+        *(item_hdr_t *)item = (item_hdr_t){ .len = link.len };
+    }
+    link.item = item + hdr;
+    link.state = RX_PAYLOAD;
+}
+
+// FILE_OPEN принят целиком: дальше кадры DATA идут в файл
+static void file_open(void)
+{
+    uint32_t size = get_u32(link.ctl);
+    uint32_t crc = get_u32(link.ctl + 4);
+    uint8_t status = BT_SPP_FILE_BUSY;
+    RingbufHandle_t ring = NULL;
+
+    if (!link.file_left) {
+        ring = spp_file_begin((const char *)link.ctl + FILE_OPEN_HDR, link.len - FILE_OPEN_HDR,
+                              size, crc, &status);
+    }
+    if (!ring) {
+        ESP_LOGW(TAG, "File transfer refused: %u", status);
+        spp_link_file_status(status, 0);
+    } else if (size) {
+        link.file.handle = ring;
+        link.file.size = BT_SPP_FILE_RING_SIZE;
+        atomic_store(&link.file.used, 0);
+        link.rx = &link.file;
+        link.file_size = size;
+        link.file_left = size;
+    }
+    frame_done();
+}
+
+// Кадр DATA целиком в кольце
+static void data_done(void)
+{
+    RingbufHandle_t ring = link.rx->handle;
+    bool to_file = link.file_left != 0;
+    uint8_t *item = to_file ? link.item : link.item - sizeof(item_hdr_t);
+
+    // файл принят - переключаемся до SendComplete: после него задача
+    // записи может закончить и удалить своё кольцо
+    if (to_file) {
+        link.file_left -= link.len;
+        if (!link.file_left) link.rx = &link.main;
+    }
+    xRingbufferSendComplete(ring, item);
+    link.item = NULL;
+    link.state = RX_HDR;
+    if (!to_file) notify();
+    frame_done();
+}
+
+// Клиент без кадрирования: пакет целиком - одно сообщение, ответ "OK\n"
+static void feed_raw(uint32_t handle, const uint8_t *data, size_t len)
+{
+    uint8_t *item = len > BT_SPP_FRAME_MAX ? NULL : ring_acquire(&link.main, sizeof(item_hdr_t) + len);
+    if (!item) {
+        link.dropped++;
+        ESP_LOGW(TAG, "Rx ring full, %u bytes lost", (unsigned)len);
+        return;
+    }
+    *(item_hdr_t *)item = (item_hdr_t){ .len = len };
+    memcpy(item + sizeof(item_hdr_t), data, len);
+    xRingbufferSendComplete(link.main.handle, item);
+    notify();
+
+    esp_spp_write(handle, strlen("OK\n"), (uint8_t*)"OK\n");
+}
+
+void spp_link_init(RingbufHandle_t ring)
+{
+    memset(&link, 0, sizeof(link));
+    link.main.handle = ring;
+    link.main.size = BT_SPP_RX_RING_SIZE;
+    link.rx = &link.main;
+}
+
+void spp_link_open(uint32_t handle)
+{
+    atomic_store(&link.handle, handle);
+    link.state = RX_HDR;
+    link.hdr_len = 0;
+    atomic_store(&link.expected, 0);
+    link.unacked = 0;
+    link.unacked_bytes = 0;
+    link.acked_credit = 0;
+    atomic_store(&link.window_low, false);
+    atomic_store(&link.connected, true);
+}
+
+void spp_link_close(void)
+{
+    atomic_store(&link.connected, false);
+    if (link.state == RX_PAYLOAD && link.item) {
+        if (link.rx == &link.main) {
+            // полкадра потребителю не отдаём
+            uint8_t *item = link.item - sizeof(item_hdr_t);
+            ((item_hdr_t *)item)->flags |= ITEM_ABORTED;
+            xRingbufferSendComplete(link.main.handle, item);
+        } else {
+            // задача файла увидит abort и удалит файл
+            xRingbufferSendComplete(link.file.handle, link.item);
+        }
+    }
+    if (link.file_left) {
+        link.rx = &link.main;
+        link.file_left = 0;
+        spp_file_abort();
+    }
+    link.item = NULL;
+    link.state = RX_HDR;
+    link.hdr_len = 0;
+}
+
+void spp_link_feed(uint32_t handle, const uint8_t *data, size_t len)
+{
+    atomic_store(&link.handle, handle);
+
+    if (link.state == RX_HDR && link.hdr_len == 0 && len && data[0] != BT_SPP_MAGIC) {
+        feed_raw(handle, data, len);
+        return;
+    }
+
+    while (len) {
+        size_t n;
+        switch (link.state) {
+            case RX_HDR:
+                if (link.hdr_len == 0 && data[0] != BT_SPP_MAGIC) {
+                    // потеряли синхронизацию - ищем следующий кадр
+                    data++;
+                    len--;
+                    continue;
+                }
+                n = BT_SPP_HDR_SIZE - link.hdr_len;
+                if (n > len) n = len;
+                memcpy(link.hdr + link.hdr_len, data, n);
+                link.hdr_len += n;
+                if (link.hdr_len == BT_SPP_HDR_SIZE) {
+                    link.hdr_len = 0;
+                    frame_start();
+                }
+                break;
+
+            case RX_PAYLOAD:
+                n = link.len - link.got;
+                if (n > len) n = len;
+                memcpy(link.item + link.got, data, n);
+                link.got += n;
+                if (link.got == link.len) {
+                    data_done();
+                }
+                break;
+
+            case RX_CTL:
+                n = link.len - link.got;
+                if (n > len) n = len;
+                memcpy(link.ctl + link.got, data, n);
+                link.got += n;
+                if (link.got == link.len) {
+                    link.state = RX_HDR;
+                    file_open();
+                }
+                break;
+
+            case RX_SKIP:
+            default:
+                n = link.len - link.got;
+                if (n > len) n = len;
+                link.got += n;
+                if (link.got == link.len) {
+                    link.state = RX_HDR;
+                }
+                break;
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+void spp_link_file_released(size_t len)
+{
+    ring_released(&link.file, len);
+}
+
+void spp_link_file_status(uint8_t status, uint32_t bytes)
+{
+    uint8_t payload[5] = {
+        status,
+        bytes & 0xff, (bytes >> 8) & 0xff, (bytes >> 16) & 0xff, bytes >> 24,
+    };
+    send_frame(BT_SPP_FILE_STATUS, 0, payload, sizeof(payload));
+}
+
+void spp_link_post_text(const char *text)
+{
+    msg_bus_post_text(MSG_TOPIC_DISPLAY, text);
+}
+
+uint32_t spp_link_dropped(void)
+{
+    return link.dropped;
+}
+
+/* ---------- Чтение принятого (ble.h) ---------- */
+
+uint8_t *bt_spp_receive(size_t *len, TickType_t wait)
+{
+    if (!link.main.handle || !len) return NULL;
+
+    size_t n;
+    uint8_t *item;
+    while ((item = xRingbufferReceive(link.main.handle, &n, wait)) != NULL) {
+        item_hdr_t *hdr = (item_hdr_t *)item;
+        if (!(hdr->flags & ITEM_ABORTED)) {
+            *len = hdr->len;
+            return item + sizeof(item_hdr_t);
+        }
+        // кадр оборван разрывом соединения
+        vRingbufferReturnItem(link.main.handle, item);
+        ring_released(&link.main, n);
+    }
+    return NULL;
+}
+
+void bt_spp_return(uint8_t *data)
+{
+    if (link.main.handle && data) {
+        uint8_t *item = data - sizeof(item_hdr_t);
+        size_t len = sizeof(item_hdr_t) + ((item_hdr_t *)item)->len;
+        vRingbufferReturnItem(link.main.handle, item);
+        ring_released(&link.main, len);
+    }
+}
+
+esp_err_t bt_spp_file_init(const char *dir)
+{
+    return spp_file_init(dir);
+}
+
+uint32_t bt_spp_dropped(void)
+{
+    return spp_link_dropped();
+}
+
+esp_err_t bt_spp_send_text(const char *text)
+{
+    if (!text) return ESP_ERR_INVALID_ARG;
+    if (!atomic_load(&link.connected)) return ESP_ERR_INVALID_STATE;
+
+    // как ответ "OK\n" клиенту без кадрирования: текст как есть
+    return esp_spp_write(atomic_load(&link.handle), strlen(text), (uint8_t *)text);
+}
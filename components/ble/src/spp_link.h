@@ -0,0 +1,36 @@
+//
+// Created by deity on 17.10.2026.
+//
+#pragma once
+
+#ifndef SPP_LINK_H
+#define SPP_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/ringbuf.h"
+
+void spp_link_init(RingbufHandle_t ring);
+
+// Новое соединение: нумерация кадров с нуля
+void spp_link_open(uint32_t handle);
+void spp_link_close(void);
+
+// Разбор входящего потока SPP (вызывается из bt_spp_cb)
+void spp_link_feed(uint32_t handle, const uint8_t *data, size_t len);
+
+// Задача файла вернула элемент длины len в кольцо файла: возможно, пора
+// расширить окно
+void spp_link_file_released(size_t len);
+
+// Результат приёма файла клиенту, кадр FILE_STATUS
+void spp_link_file_status(uint8_t status, uint32_t bytes);
+
+// Сообщение на экран через шину, тема MSG_TOPIC_DISPLAY
+void spp_link_post_text(const char *text);
+
+uint32_t spp_link_dropped(void);
+
+#endif //SPP_LINK_H
@@ -282,6 +282,30 @@ static esp_err_t bme680_set_mode(bme680_t *dev, uint8_t mode)
 #define BME680_RAW_H_OFF (BME680_RAW_T_OFF + BME680_REG_HUM_MSB_0 - BME680_REG_TEMP_MSB_0)
 #define BME680_RAW_G_OFF (BME680_RAW_H_OFF + BME680_REG_GAS_R_MSB_0 - BME680_REG_HUM_MSB_0)
 
+_Static_assert(BME680_REG_RAW_DATA_0 == BME680_RAW_DATA_REG && BME680_REG_RAW_DATA_LEN == BME680_RAW_DATA_LEN,
+        "BME680_RAW_DATA_REG/LEN do not match the registers");
+
+static void bme680_parse_raw_data(const uint8_t *raw, bme680_raw_data_t *raw_data)
+{
+    raw_data->gas_index = raw[0] & BME680_GAS_MEAS_INDEX_BITS;
+
+    raw_data->gas_valid     = bme_get_reg_bit(raw[BME680_RAW_G_OFF + 1], BME680_GAS_VALID);
+    raw_data->heater_stable = bme_get_reg_bit(raw[BME680_RAW_G_OFF + 1], BME680_HEAT_STAB_R);
+
+    raw_data->temperature    = msb_lsb_xlsb_to_20bit(uint32_t, raw, BME680_RAW_T_OFF);
+    raw_data->pressure       = msb_lsb_xlsb_to_20bit(uint32_t, raw, BME680_RAW_P_OFF);
+    raw_data->humidity       = msb_lsb_to_type(uint16_t, raw, BME680_RAW_H_OFF);
+    raw_data->gas_resistance = ((uint16_t) raw[BME680_RAW_G_OFF] << 2) | raw[BME680_RAW_G_OFF + 1] >> 6;
+    raw_data->gas_range      = raw[BME680_RAW_G_OFF + 1] & BME680_GAS_RANGE_R_BITS;
+
+    /*
+     * BME680_REG_MEAS_STATUS_1, BME680_REG_MEAS_STATUS_2
+     * These data are not documented and it is not really clear when they are filled
+     */
+    ESP_LOGD(TAG, "Raw data: %" PRIu32 " %" PRIu32 " %d %d %d", raw_data->temperature, raw_data->pressure,
+            raw_data->humidity, raw_data->gas_resistance, raw_data->gas_range);
+}
+
 static esp_err_t bme680_get_raw_data(bme680_t *dev, bme680_raw_data_t *raw_data)
 {
     if (!dev->meas_started)
@@ -310,28 +334,15 @@ static esp_err_t bme680_get_raw_data(bme680_t *dev, bme680_raw_data_t *raw_data)
     }
 
     dev->meas_started = false;
-    raw_data->gas_index = dev->meas_status & BME680_GAS_MEAS_INDEX_BITS;
 
     // if there are new data, read raw data from sensor
     I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
     I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, BME680_REG_RAW_DATA_0, raw, BME680_REG_RAW_DATA_LEN));
     I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
 
-    raw_data->gas_valid     = bme_get_reg_bit(raw[BME680_RAW_G_OFF + 1], BME680_GAS_VALID);
-    raw_data->heater_stable = bme_get_reg_bit(raw[BME680_RAW_G_OFF + 1], BME680_HEAT_STAB_R);
-
-    raw_data->temperature    = msb_lsb_xlsb_to_20bit(uint32_t, raw, BME680_RAW_T_OFF);
-    raw_data->pressure       = msb_lsb_xlsb_to_20bit(uint32_t, raw, BME680_RAW_P_OFF);
-    raw_data->humidity       = msb_lsb_to_type(uint16_t, raw, BME680_RAW_H_OFF);
-    raw_data->gas_resistance = ((uint16_t) raw[BME680_RAW_G_OFF] << 2) | raw[BME680_RAW_G_OFF + 1] >> 6;
-    raw_data->gas_range      = raw[BME680_RAW_G_OFF + 1] & BME680_GAS_RANGE_R_BITS;
-
-    /*
-     * BME680_REG_MEAS_STATUS_1, BME680_REG_MEAS_STATUS_2
-     * These data are not documented and it is not really clear when they are filled
-     */
-    ESP_LOGD(TAG, "Raw data: %" PRIu32 " %" PRIu32 " %d %d %d", raw_data->temperature, raw_data->pressure,
-            raw_data->humidity, raw_data->gas_resistance, raw_data->gas_range);
+    // the status was read before the burst, the index comes from there
+    raw[0] = dev->meas_status;
+    bme680_parse_raw_data(raw, raw_data);
 
     return ESP_OK;
 }
@@ -757,33 +768,31 @@ esp_err_t bme680_is_measuring(bme680_t *dev, bool *busy)
     return ESP_OK;
 }
 
-esp_err_t bme680_get_results_fixed(bme680_t *dev, bme680_values_fixed_t *results)
+static void bme680_invalidate(bme680_values_fixed_t *results)
 {
-    CHECK_ARG(dev && results);
-
     // fill data structure with invalid values
     results->temperature = INT16_MIN;
     results->pressure = 0;
     results->humidity = 0;
     results->gas_resistance = 0;
+}
 
-    bme680_raw_data_t raw;
-    CHECK(bme680_get_raw_data(dev, &raw));
-
+static void bme680_compensate(bme680_t *dev, const bme680_raw_data_t *raw, bme680_values_fixed_t *results)
+{
     // use compensation algorithms to compute sensor values in fixed point format
     if (dev->settings.osr_temperature)
-        results->temperature = bme680_convert_temperature(dev, raw.temperature);
+        results->temperature = bme680_convert_temperature(dev, raw->temperature);
     if (dev->settings.osr_pressure)
-        results->pressure = bme680_convert_pressure(dev, raw.pressure);
+        results->pressure = bme680_convert_pressure(dev, raw->pressure);
     if (dev->settings.osr_humidity)
-        results->humidity = bme680_convert_humidity(dev, raw.humidity);
+        results->humidity = bme680_convert_humidity(dev, raw->humidity);
 
     if (dev->settings.heater_profile != BME680_HEATER_NOT_USED)
     {
         // convert gas only if raw data are valid and heater was stable
-        if (raw.gas_valid && raw.heater_stable)
-            results->gas_resistance = bme680_convert_gas(dev, raw.gas_resistance, raw.gas_range);
-        else if (!raw.gas_valid)
+        if (raw->gas_valid && raw->heater_stable)
+            results->gas_resistance = bme680_convert_gas(dev, raw->gas_resistance, raw->gas_range);
+        else if (!raw->gas_valid)
             ESP_LOGW(TAG, "Gas data is not valid");
         else
             ESP_LOGW(TAG, "Heater is not stable");
@@ -791,6 +800,25 @@ esp_err_t bme680_get_results_fixed(bme680_t *dev, bme680_values_fixed_t *results
 
     ESP_LOGD(TAG, "Fixed point sensor values - %d/100 deg.C, %" PRIu32 "/1000 %%, %" PRIu32 " Pa, %" PRIu32 " Ohm",
             results->temperature, results->humidity, results->pressure, results->gas_resistance);
+}
+
+static void bme680_fixed_to_float(const bme680_values_fixed_t *fixed, bme680_values_float_t *results)
+{
+    results->temperature = fixed->temperature / 100.0f;
+    results->pressure = fixed->pressure / 100.0f;
+    results->humidity = fixed->humidity / 1000.0f;
+    results->gas_resistance = fixed->gas_resistance;
+}
+
+esp_err_t bme680_get_results_fixed(bme680_t *dev, bme680_values_fixed_t *results)
+{
+    CHECK_ARG(dev && results);
+
+    bme680_invalidate(results);
+
+    bme680_raw_data_t raw;
+    CHECK(bme680_get_raw_data(dev, &raw));
+    bme680_compensate(dev, &raw, results);
 
     return ESP_OK;
 }
@@ -801,11 +829,44 @@ esp_err_t bme680_get_results_float(bme680_t *dev, bme680_values_float_t *results
 
     bme680_values_fixed_t fixed;
     CHECK(bme680_get_results_fixed(dev, &fixed));
+    bme680_fixed_to_float(&fixed, results);
 
-    results->temperature = fixed.temperature / 100.0f;
-    results->pressure = fixed.pressure / 100.0f;
-    results->humidity = fixed.humidity / 1000.0f;
-    results->gas_resistance = fixed.gas_resistance;
+    return ESP_OK;
+}
+
+esp_err_t bme680_compute_results_fixed(bme680_t *dev, const uint8_t *raw, bme680_values_fixed_t *results)
+{
+    CHECK_ARG(dev && raw && results);
+
+    bme680_invalidate(results);
+
+    // raw[0] is the measurement status register
+    if (!(raw[0] & BME680_NEW_DATA_BITS))
+    {
+        if (raw[0] & BME680_MEASURING_BITS)
+        {
+            ESP_LOGW(TAG, "Measurement is still running");
+            return ESP_ERR_INVALID_STATE;
+        }
+        ESP_LOGW(TAG, "No new data");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    dev->meas_started = false;
+
+    bme680_raw_data_t raw_data;
+    bme680_parse_raw_data(raw, &raw_data);
+    bme680_compensate(dev, &raw_data, results);
+
+    return ESP_OK;
+}
+
+esp_err_t bme680_compute_results_float(bme680_t *dev, const uint8_t *raw, bme680_values_float_t *results)
+{
+    CHECK_ARG(dev && raw && results);
+
+    bme680_values_fixed_t fixed;
+    CHECK(bme680_compute_results_fixed(dev, raw, &fixed));
+    bme680_fixed_to_float(&fixed, results);
 
     return ESP_OK;
 }
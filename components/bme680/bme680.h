@@ -54,6 +54,9 @@ extern "C" {
 #define BME680_I2C_ADDR_0 0x76
 #define BME680_I2C_ADDR_1 0x77
 
+#define BME680_RAW_DATA_REG 0x1d  //!< First register of a raw result, the measurement status
+#define BME680_RAW_DATA_LEN 15    //!< Length of a raw result, see ::bme680_compute_results_fixed()
+
 #define BME680_MAX_OVERFLOW_VAL      INT32_C(0x40000000) // overflow value used in pressure calculation (bme680_convert_pressure)
 
 #define BME680_HEATER_TEMP_MIN         200  //!< min. 200 degree Celsius
@@ -299,6 +302,35 @@ esp_err_t bme680_get_results_fixed(bme680_t *dev, bme680_values_fixed_t *results
  */
 esp_err_t bme680_get_results_float(bme680_t *dev, bme680_values_float_t *results);
 
+/**
+ * @brief   Compute results from raw data read by the caller
+ *
+ * For callers that read the result registers themselves, e.g. as an
+ * asynchronous i2cdev request together with other devices: read
+ * BME680_RAW_DATA_LEN bytes from register BME680_RAW_DATA_REG once the
+ * measurement duration has passed. The function fails like
+ * *bme680_get_results_fixed* if the status in the raw data shows that
+ * the measurement is still running or there are no new data.
+ *
+ * @param dev Device descriptor
+ * @param raw BME680_RAW_DATA_LEN bytes read from BME680_RAW_DATA_REG
+ * @param[out] results pointer to a data structure that is filled with results
+ * @return `ESP_OK` on success
+ */
+esp_err_t bme680_compute_results_fixed(bme680_t *dev, const uint8_t *raw, bme680_values_fixed_t *results);
+
+/**
+ * @brief   Compute results from raw data read by the caller
+ *
+ * Floating point variant of *bme680_compute_results_fixed*.
+ *
+ * @param dev Device descriptor
+ * @param raw BME680_RAW_DATA_LEN bytes read from BME680_RAW_DATA_REG
+ * @param[out] results pointer to a data structure that is filled with results
+ * @return `ESP_OK` on success
+ */
+esp_err_t bme680_compute_results_float(bme680_t *dev, const uint8_t *raw, bme680_values_float_t *results);
+
 /**
  * @brief   Start a measurement, wait and return the results (fixed point)
  *
@@ -23,8 +23,17 @@
 
 #include "color.h"
 #include <math.h>
+#include <string.h>
 #include <lib8tion.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define COLOR_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define COLOR_NEON
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 #define APPLY_DIMMING(X) (X)
@@ -588,7 +597,18 @@ void rgb_fill_solid_hsv(rgb_t *target, hsv_t color, size_t num)
 
 void rgb_fill_solid_rgb(rgb_t *target, rgb_t color, size_t num)
 {
-    for (size_t i = 0; i < num; ++i)
+    // 16 colors are 48 bytes: whole words and whole SIMD registers
+    rgb_t pattern[16];
+    size_t i = 0;
+
+    if (num >= 16)
+    {
+        for (size_t j = 0; j < 16; j++)
+            pattern[j] = color;
+        for (; i + 16 <= num; i += 16)
+            memcpy(target + i, pattern, sizeof(pattern));
+    }
+    for (; i < num; ++i)
         target[i] = color;
 }
 
@@ -1011,11 +1031,131 @@ void blur1d(rgb_t *leds, size_t num_leds, fract8 blur_amount)
     }
 }
 
+_Static_assert(sizeof(rgb_t) == 3, "rgb_t must be 3 packed bytes");
+
+// Bytes of a row blurred at once by blur_columns_linear(), 64 pixels
+#define BLUR_STRIP 192
+
+// scale8() of each byte of a word
+static inline uint32_t swar_scale8(uint32_t w, uint8_t scale)
+{
+    uint32_t s = 1 + (uint32_t)scale;
+    return ((((w & 0x00ff00ff) * s) >> 8) & 0x00ff00ff)
+        | ((((w >> 8) & 0x00ff00ff) * s) & 0xff00ff00);
+}
+
+// qadd8() of each byte of two words
+static inline uint32_t swar_qadd8(uint32_t a, uint32_t b)
+{
+    uint32_t sum = ((a & 0x7f7f7f7f) + (b & 0x7f7f7f7f)) ^ ((a ^ b) & 0x80808080);
+    uint32_t ovf = ((a & b) | ((a | b) & ~sum)) & 0x80808080;
+    return sum | ((ovf >> 7) * 0xff);
+}
+
+// blend8() of each byte of two words: (a * (256 - amount) + b * (amount + 1)) >> 8,
+// at most 0xffff per 16-bit lane
+static inline uint32_t swar_blend8(uint32_t a, uint32_t b, uint8_t amount)
+{
+    uint32_t ka = 256 - (uint32_t)amount, kb = 1 + (uint32_t)amount;
+    return ((((a & 0x00ff00ff) * ka + (b & 0x00ff00ff) * kb) >> 8) & 0x00ff00ff)
+        | ((((a >> 8) & 0x00ff00ff) * ka + ((b >> 8) & 0x00ff00ff) * kb) & 0xff00ff00);
+}
+
+static inline uint32_t load_px(const uint8_t *p)
+{
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16;
+}
+
+static inline void store_px(uint8_t *p, uint32_t w)
+{
+    p[0] = w;
+    p[1] = w >> 8;
+    p[2] = w >> 16;
+}
+
+// Same math as blur1d() on row-major rows, a pixel per word. Left neighbor
+// is kept in a register until its share of the current pixel is added.
+static void blur_rows_linear(uint8_t *p, size_t width, size_t height, uint8_t keep, uint8_t seep)
+{
+    size_t pitch = width * 3;
+    if (!width)
+        return;
+    for (size_t row = 0; row < height; row++, p += pitch)
+    {
+        uint32_t w = load_px(p);
+        uint32_t carry = swar_scale8(w, seep);
+        uint32_t left = swar_scale8(w, keep);
+        for (size_t i = 3; i < pitch; i += 3)
+        {
+            w = load_px(p + i);
+            uint32_t part = swar_scale8(w, seep);
+            store_px(p + i - 3, swar_qadd8(left, part));
+            left = swar_qadd8(swar_scale8(w, keep), carry);
+            carry = part;
+        }
+        store_px(p + pitch - 3, left);
+    }
+}
+
+// Columns of a row-major matrix: every channel byte of a row is a column of
+// its own, so each row is blurred into the previous one as a flat byte span,
+// four bytes per word. Rows are cut into strips to keep the carry buffer small.
+static void blur_columns_linear(uint8_t *p, size_t width, size_t height, uint8_t keep, uint8_t seep)
+{
+    size_t pitch = width * 3;
+    uint32_t carry[BLUR_STRIP / 4];
+
+    for (size_t x = 0; x < pitch; x += BLUR_STRIP)
+    {
+        size_t n = pitch - x < BLUR_STRIP ? pitch - x : BLUR_STRIP;
+        size_t words = n / 4;
+        uint8_t *cur = p + x;
+
+        for (size_t y = 0; y < height; y++, cur += pitch)
+        {
+            for (size_t j = 0; j < words; j++)
+            {
+                uint32_t w, up;
+                memcpy(&w, cur + j * 4, 4);
+                uint32_t part = swar_scale8(w, seep);
+                w = swar_scale8(w, keep);
+                if (y)
+                {
+                    w = swar_qadd8(w, carry[j]);
+                    memcpy(&up, cur - pitch + j * 4, 4);
+                    up = swar_qadd8(up, part);
+                    memcpy(cur - pitch + j * 4, &up, 4);
+                }
+                memcpy(cur + j * 4, &w, 4);
+                carry[j] = part;
+            }
+            // tail of the strip, at most 3 bytes
+            for (size_t j = words * 4; j < n; j++)
+            {
+                uint8_t part = scale8(cur[j], seep);
+                uint8_t prev_part = ((uint8_t *)&carry[words])[j - words * 4];
+                cur[j] = scale8(cur[j], keep);
+                if (y)
+                {
+                    cur[j] = qadd8(cur[j], prev_part);
+                    cur[j - pitch] = qadd8(cur[j - pitch], part);
+                }
+                ((uint8_t *)&carry[words])[j - words * 4] = part;
+            }
+        }
+    }
+}
+
 void blur_columns(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_to_offs_cb xy, void *ctx)
 {
     // blur columns
     uint8_t keep = 255 - blur_amount;
     uint8_t seep = blur_amount >> 1;
+    if (!xy)
+    {
+        blur_columns_linear((uint8_t *)leds, width, height, keep, seep);
+        return;
+    }
     for (size_t col = 0; col < width; ++col)
     {
         rgb_t carryover = rgb_from_code(0);
@@ -1042,6 +1182,11 @@ void blur_rows(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_
     // blur rows same as columns, for irregular matrix
     uint8_t keep = 255 - blur_amount;
     uint8_t seep = blur_amount >> 1;
+    if (!xy)
+    {
+        blur_rows_linear((uint8_t *)leds, width, height, keep, seep);
+        return;
+    }
     for (size_t row = 0; row < height; row++)
     {
         rgb_t carryover = rgb_from_code(0);
@@ -1069,6 +1214,127 @@ void blur2d(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_to_
     blur_columns(leds, width, height, blur_amount, xy, ctx);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Array functions: SIMD blocks first, then words, then single bytes
+
+static void scale_bytes(uint8_t *p, size_t n, uint8_t scale)
+{
+    size_t i = 0;
+#if defined(COLOR_SSE2)
+    __m128i z = _mm_setzero_si128();
+    __m128i k = _mm_set1_epi16(1 + scale);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(v, z), k), 8);
+        __m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(v, z), k), 8);
+        _mm_storeu_si128((__m128i *)(p + i), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(COLOR_NEON)
+    uint16x8_t k = vdupq_n_u16(1 + scale);
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t v = vld1q_u8(p + i);
+        uint8x8_t lo = vshrn_n_u16(vmulq_u16(vmovl_u8(vget_low_u8(v)), k), 8);
+        uint8x8_t hi = vshrn_n_u16(vmulq_u16(vmovl_u8(vget_high_u8(v)), k), 8);
+        vst1q_u8(p + i, vcombine_u8(lo, hi));
+    }
+#endif
+    for (; i + 4 <= n; i += 4)
+    {
+        uint32_t w;
+        memcpy(&w, p + i, 4);
+        w = swar_scale8(w, scale);
+        memcpy(p + i, &w, 4);
+    }
+    for (; i < n; i++)
+        p[i] = scale8(p[i], scale);
+}
+
+static void add_bytes(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    size_t i = 0;
+#if defined(COLOR_SSE2)
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_adds_epu8(a, b));
+    }
+#elif defined(COLOR_NEON)
+    for (; i + 16 <= n; i += 16)
+        vst1q_u8(dst + i, vqaddq_u8(vld1q_u8(dst + i), vld1q_u8(src + i)));
+#endif
+    for (; i + 4 <= n; i += 4)
+    {
+        uint32_t a, b;
+        memcpy(&a, dst + i, 4);
+        memcpy(&b, src + i, 4);
+        a = swar_qadd8(a, b);
+        memcpy(dst + i, &a, 4);
+    }
+    for (; i < n; i++)
+        dst[i] = qadd8(dst[i], src[i]);
+}
+
+static void blend_bytes(uint8_t *dst, const uint8_t *src, size_t n, uint8_t amount)
+{
+    size_t i = 0;
+#if defined(COLOR_SSE2)
+    __m128i z = _mm_setzero_si128();
+    __m128i ka = _mm_set1_epi16(256 - amount);
+    __m128i kb = _mm_set1_epi16(1 + amount);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, z), ka),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(b, z), kb));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, z), ka),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(b, z), kb));
+        lo = _mm_srli_epi16(lo, 8);
+        hi = _mm_srli_epi16(hi, 8);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(COLOR_NEON)
+    uint16x8_t ka = vdupq_n_u16(256 - amount);
+    uint16x8_t kb = vdupq_n_u16(1 + amount);
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t a = vld1q_u8(dst + i);
+        uint8x16_t b = vld1q_u8(src + i);
+        uint16x8_t lo = vmlaq_u16(vmulq_u16(vmovl_u8(vget_low_u8(a)), ka), vmovl_u8(vget_low_u8(b)), kb);
+        uint16x8_t hi = vmlaq_u16(vmulq_u16(vmovl_u8(vget_high_u8(a)), ka), vmovl_u8(vget_high_u8(b)), kb);
+        vst1q_u8(dst + i, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+    }
+#endif
+    for (; i + 4 <= n; i += 4)
+    {
+        uint32_t a, b;
+        memcpy(&a, dst + i, 4);
+        memcpy(&b, src + i, 4);
+        a = swar_blend8(a, b, amount);
+        memcpy(dst + i, &a, 4);
+    }
+    for (; i < n; i++)
+        dst[i] = blend8(dst[i], src[i], amount);
+}
+
+void rgb_scale_array(rgb_t *leds, size_t num, uint8_t scale)
+{
+    scale_bytes((uint8_t *)leds, num * sizeof(rgb_t), scale);
+}
+
+void rgb_add_array(rgb_t *dst, const rgb_t *src, size_t num)
+{
+    add_bytes((uint8_t *)dst, (const uint8_t *)src, num * sizeof(rgb_t));
+}
+
+void rgb_blend_array(rgb_t *dst, const rgb_t *src, size_t num, fract8 amount)
+{
+    blend_bytes((uint8_t *)dst, (const uint8_t *)src, num * sizeof(rgb_t), amount);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 uint8_t apply_gamma2brightness(uint8_t brightness, float gamma)
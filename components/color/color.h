@@ -287,6 +287,9 @@ rgb_t color_from_palette_rgb(const rgb_t *palette, uint8_t pal_size, uint8_t ind
 /**
  * Function which must be provided by the application for use in two-dimensional
  * filter functions.
+ *
+ * Pass NULL instead for a plain row-major matrix (offset = y * width + x),
+ * which takes a faster path working on whole rows.
  */
 typedef size_t (*xy_to_offs_cb)(void *ctx, size_t x, size_t y);
 
@@ -336,6 +339,36 @@ void blur_rows(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_
  */
 void blur2d(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_to_offs_cb xy, void *ctx);
 
+////////////////////////////////////////////////////////////////////////////////
+// Array functions
+//
+// Same results as the per-pixel functions in rgb.h, but on whole arrays:
+// 16 bytes at a time with SSE2/NEON where available, 4 bytes in a 32-bit
+// word elsewhere. `dst` and `src` must either be the same or not overlap.
+
+/**
+ * @brief rgb_scale() of every color in array
+ */
+void rgb_scale_array(rgb_t *leds, size_t num, uint8_t scale);
+
+/**
+ * @brief rgb_fade() of every color in array
+ */
+static inline void rgb_fade_array(rgb_t *leds, size_t num, uint8_t fade_factor)
+{
+    rgb_scale_array(leds, num, ~fade_factor);
+}
+
+/**
+ * @brief dst[i] = rgb_add_rgb(dst[i], src[i])
+ */
+void rgb_add_array(rgb_t *dst, const rgb_t *src, size_t num);
+
+/**
+ * @brief dst[i] = rgb_blend(dst[i], src[i], amount)
+ */
+void rgb_blend_array(rgb_t *dst, const rgb_t *src, size_t num, fract8 amount);
+
 ////////////////////////////////////////////////////////////////////////////////
 // Gamma functions
 
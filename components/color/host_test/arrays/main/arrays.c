@@ -0,0 +1,215 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 deity
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * rgb_fill_solid_rgb(), rgb_fade_array(), rgb_add_array() and
+ * rgb_blend_array() against the per-pixel functions of rgb.h:
+ *
+ * - arrays of 0..100 pixels at 3 start offsets with all 256 parameters,
+ *   bytes around the array must stay untouched;
+ * - fade and blend over all byte pairs (65536-pixel arrays, every
+ *   parameter), add over all byte pairs once;
+ * - then the speed of both, per call, on 64, 256 and 4096 pixels.
+ *
+ * Which kernels color.c was built with (SSE2, NEON or 32-bit words) follows
+ * the same compiler macros as there.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_timer.h>
+#include <color.h>
+
+#if defined(__SSE2__)
+#define KERNELS "SSE2"
+#elif defined(__ARM_NEON)
+#define KERNELS "NEON"
+#else
+#define KERNELS "32-bit words"
+#endif
+
+#define SMALL_MAX   100
+#define OFFSETS     3
+#define PAIRS       65536
+#define BENCH_MAX   4096
+
+static void ref_fill(rgb_t *dst, rgb_t c, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        dst[i] = c;
+}
+
+static void ref_fade(rgb_t *dst, size_t n, uint8_t f)
+{
+    for (size_t i = 0; i < n; i++)
+        dst[i] = rgb_fade(dst[i], f);
+}
+
+static void ref_add(rgb_t *dst, const rgb_t *src, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        dst[i] = rgb_add_rgb(dst[i], src[i]);
+}
+
+static void ref_blend(rgb_t *dst, const rgb_t *src, size_t n, fract8 a)
+{
+    for (size_t i = 0; i < n; i++)
+        dst[i] = rgb_blend(dst[i], src[i], a);
+}
+
+static void random_fill(rgb_t *p, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        p[i] = (rgb_t){ .r = rand(), .g = rand(), .b = rand() };
+}
+
+static bool check(const char *name, const rgb_t *ref, const rgb_t *got, size_t size, size_t n, int param)
+{
+    if (!memcmp(ref, got, size))
+        return true;
+    printf("%s: %zu pixels, parameter %d differs\n", name, n, param);
+    return false;
+}
+
+// Short arrays, unaligned starts, whole buffer compared to catch overruns
+static bool small_arrays()
+{
+    static rgb_t ref[SMALL_MAX + OFFSETS + 8], got[SMALL_MAX + OFFSETS + 8], src[SMALL_MAX + OFFSETS + 8];
+    bool ok = true;
+
+    for (size_t n = 0; n <= SMALL_MAX && ok; n++)
+        for (int off = 0; off < OFFSETS && ok; off++)
+            for (int k = 0; k < 256 && ok; k++)
+            {
+                rgb_t c = { .r = k, .g = 255 - k, .b = k * 7 };
+                random_fill(ref, sizeof(ref) / sizeof(rgb_t));
+                random_fill(src, sizeof(src) / sizeof(rgb_t));
+                memcpy(got, ref, sizeof(ref));
+
+                ref_fade(ref + off, n, k);
+                rgb_fade_array(got + off, n, k);
+                ok = check("fade", ref, got, sizeof(ref), n, k);
+                ref_add(ref + off, src + off, n);
+                rgb_add_array(got + off, src + off, n);
+                ok = ok && check("add", ref, got, sizeof(ref), n, k);
+                ref_blend(ref + off, src + off, n, k);
+                rgb_blend_array(got + off, src + off, n, k);
+                ok = ok && check("blend", ref, got, sizeof(ref), n, k);
+                ref_fill(ref + off, c, n);
+                rgb_fill_solid_rgb(got + off, c, n);
+                ok = ok && check("fill", ref, got, sizeof(ref), n, k);
+            }
+    return ok;
+}
+
+static bool all_pairs()
+{
+    rgb_t *x = malloc(PAIRS * sizeof(rgb_t)), *y = malloc(PAIRS * sizeof(rgb_t));
+    rgb_t *ref = malloc(PAIRS * sizeof(rgb_t)), *got = malloc(PAIRS * sizeof(rgb_t));
+    if (!x || !y || !ref || !got)
+    {
+        printf("out of memory\n");
+        exit(1);
+    }
+    // every (dst, src) byte pair appears in the red and green channels
+    for (int i = 0; i < PAIRS; i++)
+    {
+        x[i] = (rgb_t){ .r = i & 0xff, .g = i >> 8, .b = (i * 31) & 0xff };
+        y[i] = (rgb_t){ .r = i >> 8, .g = i & 0xff, .b = 255 - (i & 0xff) };
+    }
+
+    bool ok = true;
+    for (int k = 0; k < 256 && ok; k++)
+    {
+        memcpy(ref, x, PAIRS * sizeof(rgb_t));
+        memcpy(got, x, PAIRS * sizeof(rgb_t));
+        ref_blend(ref, y, PAIRS, k);
+        rgb_blend_array(got, y, PAIRS, k);
+        ok = check("blend, all pairs", ref, got, PAIRS * sizeof(rgb_t), PAIRS, k);
+
+        memcpy(ref, x, PAIRS * sizeof(rgb_t));
+        memcpy(got, x, PAIRS * sizeof(rgb_t));
+        ref_fade(ref, PAIRS, k);
+        rgb_fade_array(got, PAIRS, k);
+        ok = ok && check("fade, all pairs", ref, got, PAIRS * sizeof(rgb_t), PAIRS, k);
+    }
+    memcpy(ref, x, PAIRS * sizeof(rgb_t));
+    memcpy(got, x, PAIRS * sizeof(rgb_t));
+    ref_add(ref, y, PAIRS);
+    rgb_add_array(got, y, PAIRS);
+    ok = ok && check("add, all pairs", ref, got, PAIRS * sizeof(rgb_t), PAIRS, 0);
+
+    free(x);
+    free(y);
+    free(ref);
+    free(got);
+    return ok;
+}
+
+/* Speed */
+
+static rgb_t bench_dst[BENCH_MAX], bench_src[BENCH_MAX];
+
+// Keeps the compiler from dropping or merging the repeated calls
+#define CLOBBER() __asm__ volatile("" : : "r"(bench_dst) : "memory")
+
+#define BENCH(name, n, calls, REF, ARRAY) \
+    do { \
+        int64_t t0 = esp_timer_get_time(); \
+        for (uint32_t i = 0; i < (calls); i++) { REF; CLOBBER(); } \
+        int64_t t1 = esp_timer_get_time(); \
+        for (uint32_t i = 0; i < (calls); i++) { ARRAY; CLOBBER(); } \
+        int64_t t2 = esp_timer_get_time(); \
+        double r = (t1 - t0) * 1000.0 / (calls), a = (t2 - t1) * 1000.0 / (calls); \
+        printf("%5zu %-6s per pixel %8.0f ns, array %8.0f ns  x%.1f\n", (size_t)(n), name, r, a, r / a); \
+    } while (0)
+
+static void bench()
+{
+    static const size_t sizes[] = { 64, 256, BENCH_MAX };
+    rgb_t c = { .r = 1, .g = 2, .b = 3 };
+
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++)
+    {
+        size_t n = sizes[k];
+        uint32_t calls = 4000000 / n;
+        random_fill(bench_dst, n);
+        random_fill(bench_src, n);
+        BENCH("fill", n, calls, ref_fill(bench_dst, c, n), rgb_fill_solid_rgb(bench_dst, c, n));
+        BENCH("fade", n, calls, ref_fade(bench_dst, n, 1), rgb_fade_array(bench_dst, n, 1));
+        BENCH("add", n, calls, ref_add(bench_dst, bench_src, n), rgb_add_array(bench_dst, bench_src, n));
+        BENCH("blend", n, calls, ref_blend(bench_dst, bench_src, n, 100),
+                rgb_blend_array(bench_dst, bench_src, n, 100));
+    }
+}
+
+void app_main()
+{
+    bool ok = small_arrays();
+    ok = ok && all_pairs();
+    bench();
+
+    printf("fill/fade/add/blend arrays, %s kernels: %s\n", KERNELS, ok ? "bit-exact" : "MISMATCH");
+    fflush(stdout);
+    exit(ok ? 0 : 1);
+}
@@ -0,0 +1,147 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 deity
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * blur2d() with an xy_to_offs_cb mapper against the row-major path
+ * (xy == NULL) on matrices of several sizes, odd widths, 1xN and Nx1
+ * included:
+ *
+ * - for every 17th blur amount, three passes over random pixels must give
+ *   the same bytes both ways, with a row-major mapper and with a
+ *   serpentine one (odd rows reversed in memory);
+ * - then both paths are timed, BLUR_PIXELS (2000000) pixels per size.
+ *
+ * The mappers are in this file and blur2d() in color.c, so the callback
+ * is not inlined, as in an application.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_timer.h>
+#include <color.h>
+
+typedef struct
+{
+    size_t width;
+    size_t height;
+} matrix_t;
+
+static const matrix_t sizes[] = {
+    { 8, 8 }, { 16, 16 }, { 32, 8 }, { 64, 64 }, { 128, 32 }, { 200, 3 },
+    { 320, 240 }, { 7, 5 }, { 65, 3 }, { 1, 10 }, { 10, 1 }, { 67, 9 },
+};
+
+static size_t xy_rows(void *ctx, size_t x, size_t y)
+{
+    return y * ((const matrix_t *)ctx)->width + x;
+}
+
+static size_t xy_serpentine(void *ctx, size_t x, size_t y)
+{
+    size_t w = ((const matrix_t *)ctx)->width;
+    return y * w + (y & 1 ? w - 1 - x : x);
+}
+
+// Row-major copy of a serpentine matrix
+static void unwind(rgb_t *dst, const rgb_t *src, const matrix_t *m)
+{
+    for (size_t y = 0; y < m->height; y++)
+        for (size_t x = 0; x < m->width; x++)
+            dst[y * m->width + x] = src[xy_serpentine((void *)m, x, y)];
+}
+
+static bool exact(const matrix_t *m, rgb_t *a, rgb_t *b, rgb_t *c)
+{
+    size_t n = m->width * m->height;
+    for (int amount = 0; amount < 256; amount += 17)
+    {
+        for (size_t i = 0; i < n; i++)
+            a[i] = (rgb_t){ .r = rand(), .g = rand(), .b = rand() };
+        memcpy(b, a, n * sizeof(rgb_t));
+        // the same picture laid out as a serpentine
+        for (size_t y = 0; y < m->height; y++)
+            for (size_t x = 0; x < m->width; x++)
+                c[xy_serpentine((void *)m, x, y)] = a[y * m->width + x];
+
+        for (int pass = 0; pass < 3; pass++)
+        {
+            blur2d(a, m->width, m->height, amount, xy_rows, (void *)m);
+            blur2d(b, m->width, m->height, amount, NULL, NULL);
+            blur2d(c, m->width, m->height, amount, xy_serpentine, (void *)m);
+        }
+        if (memcmp(a, b, n * sizeof(rgb_t)))
+        {
+            printf("%zux%zu, amount %d: row-major mapper differs\n", m->width, m->height, amount);
+            return false;
+        }
+        unwind(a, c, m);
+        if (memcmp(a, b, n * sizeof(rgb_t)))
+        {
+            printf("%zux%zu, amount %d: serpentine mapper differs\n", m->width, m->height, amount);
+            return false;
+        }
+    }
+    return true;
+}
+
+static double ns_per_call(rgb_t *buf, const matrix_t *m, xy_to_offs_cb xy, uint32_t calls)
+{
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < calls; i++)
+        blur2d(buf, m->width, m->height, 64, xy, (void *)m);
+    return (esp_timer_get_time() - start) * 1000.0 / calls;
+}
+
+void app_main()
+{
+    const char *env = getenv("BLUR_PIXELS");
+    uint32_t pixels = env ? (uint32_t)atoi(env) : 2000000;
+    bool ok = true;
+
+    printf("size      callback       row-major\n");
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++)
+    {
+        const matrix_t *m = &sizes[k];
+        size_t n = m->width * m->height;
+        rgb_t *a = malloc(n * sizeof(rgb_t)), *b = malloc(n * sizeof(rgb_t)), *c = malloc(n * sizeof(rgb_t));
+        if (!a || !b || !c)
+        {
+            printf("out of memory\n");
+            exit(1);
+        }
+
+        ok = exact(m, a, b, c) && ok;
+        uint32_t calls = pixels / n + 10;
+        double cb = ns_per_call(a, m, xy_rows, calls);
+        double linear = ns_per_call(b, m, NULL, calls);
+        printf("%3zux%-4zu %9.0f ns %11.0f ns  x%.1f\n", m->width, m->height, cb, linear, cb / linear);
+
+        free(a);
+        free(b);
+        free(c);
+    }
+    printf("%zu sizes, 16 amounts, row-major and serpentine mappers: %s\n", sizeof(sizes) / sizeof(sizes[0]),
+            ok ? "bit-exact" : "MISMATCH");
+    fflush(stdout);
+    exit(ok ? 0 : 1);
+}
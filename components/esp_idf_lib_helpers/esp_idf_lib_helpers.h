@@ -57,6 +57,12 @@
  */
 #elif defined(CONFIG_IDF_TARGET_ESP8266)
 #define HELPER_TARGET_IS_ESP8266   (1)
+
+/* HELPER_TARGET_IS_LINUX
+ * 1 when building for the host (linux target)
+ */
+#elif defined(CONFIG_IDF_TARGET_LINUX)
+#define HELPER_TARGET_IS_LINUX     (1)
 #else
 #error BUG: cannot determine the target
 #endif
@@ -0,0 +1,426 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 deity
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file fbdraw.c
+ *
+ * Drawing primitives for framebuffer
+ *
+ * Copyright (c) 2026 deity
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <stddef.h>
+#include "fbdraw.h"
+
+#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
+
+// Shorter runs are filled pixel by pixel, longer ones by doubling memcpy()
+#define FILL_MEMCPY_MIN 16
+
+static void fill_span(rgb_t *p, size_t n, rgb_t color)
+{
+    if (n < FILL_MEMCPY_MIN)
+    {
+        while (n--)
+            *p++ = color;
+        return;
+    }
+    p[0] = color;
+    for (size_t done = 1; done < n;)
+    {
+        size_t k = done < n - done ? done : n - done;
+        memcpy(p + done, p, k * sizeof(rgb_t));
+        done += k;
+    }
+}
+
+// Clips rectangle to the frame, false if nothing is left
+static bool clip(const framebuffer_t *fb, int *x, int *y, int *w, int *h)
+{
+    if (*w <= 0 || *h <= 0)
+        return false;
+
+    int64_t x0 = *x, y0 = *y, x1 = x0 + *w, y1 = y0 + *h;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > (int64_t)fb->width) x1 = fb->width;
+    if (y1 > (int64_t)fb->height) y1 = fb->height;
+    if (x0 >= x1 || y0 >= y1)
+        return false;
+
+    *x = x0;
+    *y = y0;
+    *w = x1 - x0;
+    *h = y1 - y0;
+    return true;
+}
+
+static inline bool inside(const framebuffer_t *fb, int x, int y)
+{
+    return (unsigned)x < fb->width && (unsigned)y < fb->height;
+}
+
+// Bounding box of a shape, clipped, to the damage tracking
+static void damage(framebuffer_t *fb, int x, int y, int w, int h)
+{
+    if (clip(fb, &x, &y, &w, &h))
+        fb_damage(fb, x, y, w, h);
+}
+
+esp_err_t fb_fill_rect(framebuffer_t *fb, int x, int y, int w, int h, rgb_t color)
+{
+    CHECK_ARG(fb && fb->data);
+
+    if (!clip(fb, &x, &y, &w, &h))
+        return ESP_OK;
+
+    rgb_t *row = fb->data + FB_OFFSET(fb, x, y);
+    fill_span(row, w, color);
+    for (int i = 1; i < h; i++)
+        memcpy(row + i * fb->width, row, w * sizeof(rgb_t));
+    fb_damage(fb, x, y, w, h);
+
+    return ESP_OK;
+}
+
+esp_err_t fb_draw_hline(framebuffer_t *fb, int x, int y, int w, rgb_t color)
+{
+    return fb_fill_rect(fb, x, y, w, 1, color);
+}
+
+esp_err_t fb_draw_vline(framebuffer_t *fb, int x, int y, int h, rgb_t color)
+{
+    CHECK_ARG(fb && fb->data);
+
+    int w = 1;
+    if (!clip(fb, &x, &y, &w, &h))
+        return ESP_OK;
+
+    rgb_t *p = fb->data + FB_OFFSET(fb, x, y);
+    for (int i = 0; i < h; i++, p += fb->width)
+        *p = color;
+    fb_damage(fb, x, y, 1, h);
+
+    return ESP_OK;
+}
+
+esp_err_t fb_draw_rect(framebuffer_t *fb, int x, int y, int w, int h, rgb_t color)
+{
+    CHECK_ARG(fb && fb->data);
+
+    if (w <= 0 || h <= 0)
+        return ESP_OK;
+
+    fb_draw_hline(fb, x, y, w, color);
+    if (h > 1)
+        fb_draw_hline(fb, x, y + h - 1, w, color);
+    if (h > 2)
+    {
+        fb_draw_vline(fb, x, y + 1, h - 2, color);
+        if (w > 1)
+            fb_draw_vline(fb, x + w - 1, y + 1, h - 2, color);
+    }
+
+    return ESP_OK;
+}
+
+// Bresenham line with major axis delta da >= minor delta db > 0: minor steps
+// taken after i major steps. Same rounding as the error term in
+// fb_draw_line(), the remainder of the division gives that error term.
+static uint64_t minor_steps(uint64_t i, uint64_t da, uint64_t db, uint64_t *rem)
+{
+    uint64_t q = i * db + (da - 1) / 2;
+    *rem = q % da;
+    return q / da;
+}
+
+// First major step at which m <= db minor steps have been taken
+static uint64_t first_step(uint64_t m, uint64_t da, uint64_t db)
+{
+    uint64_t h = (da - 1) / 2;
+    return m * da <= h ? 0 : (m * da - h + db - 1) / db;
+}
+
+// Steps i in [0, n] at which p + s * i is in [0, size), false if none
+static bool axis_steps(int p, int s, int64_t n, int size, int64_t *lo, int64_t *hi)
+{
+    *lo = s > 0 ? -(int64_t)p : (int64_t)p - (size - 1);
+    *hi = s > 0 ? (int64_t)size - 1 - p : p;
+    if (*lo < 0) *lo = 0;
+    if (*hi > n) *hi = n;
+    return *lo <= *hi;
+}
+
+static int clamp(int v, int lo, int hi)
+{
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+esp_err_t fb_draw_line(framebuffer_t *fb, int x0, int y0, int x1, int y1, rgb_t color)
+{
+    CHECK_ARG(fb && fb->data);
+
+    if (y0 == y1 || x0 == x1)
+    {
+        // one pixel off the frame is enough, and the length then fits in int
+        x0 = clamp(x0, -1, fb->width);
+        x1 = clamp(x1, -1, fb->width);
+        y0 = clamp(y0, -1, fb->height);
+        y1 = clamp(y1, -1, fb->height);
+        if (y0 == y1)
+            return fb_fill_rect(fb, x0 < x1 ? x0 : x1, y0, abs(x1 - x0) + 1, 1, color);
+        return fb_draw_vline(fb, x0, y0 < y1 ? y0 : y1, abs(y1 - y0) + 1, color);
+    }
+
+    int64_t dx = llabs((int64_t)x1 - x0), dy = llabs((int64_t)y1 - y0);
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+
+    // Clip to the steps along the major axis at which both coordinates are
+    // in the frame, then start the loop there with its error term, so far
+    // off endpoints cost nothing
+    bool xmajor = dx >= dy;
+    int64_t da = xmajor ? dx : dy, db = xmajor ? dy : dx;
+    int64_t lo, hi, mlo, mhi;
+    if (!axis_steps(xmajor ? x0 : y0, xmajor ? sx : sy, da, xmajor ? fb->width : fb->height, &lo, &hi)
+            || !axis_steps(xmajor ? y0 : x0, xmajor ? sy : sx, db, xmajor ? fb->height : fb->width, &mlo, &mhi))
+        return ESP_OK;
+    int64_t first = first_step(mlo, da, db);
+    int64_t last = mhi < db ? (int64_t)first_step(mhi + 1, da, db) - 1 : da;
+    if (lo < first) lo = first;
+    if (hi > last) hi = last;
+    if (lo > hi)
+        return ESP_OK;
+
+    uint64_t rem, rem_end;
+    int64_t m = minor_steps(lo, da, db, &rem);
+    int64_t m_end = minor_steps(hi, da, db, &rem_end);
+    int64_t err = da - db + (da - 1) / 2 - (int64_t)rem;
+    if (!xmajor)
+        err = -err;
+    int xs = x0 + sx * (xmajor ? lo : m), ys = y0 + sy * (xmajor ? m : lo);
+    int xe = x0 + sx * (xmajor ? hi : m_end), ye = y0 + sy * (xmajor ? m_end : hi);
+
+    rgb_t *p = fb->data + FB_OFFSET(fb, xs, ys);
+    ptrdiff_t row = sy * (ptrdiff_t)fb->width;
+    for (int64_t n = hi - lo; ; n--)
+    {
+        *p = color;
+        if (!n) break;
+        int64_t e2 = 2 * err;
+        if (e2 > -dy)
+        {
+            err -= dy;
+            p += sx;
+        }
+        if (e2 < dx)
+        {
+            err += dx;
+            p += row;
+        }
+    }
+    fb_damage(fb, xs < xe ? xs : xe, ys < ye ? ys : ye, abs(xe - xs) + 1, abs(ye - ys) + 1);
+
+    return ESP_OK;
+}
+
+esp_err_t fb_draw_circle(framebuffer_t *fb, int cx, int cy, int r, rgb_t color)
+{
+    CHECK_ARG(fb && fb->data && r >= 0);
+
+    int bx = cx - r, by = cy - r, bw = 2 * r + 1, bh = 2 * r + 1;
+    if (!clip(fb, &bx, &by, &bw, &bh))
+        return ESP_OK;
+    bool whole = bw == 2 * r + 1 && bh == 2 * r + 1;
+
+    int x = r, y = 0, err = 1 - r;
+    while (x >= y)
+    {
+        const int px[8] = { cx + x, cx - x, cx + x, cx - x, cx + y, cx - y, cx + y, cx - y };
+        const int py[8] = { cy + y, cy + y, cy - y, cy - y, cy + x, cy + x, cy - x, cy - x };
+        for (int i = 0; i < 8; i++)
+        {
+            if (whole || inside(fb, px[i], py[i]))
+                fb->data[FB_OFFSET(fb, px[i], py[i])] = color;
+        }
+        y++;
+        if (err < 0)
+            err += 2 * y + 1;
+        else
+        {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+    fb_damage(fb, bx, by, bw, bh);
+
+    return ESP_OK;
+}
+
+// Clipped span without damage reporting, see fb_fill_circle()
+static void span(framebuffer_t *fb, int x, int y, int w, rgb_t color)
+{
+    int h = 1;
+    if (clip(fb, &x, &y, &w, &h))
+        fill_span(fb->data + FB_OFFSET(fb, x, y), w, color);
+}
+
+esp_err_t fb_fill_circle(framebuffer_t *fb, int cx, int cy, int r, rgb_t color)
+{
+    CHECK_ARG(fb && fb->data && r >= 0);
+
+    int x = r, y = 0, err = 1 - r;
+    // same outline as fb_draw_circle(): a span per row, drawn when it is final
+    while (x >= y)
+    {
+        span(fb, cx - x, cy + y, 2 * x + 1, color);
+        if (y)
+            span(fb, cx - x, cy - y, 2 * x + 1, color);
+        y++;
+        if (err < 0)
+            err += 2 * y + 1;
+        else
+        {
+            if (x >= y)
+            {
+                span(fb, cx - y + 1, cy + x, 2 * y - 1, color);
+                span(fb, cx - y + 1, cy - x, 2 * y - 1, color);
+            }
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+    damage(fb, cx - r, cy - r, 2 * r + 1, 2 * r + 1);
+
+    return ESP_OK;
+}
+
+// Clips the destination of a blit, (sx, sy) is where it starts in the image
+static bool clip_blit(const framebuffer_t *fb, int *x, int *y, size_t w, size_t h, int *cw, int *ch,
+        size_t *sx, size_t *sy)
+{
+    if (w > INT_MAX || h > INT_MAX)
+        return false;
+
+    int x0 = *x, y0 = *y;
+    *cw = w;
+    *ch = h;
+    if (!clip(fb, x, y, cw, ch))
+        return false;
+    *sx = *x - x0;
+    *sy = *y - y0;
+    return true;
+}
+
+esp_err_t fb_blit(framebuffer_t *fb, int x, int y, const rgb_t *src, size_t w, size_t h, size_t stride)
+{
+    CHECK_ARG(fb && fb->data && src);
+
+    int cw, ch;
+    size_t sx, sy;
+    if (!stride) stride = w;
+    if (!clip_blit(fb, &x, &y, w, h, &cw, &ch, &sx, &sy))
+        return ESP_OK;
+
+    rgb_t *dst = fb->data + FB_OFFSET(fb, x, y);
+    src += sy * stride + sx;
+    for (int i = 0; i < ch; i++, dst += fb->width, src += stride)
+        memcpy(dst, src, cw * sizeof(rgb_t));
+    fb_damage(fb, x, y, cw, ch);
+
+    return ESP_OK;
+}
+
+esp_err_t fb_blit_key(framebuffer_t *fb, int x, int y, const rgb_t *src, size_t w, size_t h, size_t stride,
+        rgb_t key)
+{
+    CHECK_ARG(fb && fb->data && src);
+
+    int cw, ch;
+    size_t sx, sy;
+    if (!stride) stride = w;
+    if (!clip_blit(fb, &x, &y, w, h, &cw, &ch, &sx, &sy))
+        return ESP_OK;
+
+    rgb_t *dst = fb->data + FB_OFFSET(fb, x, y);
+    src += sy * stride + sx;
+    for (int i = 0; i < ch; i++, dst += fb->width, src += stride)
+        for (int j = 0; j < cw; j++)
+        {
+            rgb_t c = src[j];
+            if (c.r != key.r || c.g != key.g || c.b != key.b)
+                dst[j] = c;
+        }
+    fb_damage(fb, x, y, cw, ch);
+
+    return ESP_OK;
+}
+
+esp_err_t fb_blit_alpha(framebuffer_t *fb, int x, int y, const rgb_t *src, const uint8_t *alpha,
+        size_t w, size_t h, size_t stride, uint8_t opacity)
+{
+    CHECK_ARG(fb && fb->data && src);
+
+    int cw, ch;
+    size_t sx, sy;
+    if (!stride) stride = w;
+    if (!opacity || !clip_blit(fb, &x, &y, w, h, &cw, &ch, &sx, &sy))
+        return ESP_OK;
+
+    rgb_t *dst = fb->data + FB_OFFSET(fb, x, y);
+    size_t offs = sy * stride + sx;
+    src += offs;
+    if (!alpha)
+    {
+        for (int i = 0; i < ch; i++, dst += fb->width, src += stride)
+        {
+            if (opacity == 255)
+                memcpy(dst, src, cw * sizeof(rgb_t));
+            else
+                rgb_blend_array(dst, src, cw, opacity);
+        }
+        fb_damage(fb, x, y, cw, ch);
+        return ESP_OK;
+    }
+
+    alpha += offs;
+    for (int i = 0; i < ch; i++, dst += fb->width, src += stride)
+    {
+        for (int j = 0; j < cw; j++)
+        {
+            uint8_t a = scale8(alpha[j], opacity);
+            if (a == 255)
+                dst[j] = src[j];
+            else if (a)
+                dst[j] = rgb_blend(dst[j], src[j], a);
+        }
+        alpha += stride;
+    }
+    fb_damage(fb, x, y, cw, ch);
+
+    return ESP_OK;
+}
@@ -0,0 +1,193 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 deity
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file fbdraw.h
+ * @defgroup fbdraw fbdraw
+ * @{
+ *
+ * Drawing primitives for framebuffer
+ *
+ * Every primitive is clipped to the framebuffer once and then writes
+ * `rgb_t` rows directly. Coordinates are signed: shapes may lie partly
+ * or completely outside of the frame. Changed area is reported to the
+ * damage tracking, see ::fb_set_render_partial().
+ *
+ * Copyright (c) 2026 deity
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __FBDRAW_H__
+#define __FBDRAW_H__
+
+#include "framebuffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Draw horizontal line
+ *
+ * @param fb        Framebuffer descriptor
+ * @param x         Left column
+ * @param y         Row
+ * @param w         Length in pixels
+ * @param color     RGB color
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_draw_hline(framebuffer_t *fb, int x, int y, int w, rgb_t color);
+
+/**
+ * @brief Draw vertical line
+ *
+ * @param fb        Framebuffer descriptor
+ * @param x         Column
+ * @param y         Top row
+ * @param h         Length in pixels
+ * @param color     RGB color
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_draw_vline(framebuffer_t *fb, int x, int y, int h, rgb_t color);
+
+/**
+ * @brief Draw line between two points, ends included (Bresenham)
+ *
+ * @param fb        Framebuffer descriptor
+ * @param x0        X coordinate of the first point
+ * @param y0        Y coordinate of the first point
+ * @param x1        X coordinate of the second point
+ * @param y1        Y coordinate of the second point
+ * @param color     RGB color
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_draw_line(framebuffer_t *fb, int x0, int y0, int x1, int y1, rgb_t color);
+
+/**
+ * @brief Draw rectangle outline
+ *
+ * @param fb        Framebuffer descriptor
+ * @param x         Left column
+ * @param y         Top row
+ * @param w         Width in pixels
+ * @param h         Height in pixels
+ * @param color     RGB color
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_draw_rect(framebuffer_t *fb, int x, int y, int w, int h, rgb_t color);
+
+/**
+ * @brief Fill rectangle
+ *
+ * @param fb        Framebuffer descriptor
+ * @param x         Left column
+ * @param y         Top row
+ * @param w         Width in pixels
+ * @param h         Height in pixels
+ * @param color     RGB color
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_fill_rect(framebuffer_t *fb, int x, int y, int w, int h, rgb_t color);
+
+/**
+ * @brief Draw circle outline (midpoint algorithm)
+ *
+ * @param fb        Framebuffer descriptor
+ * @param cx        X coordinate of the center
+ * @param cy        Y coordinate of the center
+ * @param r         Radius in pixels
+ * @param color     RGB color
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_draw_circle(framebuffer_t *fb, int cx, int cy, int r, rgb_t color);
+
+/**
+ * @brief Fill circle
+ *
+ * @param fb        Framebuffer descriptor
+ * @param cx        X coordinate of the center
+ * @param cy        Y coordinate of the center
+ * @param r         Radius in pixels
+ * @param color     RGB color
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_fill_circle(framebuffer_t *fb, int cx, int cy, int r, rgb_t color);
+
+/**
+ * @brief Copy image to framebuffer
+ *
+ * @param fb        Framebuffer descriptor
+ * @param x         Left column of the destination
+ * @param y         Top row of the destination
+ * @param src       Image pixels
+ * @param w         Image width
+ * @param h         Image height
+ * @param stride    Pixels between image rows, 0 for \p w
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_blit(framebuffer_t *fb, int x, int y, const rgb_t *src, size_t w, size_t h, size_t stride);
+
+/**
+ * @brief Copy image to framebuffer, except pixels of the key color
+ *
+ * @param fb        Framebuffer descriptor
+ * @param x         Left column of the destination
+ * @param y         Top row of the destination
+ * @param src       Image pixels
+ * @param w         Image width
+ * @param h         Image height
+ * @param stride    Pixels between image rows, 0 for \p w
+ * @param key       Transparent color
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_blit_key(framebuffer_t *fb, int x, int y, const rgb_t *src, size_t w, size_t h, size_t stride,
+        rgb_t key);
+
+/**
+ * @brief Blend image over framebuffer
+ *
+ * Pixel weight is `scale8(alpha[i], opacity)`: 0 keeps the framebuffer
+ * pixel, 255 replaces it.
+ *
+ * @param fb        Framebuffer descriptor
+ * @param x         Left column of the destination
+ * @param y         Top row of the destination
+ * @param src       Image pixels
+ * @param alpha     Alpha of every image pixel, same layout as \p src, or
+ *                  NULL for \p opacity only
+ * @param w         Image width
+ * @param h         Image height
+ * @param stride    Pixels between image rows, 0 for \p w
+ * @param opacity   Opacity of the whole image
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_blit_alpha(framebuffer_t *fb, int x, int y, const rgb_t *src, const uint8_t *alpha,
+        size_t w, size_t h, size_t stride, uint8_t opacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __FBDRAW_H__ */
@@ -31,15 +31,83 @@
  * MIT Licensed as described in the file LICENSE
  */
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include "framebuffer.h"
 
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
 #define CHECK(x) do { esp_err_t __; if ((__ = (x)) != ESP_OK) return __; } while (0)
 
-static size_t xy(void *ctx, size_t x, size_t y)
+// Flag in fb_triple_s::ready: that frame is not rendered yet
+#define FB_FRESH 4
+
+struct fb_triple_s
+{
+    rgb_t *buf[3];
+    atomic_uint ready;                      ///< Newest complete frame, index | FB_FRESH
+    unsigned draw;                          ///< Index of the drawing task's buffer
+    unsigned front;                         ///< Index of the rendering task's buffer
+    bool full;                              ///< Render the next frame in full
+    fb_rect_t damage[3][FB_DAMAGE_MAX];     ///< Damage published with each buffer
+    size_t damage_count[3];
+    fb_rect_t carry[FB_DAMAGE_MAX];         ///< Damage the renderer may not have seen yet
+    size_t carry_count;
+};
+
+static void rect_union(fb_rect_t *a, const fb_rect_t *b)
 {
-    framebuffer_t *fb = (framebuffer_t *)ctx;
-    return y * fb->width + x;
+    size_t x1 = a->x + a->w > b->x + b->w ? a->x + a->w : b->x + b->w;
+    size_t y1 = a->y + a->h > b->y + b->h ? a->y + a->h : b->y + b->h;
+    a->x = a->x < b->x ? a->x : b->x;
+    a->y = a->y < b->y ? a->y : b->y;
+    a->w = x1 - a->x;
+    a->h = y1 - a->y;
+}
+
+static void rect_list_add(fb_rect_t *list, size_t *count, const fb_rect_t *r)
+{
+    size_t best = 0, best_growth = SIZE_MAX;
+    for (size_t i = 0; i < *count; i++)
+    {
+        fb_rect_t u = list[i];
+        rect_union(&u, r);
+        size_t growth = u.w * u.h - list[i].w * list[i].h;
+        // merged rectangle costs no more pixels than a separate one
+        if (growth <= r->w * r->h)
+        {
+            list[i] = u;
+            return;
+        }
+        if (growth < best_growth)
+        {
+            best_growth = growth;
+            best = i;
+        }
+    }
+    if (*count < FB_DAMAGE_MAX)
+        list[(*count)++] = *r;
+    else
+        rect_union(&list[best], r);
+}
+
+static void damage_add(framebuffer_t *fb, size_t x, size_t y, size_t w, size_t h)
+{
+    if (!fb->render_partial || x >= fb->width || y >= fb->height || !w || !h)
+        return;
+    if (w > fb->width - x)
+        w = fb->width - x;
+    if (h > fb->height - y)
+        h = fb->height - y;
+
+    fb_rect_t r = { x, y, w, h };
+    rect_list_add(fb->damage, &fb->damage_count, &r);
+}
+
+static void damage_all(framebuffer_t *fb)
+{
+    fb->damage_count = 0;
+    damage_add(fb, 0, 0, fb->width, fb->height);
 }
 
 esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t render_cb)
@@ -51,6 +119,11 @@ esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t
     fb->frame_num = 0;
     fb->last_frame_us = 0;
     fb->render = render_cb;
+    fb->render_partial = NULL;
+    fb->damage_count = 0;
+    fb->frames_dropped = 0;
+    fb->frames_duplicated = 0;
+    fb->triple = NULL;
     fb->internal = NULL;
     fb->mutex = xSemaphoreCreateMutex();
     if (!fb->mutex)
@@ -58,6 +131,7 @@ esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t
     fb->data = calloc(1, FB_SIZE(fb));
     if (!fb->data)
         return ESP_ERR_NO_MEM;
+    fb->front = fb->data;
 
     return ESP_OK;
 }
@@ -66,24 +140,167 @@ esp_err_t fb_free(framebuffer_t *fb)
 {
     CHECK_ARG(fb);
 
-    if (fb->data)
+    if (fb->triple)
+    {
+        // data is one of the three buffers
+        for (int i = 0; i < 3; i++)
+            free(fb->triple->buf[i]);
+        free(fb->triple);
+        fb->triple = NULL;
+    }
+    else if (fb->data)
         free(fb->data);
+    fb->data = fb->front = NULL;
     if (fb->mutex)
         vSemaphoreDelete(fb->mutex);
 
     return ESP_OK;
 }
 
+esp_err_t fb_enable_triple_buffering(framebuffer_t *fb)
+{
+    CHECK_ARG(fb && fb->data);
+
+    if (fb->triple)
+        return ESP_OK;
+
+    struct fb_triple_s *t = calloc(1, sizeof(*t));
+    if (!t)
+        return ESP_ERR_NO_MEM;
+    t->buf[0] = fb->data;
+    for (int i = 1; i < 3; i++)
+    {
+        t->buf[i] = malloc(FB_SIZE(fb));
+        if (!t->buf[i])
+        {
+            free(t->buf[1]);
+            free(t);
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(t->buf[i], fb->data, FB_SIZE(fb));
+    }
+    t->draw = 0;
+    t->front = 1;
+    atomic_init(&t->ready, 2);
+    t->full = true;
+
+    fb->front = t->buf[t->front];
+    fb->triple = t;
+
+    return ESP_OK;
+}
+
+esp_err_t fb_set_render_partial(framebuffer_t *fb, fb_render_partial_cb_t render_cb)
+{
+    CHECK_ARG(fb);
+
+    fb->render_partial = render_cb;
+    damage_all(fb);
+    if (fb->triple)
+        fb->triple->full = true;
+
+    return ESP_OK;
+}
+
+esp_err_t fb_damage(framebuffer_t *fb, size_t x, size_t y, size_t w, size_t h)
+{
+    CHECK_ARG(fb);
+
+    damage_add(fb, x, y, w, h);
+
+    return ESP_OK;
+}
+
+// Called by the rendering task only
+static esp_err_t triple_render(framebuffer_t *fb, void *render_ctx)
+{
+    struct fb_triple_s *t = fb->triple;
+
+    bool fresh = atomic_load_explicit(&t->ready, memory_order_acquire) & FB_FRESH;
+    if (fresh)
+    {
+        // only the drawing task sets FB_FRESH, the newest frame is still there
+        unsigned newest = atomic_exchange_explicit(&t->ready, t->front, memory_order_acq_rel);
+        t->front = newest & 3;
+        fb->front = t->buf[t->front];
+    }
+    else
+        fb->frames_duplicated++;
+
+    if (!fb->render_partial)
+        return fb->render(fb, render_ctx);
+    if (!fresh && !t->full)
+        return ESP_OK;
+
+    const fb_rect_t all = { 0, 0, fb->width, fb->height };
+    esp_err_t res = t->full
+        ? fb->render_partial(fb, &all, 1, render_ctx)
+        : fb->render_partial(fb, t->damage[t->front], t->damage_count[t->front], render_ctx);
+    // the damage of a failed frame is lost with it
+    t->full = res != ESP_OK;
+
+    return res;
+}
+
+// Called by the drawing task only, from fb_end()
+static void triple_publish(framebuffer_t *fb)
+{
+    struct fb_triple_s *t = fb->triple;
+    unsigned idx = t->draw;
+
+    if (fb->render_partial)
+    {
+        // this frame's changes and those of frames the renderer may have missed
+        memcpy(t->damage[idx], t->carry, t->carry_count * sizeof(fb_rect_t));
+        t->damage_count[idx] = t->carry_count;
+        for (size_t i = 0; i < fb->damage_count; i++)
+            rect_list_add(t->damage[idx], &t->damage_count[idx], &fb->damage[i]);
+    }
+
+    unsigned prev = atomic_exchange_explicit(&t->ready, idx | FB_FRESH, memory_order_acq_rel);
+    if (prev & FB_FRESH)
+    {
+        // previous frame was never rendered: its changes go on with the next one
+        fb->frames_dropped++;
+        memcpy(t->carry, t->damage[idx], t->damage_count[idx] * sizeof(fb_rect_t));
+        t->carry_count = t->damage_count[idx];
+    }
+    else
+    {
+        memcpy(t->carry, fb->damage, fb->damage_count * sizeof(fb_rect_t));
+        t->carry_count = fb->damage_count;
+    }
+    fb->damage_count = 0;
+
+    // drawing goes on from the frame just published
+    t->draw = prev & 3;
+    memcpy(t->buf[t->draw], t->buf[idx], FB_SIZE(fb));
+    fb->data = t->buf[t->draw];
+}
+
 esp_err_t fb_render(framebuffer_t *fb, void *render_ctx)
 {
     CHECK_ARG(fb && fb->data && fb->render);
 
+    if (fb->triple)
+        return triple_render(fb, render_ctx);
+
     if (xSemaphoreTake(fb->mutex, 0) != pdTRUE)
         return ESP_ERR_INVALID_STATE;
-    CHECK(fb->render(fb, render_ctx));
+
+    esp_err_t res = ESP_OK;
+    if (!fb->render_partial)
+        res = fb->render(fb, render_ctx);
+    else if (fb->damage_count)
+    {
+        res = fb->render_partial(fb, fb->damage, fb->damage_count, render_ctx);
+        // on error the damage stays and is rendered with the next frame
+        if (res == ESP_OK)
+            fb->damage_count = 0;
+    }
     xSemaphoreGive(fb->mutex);
 
-    return ESP_OK;
+    return res;
 }
 
 esp_err_t fb_set_pixel_rgb(framebuffer_t *fb, size_t x, size_t y, rgb_t color)
@@ -91,17 +308,14 @@ esp_err_t fb_set_pixel_rgb(framebuffer_t *fb, size_t x, size_t y, rgb_t color)
     CHECK_ARG(fb && fb->data && x < fb->width && y < fb->height);
 
     fb->data[FB_OFFSET(fb, x, y)] = color;
+    damage_add(fb, x, y, 1, 1);
 
     return ESP_OK;
 }
 
 esp_err_t fb_set_pixel_hsv(framebuffer_t *fb, size_t x, size_t y, hsv_t color)
 {
-    CHECK_ARG(fb && fb->data && x < fb->width && y < fb->height);
-
-    fb->data[FB_OFFSET(fb, x, y)] = hsv2rgb_rainbow(color);
-
-    return ESP_OK;
+    return fb_set_pixel_rgb(fb, x, y, hsv2rgb_rainbow(color));
 }
 
 esp_err_t fb_get_pixel_rgb(framebuffer_t *fb, size_t x, size_t y, rgb_t *color)
@@ -167,6 +381,7 @@ esp_err_t fb_clear(framebuffer_t *fb)
     CHECK_ARG(fb && fb->data);
 
     memset(fb->data, 0, FB_SIZE(fb));
+    damage_all(fb);
 
     return ESP_OK;
 }
@@ -204,6 +419,7 @@ esp_err_t fb_shift(framebuffer_t *fb, size_t offs, fb_shift_direction_t dir)
                     FB_SIZE(fb) - offs * fb->width * sizeof(rgb_t));
             break;
     }
+    damage_all(fb);
 
     return ESP_OK;
 }
@@ -212,8 +428,38 @@ esp_err_t fb_fade(framebuffer_t *fb, uint8_t scale)
 {
     CHECK_ARG(fb && fb->data);
 
-    for (size_t i = 0; i < fb->width * fb->height; i++)
-        fb->data[i] = rgb_fade(fb->data[i], scale);
+    if (!fb->render_partial)
+    {
+        rgb_fade_array(fb->data, fb->width * fb->height, scale);
+        return ESP_OK;
+    }
+    if (!scale)
+        return ESP_OK;
+
+    // only the bounding box of changed pixels: any nonzero channel fades,
+    // black pixels stay black
+    size_t x0 = fb->width, y0 = fb->height, x1 = 0, y1 = 0;
+    size_t pitch = fb->width * sizeof(rgb_t);
+    for (size_t y = 0; y < fb->height; y++)
+    {
+        const uint8_t *row = (const uint8_t *)(fb->data + FB_OFFSET(fb, 0, y));
+        size_t first = 0, last = pitch;
+        while (first < pitch && !row[first])
+            first++;
+        if (first == pitch)
+            continue;
+        while (!row[last - 1])
+            last--;
+
+        size_t l = first / sizeof(rgb_t), r = (last - 1) / sizeof(rgb_t);
+        rgb_fade_array(fb->data + FB_OFFSET(fb, l, y), r - l + 1, scale);
+        if (l < x0) x0 = l;
+        if (r > x1) x1 = r;
+        if (y < y0) y0 = y;
+        y1 = y;
+    }
+    if (x0 <= x1 && y0 <= y1)
+        damage_add(fb, x0, y0, x1 - x0 + 1, y1 - y0 + 1);
 
     return ESP_OK;
 }
@@ -222,7 +468,9 @@ esp_err_t fb_blur2d(framebuffer_t *fb, fract8 amount)
 {
     CHECK_ARG(fb && fb->data);
 
-    blur2d(fb->data, fb->width, fb->height, amount, xy, fb);
+    // framebuffer is row-major, no need for the xy mapper
+    blur2d(fb->data, fb->width, fb->height, amount, NULL, NULL);
+    damage_all(fb);
 
     return ESP_OK;
 }
@@ -231,6 +479,10 @@ esp_err_t fb_begin(framebuffer_t *fb)
 {
     CHECK_ARG(fb);
 
+    // the drawing task owns its buffer
+    if (fb->triple)
+        return ESP_OK;
+
     if (xSemaphoreTake(fb->mutex, 0) != pdTRUE)
         return ESP_ERR_INVALID_STATE;
 
@@ -243,7 +495,10 @@ esp_err_t fb_end(framebuffer_t *fb)
 
     fb->frame_num++;
     fb->last_frame_us = esp_timer_get_time();
-    xSemaphoreGive(fb->mutex);
+    if (fb->triple)
+        triple_publish(fb);
+    else
+        xSemaphoreGive(fb->mutex);
 
     return ESP_OK;
 }
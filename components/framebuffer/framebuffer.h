@@ -48,6 +48,14 @@ extern "C" {
 
 #define FB_SIZE(fb) ((fb)->width * (fb)->height * sizeof(rgb_t))
 
+#ifndef FB_DAMAGE_MAX
+/**
+ * Damaged rectangles kept per frame. When the list is full, new damage is
+ * merged into the rectangle that grows the least.
+ */
+#define FB_DAMAGE_MAX 8
+#endif
+
 typedef enum {
     FB_SHIFT_LEFT  = 0,
     FB_SHIFT_RIGHT,
@@ -57,11 +65,32 @@ typedef enum {
 
 typedef struct framebuffer_s framebuffer_t;
 
+/**
+ * Rectangle of framebuffer pixels
+ */
+typedef struct
+{
+    size_t x;                      ///< Left column
+    size_t y;                      ///< Top row
+    size_t w;                      ///< Width in pixels
+    size_t h;                      ///< Height in pixels
+} fb_rect_t;
+
 /**
  * Renderer callback prototype
+ *
+ * Renderer reads the frame from `fb->front`.
  */
 typedef esp_err_t (*fb_render_cb_t)(framebuffer_t *fb, void *arg);
 
+/**
+ * Partial renderer callback prototype
+ *
+ * Receives the rectangles changed since the previous frame. They may
+ * overlap. Row `y` of a rectangle starts at `fb->front + FB_OFFSET(fb, r->x, y)`.
+ */
+typedef esp_err_t (*fb_render_partial_cb_t)(framebuffer_t *fb, const fb_rect_t *rects, size_t count, void *arg);
+
 /**
  * Framebuffer descriptor descriptor
  */
@@ -75,6 +104,13 @@ struct framebuffer_s
     fb_render_cb_t render;         ///< See ::fb_render()
     uint8_t *internal;             ///< Buffer for effect settings, internal vars, palettes and so on
     SemaphoreHandle_t mutex;
+    fb_render_partial_cb_t render_partial; ///< See ::fb_set_render_partial()
+    fb_rect_t damage[FB_DAMAGE_MAX];       ///< Changed since the last rendered frame
+    size_t damage_count;                   ///< Number of rectangles in damage
+    rgb_t *front;                  ///< Frame being rendered, same as data unless triple buffered
+    size_t frames_dropped;         ///< Triple buffering: frames replaced by a newer one before rendering
+    size_t frames_duplicated;      ///< Triple buffering: renders without a new frame
+    struct fb_triple_s *triple;    ///< Triple buffering state, NULL if disabled
 };
 
 /**
@@ -97,11 +133,64 @@ esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t
  */
 esp_err_t fb_free(framebuffer_t *fb);
 
+/**
+ * @brief Switch framebuffer to triple buffering
+ *
+ * Drawing and rendering get buffers of their own and never wait for each
+ * other: ::fb_begin() always succeeds, ::fb_end() publishes the frame with an
+ * atomic swap, and ::fb_render() takes the newest published frame into
+ * `fb->front`. A frame replaced before it was rendered is counted in
+ * `frames_dropped`, a render without a new frame in `frames_duplicated`.
+ *
+ * Drawing goes on from a copy of the frame just published, so effects that
+ * change the previous frame keep working, at the cost of a frame copy in
+ * ::fb_end(). Takes two more frames of memory. Call it before drawing and
+ * rendering start; there must be one drawing task and one rendering task.
+ *
+ * @param fb        Framebuffer descriptor
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_enable_triple_buffering(framebuffer_t *fb);
+
+/**
+ * @brief Set partial renderer callback
+ *
+ * With a partial renderer set, the framebuffer tracks damage: pixel
+ * functions, ::fb_clear(), ::fb_shift(), ::fb_fade() and ::fb_blur2d()
+ * record the changed rectangles, and ::fb_render() passes only these to
+ * \p render_cb. A frame without changes is not rendered at all. Code that
+ * writes `fb->data` directly must report it with ::fb_damage().
+ *
+ * The whole frame is marked damaged, so the next frame is rendered in full.
+ *
+ * @param fb        Framebuffer descriptor
+ * @param render_cb Partial renderer callback function, NULL to go back
+ *                  to full rendering
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_set_render_partial(framebuffer_t *fb, fb_render_partial_cb_t render_cb);
+
+/**
+ * @brief Mark rectangle of framebuffer as changed
+ *
+ * Rectangle is clipped to the framebuffer. Does nothing without a partial
+ * renderer.
+ *
+ * @param fb     Framebuffer descriptor
+ * @param x      Left column
+ * @param y      Top row
+ * @param w      Width in pixels
+ * @param h      Height in pixels
+ * @return       ESP_OK on success
+ */
+esp_err_t fb_damage(framebuffer_t *fb, size_t x, size_t y, size_t w, size_t h);
+
 /**
  * @brief Render frambuffer to actual display or LED strip
  *
  * Rendering is performed by calling the callback function with passing
- * it as arguments \p fb and \p ctx
+ * it as arguments \p fb and \p ctx. If a partial renderer is set, it is
+ * called instead with the damaged rectangles, see ::fb_set_render_partial()
  *
  * @param fb   Framebuffer descriptor
  * @param ctx  Argument to pass to callback
@@ -0,0 +1,467 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 deity
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * fbdraw.h primitives on a 64x32 frame against per-pixel references built
+ * on fb_set_pixel_rgb(), with endpoints and positions partly off the frame:
+ *
+ * - lines: FBDRAW_CASES random endpoint pairs (20000) vs Bresenham, an
+ *   eighth of them with an endpoint up to 3000 pixels away, and lines
+ *   between the int limits;
+ * - rectangles, outlined and filled, vs loops over their pixels;
+ * - outlined circles vs the midpoint circle, filled circles vs the spans
+ *   between its outline pixels on every row;
+ * - blits (plain, keyed, alpha) vs per-pixel copy and rgb_blend().
+ *
+ * Every pixel a primitive changes must also be inside the damage
+ * rectangles it reports. Then the speed of the primitives is compared with
+ * the per-pixel code they replace.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <framebuffer.h>
+#include <fbdraw.h>
+
+#define WIDTH  64
+#define HEIGHT 32
+#define CIRCLE_R_MAX 40
+
+static framebuffer_t fb, ref;
+static rgb_t before[WIDTH * HEIGHT];
+static uint32_t bad_pixels, bad_damage, cases;
+
+static esp_err_t render(framebuffer_t *fb, void *arg)
+{
+    return ESP_OK;
+}
+
+// damage is only tracked with a partial renderer
+static esp_err_t render_partial(framebuffer_t *fb, const fb_rect_t *rects, size_t count, void *arg)
+{
+    return ESP_OK;
+}
+
+static rgb_t random_rgb()
+{
+    return (rgb_t){ .r = rand(), .g = rand(), .b = rand() };
+}
+
+static void ref_pixel(int x, int y, rgb_t c)
+{
+    if (x >= 0 && y >= 0 && x < WIDTH && y < HEIGHT)
+        fb_set_pixel_rgb(&ref, x, y, c);
+}
+
+static void ref_line(int x0, int y0, int x1, int y1, rgb_t c)
+{
+    int64_t dx = llabs((int64_t)x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int64_t dy = llabs((int64_t)y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int64_t err = dx - dy;
+    for (;;)
+    {
+        ref_pixel(x0, y0, c);
+        if (x0 == x1 && y0 == y1)
+            break;
+        int64_t e2 = 2 * err;
+        if (e2 > -dy)
+        {
+            err -= dy;
+            x0 += sx;
+        }
+        if (e2 < dx)
+        {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+static void ref_rect(int x, int y, int w, int h, bool filled, rgb_t c)
+{
+    for (int j = 0; j < h; j++)
+        for (int i = 0; i < w; i++)
+            if (filled || !i || !j || i == w - 1 || j == h - 1)
+                ref_pixel(x + i, y + j, c);
+}
+
+static void ref_circle(int cx, int cy, int r, rgb_t c)
+{
+    int x = r, y = 0, err = 1 - r;
+    while (x >= y)
+    {
+        ref_pixel(cx + x, cy + y, c);
+        ref_pixel(cx - x, cy + y, c);
+        ref_pixel(cx + x, cy - y, c);
+        ref_pixel(cx - x, cy - y, c);
+        ref_pixel(cx + y, cy + x, c);
+        ref_pixel(cx - y, cy + x, c);
+        ref_pixel(cx + y, cy - x, c);
+        ref_pixel(cx - y, cy - x, c);
+        y++;
+        if (err < 0)
+            err += 2 * y + 1;
+        else
+        {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+// Every row of a filled circle spans the outline pixels of that row,
+// taken on the unclipped plane
+static void ref_fill_circle(int cx, int cy, int r, rgb_t c)
+{
+    int lo[2 * CIRCLE_R_MAX + 1], hi[2 * CIRCLE_R_MAX + 1];
+    for (int i = 0; i <= 2 * r; i++)
+    {
+        lo[i] = INT_MAX;
+        hi[i] = INT_MIN;
+    }
+
+    int x = r, y = 0, err = 1 - r;
+    while (x >= y)
+    {
+        const int dx[4] = { x, x, y, y }, dy[4] = { y, -y, x, -x };
+        for (int i = 0; i < 4; i++)
+        {
+            int row = r + dy[i];
+            if (cx - dx[i] < lo[row]) lo[row] = cx - dx[i];
+            if (cx + dx[i] > hi[row]) hi[row] = cx + dx[i];
+        }
+        y++;
+        if (err < 0)
+            err += 2 * y + 1;
+        else
+        {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+    for (int row = 0; row <= 2 * r; row++)
+        for (int px = lo[row]; px <= hi[row]; px++)
+            ref_pixel(px, cy - r + row, c);
+}
+
+// Both frames get the same random background, damage is reset
+static void start_case()
+{
+    for (int i = 0; i < WIDTH * HEIGHT; i++)
+        before[i] = random_rgb();
+    memcpy(fb.data, before, sizeof(before));
+    memcpy(ref.data, before, sizeof(before));
+    fb.damage_count = 0;
+    cases++;
+}
+
+static bool damaged(int x, int y)
+{
+    for (size_t i = 0; i < fb.damage_count; i++)
+    {
+        const fb_rect_t *r = &fb.damage[i];
+        if (x >= r->x && x < r->x + r->w && y >= r->y && y < r->y + r->h)
+            return true;
+    }
+    return false;
+}
+
+static void check_case(const char *what)
+{
+    bool pixels = memcmp(fb.data, ref.data, sizeof(before)) == 0;
+    bool covered = true;
+    for (int y = 0; y < HEIGHT; y++)
+        for (int x = 0; x < WIDTH; x++)
+            if (memcmp(&fb.data[y * WIDTH + x], &before[y * WIDTH + x], sizeof(rgb_t)) && !damaged(x, y))
+                covered = false;
+
+    if (!pixels && !bad_pixels)
+        printf("first mismatch: %s\n", what);
+    if (!covered && !bad_damage)
+        printf("first change outside damage: %s\n", what);
+    bad_pixels += !pixels;
+    bad_damage += !covered;
+}
+
+static int rnd(int from, int to)
+{
+    return from + rand() % (to - from);
+}
+
+static void test_lines(uint32_t count)
+{
+    char what[64];
+    for (uint32_t n = 0; n < count; n++)
+    {
+        int x0 = rnd(-28, WIDTH + 28), y0 = rnd(-24, HEIGHT + 24);
+        int x1 = rnd(-28, WIDTH + 28), y1 = rnd(-24, HEIGHT + 24);
+        // every 8th line is horizontal or vertical, they take other paths,
+        // and every 8th has a far endpoint, the line is clipped before drawing
+        if (n % 8 == 1) y1 = y0;
+        if (n % 8 == 2) x1 = x0;
+        if (n % 8 == 3)
+        {
+            x1 = rnd(-3000, 3000);
+            y1 = rnd(-3000, 3000);
+        }
+        rgb_t c = random_rgb();
+        start_case();
+        fb_draw_line(&fb, x0, y0, x1, y1, c);
+        ref_line(x0, y0, x1, y1, c);
+        snprintf(what, sizeof(what), "line %d,%d - %d,%d", x0, y0, x1, y1);
+        check_case(what);
+    }
+
+    // deltas do not fit in int; the diagonal and the straight lines can be
+    // drawn by the reference from the frame border
+    const int limits[][8] = {
+        { INT_MIN, INT_MIN, INT_MAX, INT_MAX, 0, 0, HEIGHT - 1, HEIGHT - 1 },
+        { INT_MAX, INT_MIN + 41, INT_MIN + 41, INT_MAX, 40, 0, 40 - HEIGHT + 1, HEIGHT - 1 },
+        { INT_MIN, 5, INT_MAX, 5, 0, 5, WIDTH - 1, 5 },
+        { 7, INT_MAX, 7, INT_MIN, 7, HEIGHT - 1, 7, 0 },
+    };
+    for (size_t n = 0; n < sizeof(limits) / sizeof(limits[0]); n++)
+    {
+        const int *l = limits[n];
+        rgb_t c = random_rgb();
+        start_case();
+        fb_draw_line(&fb, l[0], l[1], l[2], l[3], c);
+        ref_line(l[4], l[5], l[6], l[7], c);
+        snprintf(what, sizeof(what), "line %d,%d - %d,%d", l[0], l[1], l[2], l[3]);
+        check_case(what);
+    }
+}
+
+static void test_rects(uint32_t count)
+{
+    char what[64];
+    for (uint32_t n = 0; n < count; n++)
+    {
+        int x = rnd(-20, WIDTH + 4), y = rnd(-20, HEIGHT + 4), w = rnd(-2, 90), h = rnd(-2, 50);
+        bool filled = n & 1;
+        rgb_t c = random_rgb();
+        start_case();
+        if (filled)
+            fb_fill_rect(&fb, x, y, w, h, c);
+        else
+            fb_draw_rect(&fb, x, y, w, h, c);
+        ref_rect(x, y, w, h, filled, c);
+        snprintf(what, sizeof(what), "%s rect %d,%d %dx%d", filled ? "filled" : "outlined", x, y, w, h);
+        check_case(what);
+    }
+}
+
+static void test_circles(uint32_t count)
+{
+    char what[64];
+    for (uint32_t n = 0; n < count; n++)
+    {
+        int cx = rnd(-20, WIDTH + 20), cy = rnd(-20, HEIGHT + 20), r = rnd(0, CIRCLE_R_MAX + 1);
+        rgb_t c = random_rgb();
+        start_case();
+        fb_draw_circle(&fb, cx, cy, r, c);
+        ref_circle(cx, cy, r, c);
+        snprintf(what, sizeof(what), "circle %d,%d r %d", cx, cy, r);
+        check_case(what);
+
+        start_case();
+        fb_fill_circle(&fb, cx, cy, r, c);
+        ref_fill_circle(cx, cy, r, c);
+        snprintf(what, sizeof(what), "filled circle %d,%d r %d", cx, cy, r);
+        check_case(what);
+    }
+}
+
+static void test_blits(uint32_t count)
+{
+    char what[64];
+    rgb_t img[12 * 10];
+    uint8_t alpha[12 * 10];
+    rgb_t key = { .r = 1, .g = 2, .b = 3 };
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        int w = rnd(1, 12), h = rnd(1, 10), stride = 12, x = rnd(-14, WIDTH + 2), y = rnd(-12, HEIGHT + 2);
+        int kind = n % 3;
+        uint8_t opacity = n % 5 ? rand() : 255;
+        for (int i = 0; i < 12 * 10; i++)
+        {
+            img[i] = rand() % 4 ? random_rgb() : key;
+            alpha[i] = rand() % 3 ? rand() : (rand() & 1) * 255;
+        }
+        start_case();
+        if (kind == 0)
+            fb_blit(&fb, x, y, img, w, h, stride);
+        else if (kind == 1)
+            fb_blit_key(&fb, x, y, img, w, h, stride, key);
+        else
+            fb_blit_alpha(&fb, x, y, img, alpha, w, h, stride, opacity);
+
+        for (int j = 0; j < h; j++)
+            for (int i = 0; i < w; i++)
+            {
+                int px = x + i, py = y + j;
+                rgb_t s = img[j * stride + i];
+                if (px < 0 || py < 0 || px >= WIDTH || py >= HEIGHT)
+                    continue;
+                if (kind == 1 && !memcmp(&s, &key, sizeof(s)))
+                    continue;
+                if (kind == 2)
+                {
+                    uint8_t a = scale8(alpha[j * stride + i], opacity);
+                    if (!a)
+                        continue;
+                    if (a != 255)
+                        s = rgb_blend(ref.data[py * WIDTH + px], s, a);
+                }
+                ref_pixel(px, py, s);
+            }
+        snprintf(what, sizeof(what), "%s %dx%d at %d,%d", kind == 0 ? "blit" : kind == 1 ? "keyed blit" : "alpha blit",
+                w, h, x, y);
+        check_case(what);
+    }
+}
+
+/* Speed */
+
+static double us_per_call(int64_t start, uint32_t calls)
+{
+    return (double)(esp_timer_get_time() - start) / calls;
+}
+
+static void bench()
+{
+    rgb_t c = { .r = 255, .g = 200, .b = 100 }, k = { 0 };
+    rgb_t sprite[16 * 16];
+    for (int i = 0; i < 16 * 16; i++)
+        sprite[i] = i % 5 ? c : k;
+
+    uint32_t n = 2000;
+    int64_t t = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+        for (int y = 4; y < 28; y++)
+            for (int x = 4; x < 60; x++)
+                fb_set_pixel_rgb(&fb, x, y, c);
+    double slow = us_per_call(t, n);
+    t = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+        fb_fill_rect(&fb, 4, 4, 56, 24, c);
+    double fast = us_per_call(t, n);
+    printf("fill 56x24:          per pixel %7.3f us, fb_fill_rect  %7.3f us (x%.1f)\n", slow, fast, slow / fast);
+
+    n = 20000;
+    t = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+        ref_line(-10, 3, 70, 29, c);
+    slow = us_per_call(t, n);
+    t = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+        fb_draw_line(&fb, -10, 3, 70, 29, c);
+    fast = us_per_call(t, n);
+    printf("clipped line:        per pixel %7.3f us, fb_draw_line  %7.3f us (x%.1f)\n", slow, fast, slow / fast);
+
+    t = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+        ref_line(1, 3, 62, 29, c);
+    slow = us_per_call(t, n);
+    t = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+        fb_draw_line(&fb, 1, 3, 62, 29, c);
+    fast = us_per_call(t, n);
+    printf("line in the frame:   per pixel %7.3f us, fb_draw_line  %7.3f us (x%.1f)\n", slow, fast, slow / fast);
+
+    n = 20;
+    t = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+        ref_line(-1000000, 0, 10, 10, c);
+    slow = us_per_call(t, n);
+    t = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+        fb_draw_line(&fb, -1000000, 0, 10, 10, c);
+    fast = us_per_call(t, n);
+    printf("line from -1000000:  per pixel %7.3f us, fb_draw_line  %7.3f us (x%.1f)\n", slow, fast, slow / fast);
+    n = 20000;
+
+    t = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+        for (int y = 0; y < 16; y++)
+            for (int x = 0; x < 16; x++)
+                fb_set_pixel_rgb(&fb, x + 20, y + 8, sprite[y * 16 + x]);
+    slow = us_per_call(t, n);
+    t = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+        fb_blit(&fb, 20, 8, sprite, 16, 16, 0);
+    fast = us_per_call(t, n);
+    printf("16x16 blit:          per pixel %7.3f us, fb_blit       %7.3f us (x%.1f)\n", slow, fast, slow / fast);
+
+    t = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+        for (int y = 0; y < 16; y++)
+            for (int x = 0; x < 16; x++)
+                if (memcmp(&sprite[y * 16 + x], &k, sizeof(k)))
+                    fb_set_pixel_rgb(&fb, x + 20, y + 8, sprite[y * 16 + x]);
+    slow = us_per_call(t, n);
+    t = esp_timer_get_time();
+    for (uint32_t i = 0; i < n; i++)
+        fb_blit_key(&fb, 20, 8, sprite, 16, 16, 0, k);
+    fast = us_per_call(t, n);
+    printf("16x16 keyed sprite:  per pixel %7.3f us, fb_blit_key   %7.3f us (x%.1f)\n", slow, fast, slow / fast);
+}
+
+void app_main()
+{
+    const char *env = getenv("FBDRAW_CASES");
+    uint32_t count = env ? (uint32_t)atoi(env) : 20000;
+    env = getenv("FBDRAW_SEED");
+    unsigned seed = env ? (unsigned)atoi(env) : (unsigned)esp_timer_get_time();
+    srand(seed);
+
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    if (fb_init(&fb, WIDTH, HEIGHT, render) != ESP_OK || fb_init(&ref, WIDTH, HEIGHT, render) != ESP_OK
+            || fb_set_render_partial(&fb, render_partial) != ESP_OK)
+    {
+        printf("fb_init failed\n");
+        exit(1);
+    }
+
+    test_lines(count);
+    printf("%lu random endpoints: %lu lines differ from the reference\n", (unsigned long)count,
+            (unsigned long)bad_pixels);
+    test_rects(count / 4);
+    test_circles(count / 20);
+    test_blits(count / 4);
+    printf("%lu cases: %lu differ from the reference, %lu change pixels outside their damage\n",
+            (unsigned long)cases, (unsigned long)bad_pixels, (unsigned long)bad_damage);
+
+    bench();
+
+    bool ok = !bad_pixels && !bad_damage;
+    printf("fbdraw (seed %u): %s\n", seed, ok ? "OK" : "FAILED");
+    fb_free(&fb);
+    fb_free(&ref);
+    fflush(stdout);
+    exit(ok ? 0 : 1);
+}
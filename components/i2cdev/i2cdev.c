@@ -34,8 +34,11 @@
 #include <inttypes.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/queue.h>
 #include <esp_log.h>
+#include <esp_attr.h>
 #include "i2cdev.h"
+#include "i2cdev_trace.h"
 
 static const char *TAG = "i2cdev";
 
@@ -43,6 +46,11 @@ typedef struct {
     SemaphoreHandle_t lock;
     i2c_config_t config;
     bool installed;
+    uint32_t timeout_ticks; //!< Timeout set on the port, 0 if unknown
+    QueueHandle_t queue;    //!< Asynchronous requests, NULL until first use
+    QueueHandle_t isr_queue; //!< Priority lane, served first
+    TaskHandle_t worker;    //!< Bus worker task running them
+    SemaphoreHandle_t stopped; //!< Given by the worker when it exits
 } i2c_port_state_t;
 
 static i2c_port_state_t states[I2C_NUM_MAX];
@@ -90,12 +98,15 @@ esp_err_t i2cdev_init()
     return ESP_OK;
 }
 
+static void async_stop(i2c_port_t port);
+
 esp_err_t i2cdev_done()
 {
     for (int i = 0; i < I2C_NUM_MAX; i++)
     {
         if (!states[i].lock) continue;
 
+        async_stop(i);
         if (states[i].installed)
         {
             SEMAPHORE_TAKE(i);
@@ -177,7 +188,7 @@ inline static bool cfg_equal(const i2c_config_t *a, const i2c_config_t *b)
 {
     return a->scl_io_num == b->scl_io_num
         && a->sda_io_num == b->sda_io_num
-#if HELPER_TARGET_IS_ESP32
+#if HELPER_TARGET_IS_ESP32 || HELPER_TARGET_IS_LINUX
         && a->master.clk_speed == b->master.clk_speed
 #elif HELPER_TARGET_IS_ESP8266
         && ((a->clk_stretch_tick && a->clk_stretch_tick == b->clk_stretch_tick) 
@@ -206,7 +217,8 @@ static esp_err_t i2c_setup_port(const i2c_dev_t *dev)
             i2c_driver_delete(dev->port);
             states[dev->port].installed = false;
         }
-#if HELPER_TARGET_IS_ESP32
+        states[dev->port].timeout_ticks = 0;
+#if HELPER_TARGET_IS_ESP32 || HELPER_TARGET_IS_LINUX
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
         // See https://github.com/espressif/esp-idf/issues/10163
         if ((res = i2c_driver_install(dev->port, temp.mode, 0, 0, 0)) != ESP_OK)
@@ -233,15 +245,18 @@ static esp_err_t i2c_setup_port(const i2c_dev_t *dev)
         memcpy(&states[dev->port].config, &temp, sizeof(i2c_config_t));
         ESP_LOGD(TAG, "I2C driver successfully reconfigured on port %d", dev->port);
     }
-#if HELPER_TARGET_IS_ESP32
-    int t;
-    if ((res = i2c_get_timeout(dev->port, &t)) != ESP_OK)
-        return res;
+#if HELPER_TARGET_IS_ESP32 || HELPER_TARGET_IS_LINUX
     // Timeout cannot be 0
     uint32_t ticks = dev->timeout_ticks ? dev->timeout_ticks : I2CDEV_MAX_STRETCH_TIME;
-    if ((ticks != t) && (res = i2c_set_timeout(dev->port, ticks)) != ESP_OK)
-        return res;
-    ESP_LOGD(TAG, "Timeout: ticks = %" PRIu32 " (%" PRIu32 " usec) on port %d", dev->timeout_ticks, dev->timeout_ticks / 80, dev->port);
+    // The port keeps its timeout, it is set again only when a device with
+    // a different timeout uses the port
+    if (ticks != states[dev->port].timeout_ticks)
+    {
+        if ((res = i2c_set_timeout(dev->port, ticks)) != ESP_OK)
+            return res;
+        states[dev->port].timeout_ticks = ticks;
+        ESP_LOGD(TAG, "Timeout: ticks = %" PRIu32 " (%" PRIu32 " usec) on port %d", dev->timeout_ticks, dev->timeout_ticks / 80, dev->port);
+    }
 #endif
 
     return ESP_OK;
@@ -251,6 +266,7 @@ esp_err_t i2c_dev_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
 {
     if (!dev) return ESP_ERR_INVALID_ARG;
 
+    I2CDEV_TRACE_MARK(t_wait);
     SEMAPHORE_TAKE(dev->port);
 
     esp_err_t res = i2c_setup_port(dev);
@@ -261,7 +277,9 @@ esp_err_t i2c_dev_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
         i2c_master_write_byte(cmd, dev->addr << 1 | (operation_type == I2C_DEV_READ ? 1 : 0), true);
         i2c_master_stop(cmd);
 
+        I2CDEV_TRACE_MARK(t_bus);
         res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+        I2CDEV_TRACE_RECORD(dev, 0, t_wait, t_bus, res);
 
         i2c_cmd_link_delete(cmd);
     }
@@ -275,6 +293,7 @@ esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_si
 {
     if (!dev || !in_data || !in_size) return ESP_ERR_INVALID_ARG;
 
+    I2CDEV_TRACE_MARK(t_wait);
     SEMAPHORE_TAKE(dev->port);
 
     esp_err_t res = i2c_setup_port(dev);
@@ -292,7 +311,9 @@ esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_si
         i2c_master_read(cmd, in_data, in_size, I2C_MASTER_LAST_NACK);
         i2c_master_stop(cmd);
 
+        I2CDEV_TRACE_MARK(t_bus);
         res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+        I2CDEV_TRACE_RECORD(dev, (out_data ? out_size : 0) + in_size, t_wait, t_bus, res);
         if (res != ESP_OK)
             ESP_LOGE(TAG, "Could not read from device [0x%02x at %d]: %d (%s)", dev->addr, dev->port, res, esp_err_to_name(res));
 
@@ -307,6 +328,7 @@ esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg, size_t out_re
 {
     if (!dev || !out_data || !out_size) return ESP_ERR_INVALID_ARG;
 
+    I2CDEV_TRACE_MARK(t_wait);
     SEMAPHORE_TAKE(dev->port);
 
     esp_err_t res = i2c_setup_port(dev);
@@ -319,7 +341,9 @@ esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg, size_t out_re
             i2c_master_write(cmd, (void *)out_reg, out_reg_size, true);
         i2c_master_write(cmd, (void *)out_data, out_size, true);
         i2c_master_stop(cmd);
+        I2CDEV_TRACE_MARK(t_bus);
         res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+        I2CDEV_TRACE_RECORD(dev, (out_reg ? out_reg_size : 0) + out_size, t_wait, t_bus, res);
         if (res != ESP_OK)
             ESP_LOGE(TAG, "Could not write to device [0x%02x at %d]: %d (%s)", dev->addr, dev->port, res, esp_err_to_name(res));
         i2c_cmd_link_delete(cmd);
@@ -338,3 +362,408 @@ esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg, const void *out_d
 {
     return i2c_dev_write(dev, &reg, 1, out_data, out_size);
 }
+
+esp_err_t i2c_dev_batch_begin(i2c_dev_batch_t *batch, const i2c_dev_t *dev)
+{
+    if (!batch || !dev) return ESP_ERR_INVALID_ARG;
+
+    batch->dev = dev;
+    batch->ops = 0;
+    batch->bytes = 0;
+    batch->err = ESP_OK;
+    batch->keep = false;
+    batch->closed = false;
+#ifdef I2C_DEV_BATCH_LINK_SIZE
+    batch->cmd = i2c_cmd_link_create_static(batch->link, sizeof(batch->link));
+#else
+    batch->cmd = i2c_cmd_link_create();
+#endif
+    if (!batch->cmd)
+    {
+        batch->err = ESP_ERR_NO_MEM;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t batch_check(i2c_dev_batch_t *batch)
+{
+    if (batch->err != ESP_OK) return batch->err;
+    if (batch->closed)
+    {
+        batch->err = ESP_ERR_INVALID_STATE;
+        return batch->err;
+    }
+    if (batch->ops >= CONFIG_I2CDEV_BATCH_MAX_OPS)
+    {
+        ESP_LOGE(TAG, "[0x%02x at %d] Batch is full", batch->dev->addr, batch->dev->port);
+        batch->err = ESP_ERR_NO_MEM;
+        return batch->err;
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_batch_read_reg(i2c_dev_batch_t *batch, uint8_t reg, void *in_data, size_t in_size)
+{
+    if (!batch || !batch->dev || !in_data || !in_size) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t res = batch_check(batch);
+    if (res != ESP_OK) return res;
+
+    // repeated START between accesses: the bus stays ours for the whole batch
+    i2c_master_start(batch->cmd);
+    i2c_master_write_byte(batch->cmd, batch->dev->addr << 1, true);
+    i2c_master_write_byte(batch->cmd, reg, true);
+    i2c_master_start(batch->cmd);
+    i2c_master_write_byte(batch->cmd, (batch->dev->addr << 1) | 1, true);
+    res = i2c_master_read(batch->cmd, in_data, in_size, I2C_MASTER_LAST_NACK);
+    if (res != ESP_OK)
+    {
+        batch->err = res;
+        return res;
+    }
+    batch->ops++;
+    batch->bytes += 1 + in_size;
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_batch_read(i2c_dev_batch_t *batch, const void *out_data, size_t out_size,
+        void *in_data, size_t in_size)
+{
+    if (!batch || !batch->dev || !in_data || !in_size) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t res = batch_check(batch);
+    if (res != ESP_OK) return res;
+
+    if (out_data && out_size)
+    {
+        i2c_master_start(batch->cmd);
+        i2c_master_write_byte(batch->cmd, batch->dev->addr << 1, true);
+        i2c_master_write(batch->cmd, (void *)out_data, out_size, true);
+    }
+    else
+        out_size = 0;
+    i2c_master_start(batch->cmd);
+    i2c_master_write_byte(batch->cmd, (batch->dev->addr << 1) | 1, true);
+    res = i2c_master_read(batch->cmd, in_data, in_size, I2C_MASTER_LAST_NACK);
+    if (res != ESP_OK)
+    {
+        batch->err = res;
+        return res;
+    }
+    batch->ops++;
+    batch->bytes += out_size + in_size;
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_batch_write_reg(i2c_dev_batch_t *batch, uint8_t reg, const void *out_data, size_t out_size)
+{
+    if (!batch || !batch->dev || !out_data || !out_size) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t res = batch_check(batch);
+    if (res != ESP_OK) return res;
+
+    i2c_master_start(batch->cmd);
+    i2c_master_write_byte(batch->cmd, batch->dev->addr << 1, true);
+    i2c_master_write_byte(batch->cmd, reg, true);
+    res = i2c_master_write(batch->cmd, (void *)out_data, out_size, true);
+    if (res != ESP_OK)
+    {
+        batch->err = res;
+        return res;
+    }
+    batch->ops++;
+    batch->bytes += 1 + out_size;
+    return ESP_OK;
+}
+
+static esp_err_t batch_run(i2c_dev_batch_t *batch)
+{
+    const i2c_dev_t *dev = batch->dev;
+
+    I2CDEV_TRACE_MARK(t_wait);
+    SEMAPHORE_TAKE(dev->port);
+
+    esp_err_t res = i2c_setup_port(dev);
+    if (res == ESP_OK)
+    {
+        I2CDEV_TRACE_MARK(t_bus);
+        res = i2c_master_cmd_begin(dev->port, batch->cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+        I2CDEV_TRACE_RECORD(dev, batch->bytes, t_wait, t_bus, res);
+        if (res != ESP_OK)
+            ESP_LOGE(TAG, "Could not run batch of %d accesses on device [0x%02x at %d]: %d (%s)",
+                    (int)batch->ops, dev->addr, dev->port, res, esp_err_to_name(res));
+    }
+
+    SEMAPHORE_GIVE(dev->port);
+    return res;
+}
+
+esp_err_t i2c_dev_batch_keep(i2c_dev_batch_t *batch)
+{
+    if (!batch || !batch->cmd) return ESP_ERR_INVALID_ARG;
+    batch->keep = true;
+    return ESP_OK;
+}
+
+void i2c_dev_batch_release(i2c_dev_batch_t *batch)
+{
+    if (!batch || !batch->cmd) return;
+#ifdef I2C_DEV_BATCH_LINK_SIZE
+    i2c_cmd_link_delete_static(batch->cmd);
+#else
+    i2c_cmd_link_delete(batch->cmd);
+#endif
+    batch->cmd = NULL;
+}
+
+esp_err_t i2c_dev_batch_exec(i2c_dev_batch_t *batch)
+{
+    if (!batch) return ESP_ERR_INVALID_ARG;
+    if (!batch->cmd) return batch->err != ESP_OK ? batch->err : ESP_ERR_INVALID_STATE;
+
+    esp_err_t res = batch->err;
+    if (res == ESP_OK && batch->ops)
+    {
+        if (!batch->closed)
+        {
+            i2c_master_stop(batch->cmd);
+            batch->closed = true;
+        }
+        res = batch_run(batch);
+    }
+
+    if (!batch->keep)
+        i2c_dev_batch_release(batch);
+    return res;
+}
+
+static void async_complete(i2c_dev_async_t *req, esp_err_t res, bool notify)
+{
+    if (notify && req->cb)
+        req->cb(res, req->arg);
+    req->result = res;
+    // completion is this give and nothing else: the owner may free or reuse
+    // the request as soon as it sees it, so req is not touched after it
+    xSemaphoreGive(req->done);
+}
+
+// Owner side only: is the request still pending? Collects the completion
+// give if it has arrived.
+static bool async_pending(i2c_dev_async_t *req)
+{
+    if (req->pending && xSemaphoreTake(req->done, 0) == pdTRUE)
+        req->pending = false;
+    return req->pending;
+}
+
+static void bus_worker(void *arg)
+{
+    i2c_port_t port = (i2c_port_t)(intptr_t)arg;
+    i2c_dev_async_t *req;
+
+    for (;;)
+    {
+        // every submit gives a notification, so both queues are drained
+        // before waiting again
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        for (;;)
+        {
+            // the priority lane is checked again between any two normal requests
+            if (xQueueReceive(states[port].isr_queue, &req, 0) == pdTRUE)
+            {
+                async_complete(req, i2c_dev_batch_exec(&req->batch), true);
+                continue;
+            }
+            if (xQueueReceive(states[port].queue, &req, 0) != pdTRUE)
+                break;
+            if (!req)
+                goto stop;
+            // the bus is busy here while the submitting tasks go on computing
+            async_complete(req, i2c_dev_batch_exec(&req->batch), true);
+        }
+    }
+
+stop:
+    xSemaphoreGive(states[port].stopped);
+    vTaskDelete(NULL);
+}
+
+// The worker runs the requests queued so far, then exits on the NULL marker
+static void async_stop(i2c_port_t port)
+{
+    if (!states[port].worker) return;
+
+    i2c_dev_async_t *stop = NULL;
+    xQueueSend(states[port].queue, &stop, portMAX_DELAY);
+    xTaskNotifyGive(states[port].worker);
+    xSemaphoreTake(states[port].stopped, portMAX_DELAY);
+
+    vSemaphoreDelete(states[port].stopped);
+    vQueueDelete(states[port].queue);
+    vQueueDelete(states[port].isr_queue);
+    states[port].stopped = NULL;
+    states[port].queue = NULL;
+    states[port].isr_queue = NULL;
+    states[port].worker = NULL;
+}
+
+esp_err_t i2c_dev_async_start(i2c_port_t port)
+{
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(port);
+
+    esp_err_t res = ESP_OK;
+    if (!states[port].worker)
+    {
+        states[port].queue = xQueueCreate(CONFIG_I2CDEV_ASYNC_QUEUE_LEN, sizeof(i2c_dev_async_t *));
+        states[port].isr_queue = xQueueCreate(CONFIG_I2CDEV_ISR_QUEUE_LEN, sizeof(i2c_dev_async_t *));
+        states[port].stopped = xSemaphoreCreateBinary();
+        if (!states[port].queue || !states[port].isr_queue || !states[port].stopped
+                || xTaskCreate(bus_worker, "i2c_bus", CONFIG_I2CDEV_ASYNC_TASK_STACK, (void *)(intptr_t)port,
+                        CONFIG_I2CDEV_ASYNC_TASK_PRIO, &states[port].worker) != pdPASS)
+        {
+            ESP_LOGE(TAG, "Could not start bus worker on port %d", port);
+            if (states[port].queue)
+                vQueueDelete(states[port].queue);
+            if (states[port].isr_queue)
+                vQueueDelete(states[port].isr_queue);
+            if (states[port].stopped)
+                vSemaphoreDelete(states[port].stopped);
+            states[port].queue = NULL;
+            states[port].isr_queue = NULL;
+            states[port].stopped = NULL;
+            states[port].worker = NULL;
+            res = ESP_ERR_NO_MEM;
+        }
+    }
+
+    SEMAPHORE_GIVE(port);
+    return res;
+}
+
+esp_err_t i2c_dev_async_init(i2c_dev_async_t *req, i2c_dev_async_cb_t cb, void *arg)
+{
+    if (!req) return ESP_ERR_INVALID_ARG;
+
+    memset(req, 0, sizeof(*req));
+    req->cb = cb;
+    req->arg = arg;
+    req->result = ESP_OK;
+    req->pending = false;
+    req->done = xSemaphoreCreateBinaryStatic(&req->done_buf);
+    return req->done ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t i2c_dev_async_submit(i2c_dev_async_t *req)
+{
+    if (!req || !req->done || !req->batch.dev) return ESP_ERR_INVALID_ARG;
+    if (async_pending(req)) return ESP_ERR_INVALID_STATE;
+
+    i2c_port_t port = req->batch.dev->port;
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    req->result = ESP_ERR_NOT_FINISHED;
+    req->pending = true;
+
+    esp_err_t res = states[port].worker ? ESP_OK : i2c_dev_async_start(port);
+    if (res == ESP_OK)
+    {
+        if (xQueueSend(states[port].queue, &req, 0) == pdTRUE)
+            xTaskNotifyGive(states[port].worker);
+        else
+        {
+            ESP_LOGE(TAG, "[0x%02x at %d] Bus queue is full", req->batch.dev->addr, port);
+            res = ESP_ERR_NO_MEM;
+        }
+    }
+    if (res != ESP_OK)
+    {
+        if (!req->batch.keep)
+            i2c_dev_batch_release(&req->batch);
+        async_complete(req, res, false);
+    }
+    return res;
+}
+
+esp_err_t IRAM_ATTR i2c_dev_async_submit_from_isr(i2c_dev_async_t *req, BaseType_t *woken)
+{
+    if (!req || !req->done || !req->batch.dev || !req->batch.cmd || !req->batch.keep)
+        return ESP_ERR_INVALID_ARG;
+    if (req->pending)
+    {
+        if (xSemaphoreTakeFromISR(req->done, woken) != pdTRUE)
+            return ESP_ERR_INVALID_STATE;
+        req->pending = false;
+    }
+
+    i2c_port_t port = req->batch.dev->port;
+    if (port >= I2C_NUM_MAX || !states[port].worker)
+        return ESP_ERR_INVALID_STATE;
+
+    req->result = ESP_ERR_NOT_FINISHED;
+    if (xQueueSendFromISR(states[port].isr_queue, &req, woken) != pdTRUE)
+    {
+        // no logging from an ISR, the result tells the task
+        req->result = ESP_ERR_NO_MEM;
+        return ESP_ERR_NO_MEM;
+    }
+    req->pending = true;
+    vTaskNotifyGiveFromISR(states[port].worker, woken);
+    return ESP_OK;
+}
+
+// submit a request just filled by a shortcut, or drop it if filling failed
+static esp_err_t async_submit_filled(i2c_dev_async_t *req, esp_err_t res)
+{
+    if (res != ESP_OK)
+    {
+        if (!req->batch.keep)
+            i2c_dev_batch_release(&req->batch);
+        return res;
+    }
+    return i2c_dev_async_submit(req);
+}
+
+esp_err_t i2c_dev_read_reg_async(i2c_dev_async_t *req, const i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size)
+{
+    if (!req) return ESP_ERR_INVALID_ARG;
+    if (req->done && async_pending(req)) return ESP_ERR_INVALID_STATE;
+
+    esp_err_t res = i2c_dev_batch_begin(&req->batch, dev);
+    if (res == ESP_OK)
+        res = i2c_dev_batch_read_reg(&req->batch, reg, in_data, in_size);
+    return async_submit_filled(req, res);
+}
+
+esp_err_t i2c_dev_read_async(i2c_dev_async_t *req, const i2c_dev_t *dev, const void *out_data, size_t out_size,
+        void *in_data, size_t in_size)
+{
+    if (!req) return ESP_ERR_INVALID_ARG;
+    if (req->done && async_pending(req)) return ESP_ERR_INVALID_STATE;
+
+    esp_err_t res = i2c_dev_batch_begin(&req->batch, dev);
+    if (res == ESP_OK)
+        res = i2c_dev_batch_read(&req->batch, out_data, out_size, in_data, in_size);
+    return async_submit_filled(req, res);
+}
+
+bool i2c_dev_async_done(i2c_dev_async_t *req)
+{
+    return req && req->done && !async_pending(req);
+}
+
+esp_err_t i2c_dev_async_wait(i2c_dev_async_t *req, TickType_t ticks)
+{
+    if (!req || !req->done) return ESP_ERR_INVALID_ARG;
+
+    // one give per submission, taken here or by async_pending()
+    if (req->pending)
+    {
+        if (xSemaphoreTake(req->done, ticks) != pdTRUE)
+            return ESP_ERR_TIMEOUT;
+        req->pending = false;
+    }
+    return req->result;
+}
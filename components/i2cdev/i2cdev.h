@@ -49,6 +49,10 @@ extern "C" {
 
 #define I2CDEV_MAX_STRETCH_TIME 0xffffffff
 
+#elif HELPER_TARGET_IS_LINUX
+
+#define I2CDEV_MAX_STRETCH_TIME 0x00ffffff
+
 #else
 
 #include <soc/i2c_reg.h>
@@ -62,6 +66,16 @@ extern "C" {
 
 #endif /* HELPER_TARGET_IS_ESP8266 */
 
+#ifdef I2C_LINK_RECOMMENDED_SIZE
+/**
+ * Command link storage of a batch: an access takes up to 7 commands (START,
+ * address, register or command bytes, repeated START, address, data and the
+ * NACKed last byte, which the driver queues separately), 8 are reserved,
+ * plus STOP. I2C_LINK_RECOMMENDED_SIZE() counts 5 commands per transaction.
+ */
+#define I2C_DEV_BATCH_LINK_SIZE I2C_LINK_RECOMMENDED_SIZE((8 * CONFIG_I2CDEV_BATCH_MAX_OPS + 1 + 4) / 5)
+#endif
+
 /**
  * I2C device descriptor
  */
@@ -76,6 +90,62 @@ typedef struct
                                   When this value is 0, I2CDEV_MAX_STRETCH_TIME will be used */
 } i2c_dev_t;
 
+/**
+ * Batch of register accesses to one device
+ *
+ * Accesses are queued into one command list joined by repeated START
+ * conditions and sent as a single I2C transaction. Fill it with
+ * ::i2c_dev_batch_begin(), ::i2c_dev_batch_read_reg(),
+ * ::i2c_dev_batch_write_reg() and send with ::i2c_dev_batch_exec().
+ */
+typedef struct
+{
+    const i2c_dev_t *dev;   //!< Device descriptor
+    i2c_cmd_handle_t cmd;   //!< Command list being built
+    size_t ops;             //!< Number of queued accesses
+    size_t bytes;           //!< Data bytes of the queued accesses, for the trace
+    esp_err_t err;          //!< First error while queueing, returned by ::i2c_dev_batch_exec()
+    bool keep;              //!< Command list survives ::i2c_dev_batch_exec(), see ::i2c_dev_batch_keep()
+    bool closed;            //!< STOP appended, no more accesses can be queued
+#ifdef I2C_DEV_BATCH_LINK_SIZE
+    /** Command list storage, no heap allocation. Aligned: the driver keeps pointers in it */
+    uint8_t link[I2C_DEV_BATCH_LINK_SIZE] __attribute__((aligned(sizeof(void *))));
+#endif
+} i2c_dev_batch_t;
+
+/**
+ * Completion callback of an asynchronous request
+ *
+ * Called from the bus worker task of the port. It must be short and must
+ * not wait for other asynchronous requests on the same port. The request
+ * has not completed yet when the callback runs: do not free or resubmit it
+ * from here.
+ *
+ * @param res Result of the request
+ * @param arg User argument given to ::i2c_dev_async_init()
+ */
+typedef void (*i2c_dev_async_cb_t)(esp_err_t res, void *arg);
+
+/**
+ * Asynchronous request: a batch run by the bus worker task of its port
+ *
+ * The caller owns the request and it must stay valid until completion.
+ * The request completes when the worker gives `done`, the worker does not
+ * touch it after that. The caller sees the completion through
+ * ::i2c_dev_async_wait() or ::i2c_dev_async_done(); after that the request
+ * can be freed, or filled and submitted again.
+ */
+typedef struct
+{
+    i2c_dev_batch_t batch;        //!< Accesses to run, fill with i2c_dev_batch_*()
+    i2c_dev_async_cb_t cb;        //!< Completion callback or NULL
+    void *arg;                    //!< Callback argument
+    esp_err_t result;             //!< Result, valid once the completion is seen
+    bool pending;                 //!< Submitted and completion not seen yet, caller side only
+    SemaphoreHandle_t done;       //!< Given by the worker on completion
+    StaticSemaphore_t done_buf;   //!< Storage of done
+} i2c_dev_async_t;
+
 /**
  * I2C transaction type
  */
@@ -215,6 +285,295 @@ esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg,
 esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg,
         const void *out_data, size_t out_size);
 
+/**
+ * @brief Start a batch of register accesses
+ *
+ * The batch holds up to CONFIG_I2CDEV_BATCH_MAX_OPS accesses. It must be
+ * finished with ::i2c_dev_batch_exec(), even if queueing failed.
+ *
+ * @param batch Batch to fill
+ * @param dev Device descriptor
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_batch_begin(i2c_dev_batch_t *batch, const i2c_dev_t *dev);
+
+/**
+ * @brief Queue a read from register with an 8-bit address
+ *
+ * \p in_data is filled by ::i2c_dev_batch_exec().
+ *
+ * @param batch Batch
+ * @param reg Register address
+ * @param[out] in_data Pointer to input data buffer
+ * @param in_size Number of byte to read
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the batch is full
+ */
+esp_err_t i2c_dev_batch_read_reg(i2c_dev_batch_t *batch, uint8_t reg,
+        void *in_data, size_t in_size);
+
+/**
+ * @brief Queue a read with an optional write part, like ::i2c_dev_read()
+ *
+ * For devices addressed by commands or wider register addresses.
+ * \p out_data is not copied and must stay valid until ::i2c_dev_batch_exec(),
+ * \p in_data is filled by it.
+ *
+ * @param batch Batch
+ * @param out_data Pointer to data to send if non-null
+ * @param out_size Size of data to send
+ * @param[out] in_data Pointer to input data buffer
+ * @param in_size Number of byte to read
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the batch is full
+ */
+esp_err_t i2c_dev_batch_read(i2c_dev_batch_t *batch, const void *out_data, size_t out_size,
+        void *in_data, size_t in_size);
+
+/**
+ * @brief Queue a write to register with an 8-bit address
+ *
+ * \p out_data is not copied and must stay valid until ::i2c_dev_batch_exec().
+ * There is no STOP between accesses of a batch, so devices that commit a
+ * write only on STOP (EEPROMs and the like) need ::i2c_dev_write_reg().
+ *
+ * @param batch Batch
+ * @param reg Register address
+ * @param out_data Pointer to data to send
+ * @param out_size Size of data to send
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the batch is full
+ */
+esp_err_t i2c_dev_batch_write_reg(i2c_dev_batch_t *batch, uint8_t reg,
+        const void *out_data, size_t out_size);
+
+/**
+ * @brief Keep the command list of a batch after it is run
+ *
+ * A kept batch can be run any number of times, by ::i2c_dev_batch_exec()
+ * or as an asynchronous request, including from an ISR with
+ * ::i2c_dev_async_submit_from_isr(). Free it with ::i2c_dev_batch_release().
+ *
+ * @param batch Batch
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_batch_keep(i2c_dev_batch_t *batch);
+
+/**
+ * @brief Free the command list of a batch without running it
+ *
+ * @param batch Batch
+ */
+void i2c_dev_batch_release(i2c_dev_batch_t *batch);
+
+/**
+ * @brief Send all queued accesses as one transaction and release the batch
+ *
+ * The port mutex is taken and the port is set up once for the whole batch.
+ * The batch is not released if it was marked with ::i2c_dev_batch_keep().
+ * Function is thread-safe.
+ *
+ * @param batch Batch
+ * @return ESP_OK on success, the first queueing error, or the bus error
+ */
+esp_err_t i2c_dev_batch_exec(i2c_dev_batch_t *batch);
+
+/**
+ * @brief Prepare an asynchronous request
+ *
+ * Call once per request structure.
+ *
+ * @param req Request
+ * @param cb Completion callback, may be NULL
+ * @param arg Callback argument
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_async_init(i2c_dev_async_t *req, i2c_dev_async_cb_t cb, void *arg);
+
+/**
+ * @brief Queue a request to the bus worker of its port and return
+ *
+ * Fill `req->batch` with ::i2c_dev_batch_begin() and the queueing functions
+ * first. The worker of the port is started on first use; requests of all
+ * devices on the port run one after another in submission order, each
+ * under the port mutex, so synchronous calls can be mixed in.
+ * If submitting fails, the request completes with the returned error and
+ * the callback is not called.
+ *
+ * @param req Request
+ * @return ESP_OK if queued, ESP_ERR_NO_MEM if the port queue is full,
+ *         ESP_ERR_INVALID_STATE if the request is still pending
+ */
+esp_err_t i2c_dev_async_submit(i2c_dev_async_t *req);
+
+/**
+ * @brief Start the bus worker of a port
+ *
+ * ::i2c_dev_async_submit() does it on first use; call it from a task before
+ * requests are submitted from an ISR.
+ *
+ * @param port I2C port
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_async_start(i2c_port_t port);
+
+/**
+ * @brief Queue a request to the priority lane of its port, from an ISR
+ *
+ * The request must be a kept batch (::i2c_dev_batch_keep()) filled in task
+ * context, and the worker must be running (::i2c_dev_async_start()).
+ * The worker takes priority lane requests before any queued normal
+ * request, so the latency is bounded by the worker wake-up plus the one
+ * transaction that may be on the bus already (a normal request or a
+ * synchronous call on the port) plus the priority requests queued ahead.
+ * The callback runs in the worker task: the deferred part of the ISR.
+ *
+ * @param req Request
+ * @param[out] woken Set to pdTRUE if a context switch is needed, may be NULL
+ * @return ESP_OK if queued, ESP_ERR_INVALID_STATE if the request is still
+ *         pending or the worker is not running, ESP_ERR_NO_MEM if the lane is full
+ */
+esp_err_t i2c_dev_async_submit_from_isr(i2c_dev_async_t *req, BaseType_t *woken);
+
+/**
+ * @brief Queue a read from register with an 8-bit address
+ *
+ * Shortcut to ::i2c_dev_batch_begin(), ::i2c_dev_batch_read_reg() and
+ * ::i2c_dev_async_submit(). \p in_data is valid after completion.
+ *
+ * @param req Request
+ * @param dev Device descriptor
+ * @param reg Register address
+ * @param[out] in_data Pointer to input data buffer
+ * @param in_size Number of byte to read
+ * @return ESP_OK if queued
+ */
+esp_err_t i2c_dev_read_reg_async(i2c_dev_async_t *req, const i2c_dev_t *dev, uint8_t reg,
+        void *in_data, size_t in_size);
+
+/**
+ * @brief Queue a read with an optional write part, like ::i2c_dev_read()
+ *
+ * Shortcut to ::i2c_dev_batch_begin(), ::i2c_dev_batch_read() and
+ * ::i2c_dev_async_submit(). \p out_data must stay valid and \p in_data is
+ * valid after completion.
+ *
+ * @param req Request
+ * @param dev Device descriptor
+ * @param out_data Pointer to data to send if non-null
+ * @param out_size Size of data to send
+ * @param[out] in_data Pointer to input data buffer
+ * @param in_size Number of byte to read
+ * @return ESP_OK if queued
+ */
+esp_err_t i2c_dev_read_async(i2c_dev_async_t *req, const i2c_dev_t *dev, const void *out_data, size_t out_size,
+        void *in_data, size_t in_size);
+
+/**
+ * @brief Check if a request has completed
+ *
+ * Collects the completion like ::i2c_dev_async_wait() with no timeout.
+ * Call it from the task that owns the request.
+ *
+ * @param req Request
+ * @return true when `req->result` holds the result
+ */
+bool i2c_dev_async_done(i2c_dev_async_t *req);
+
+/**
+ * @brief Wait for a request to complete
+ *
+ * @param req Request
+ * @param ticks Time to wait
+ * @return Result of the request, or ESP_ERR_TIMEOUT if it is still pending
+ */
+esp_err_t i2c_dev_async_wait(i2c_dev_async_t *req, TickType_t ticks);
+
+/**
+ * Bins of the bus time histogram in ::i2c_dev_trace_stats_t
+ */
+#define I2C_DEV_TRACE_HIST_BINS 8
+
+/**
+ * Bus statistics of one device (see CONFIG_I2CDEV_TRACE)
+ */
+typedef struct
+{
+    i2c_port_t port;          //!< I2C port number
+    uint8_t addr;             //!< Unshifted address
+    uint32_t transactions;    //!< Transactions run, including failed ones
+    uint64_t bytes;           //!< Data bytes sent and received
+    uint32_t nacks;           //!< Transactions failed with ESP_FAIL: no ACK or lost arbitration
+    uint32_t timeouts;        //!< Transactions failed with ESP_ERR_TIMEOUT
+    uint32_t errors;          //!< Other failures
+    uint64_t wait_us;         //!< Time spent waiting for the port, including its reconfiguration
+    uint64_t bus_us;          //!< Time spent in transactions
+    uint32_t max_wait_us;     //!< Longest wait for the port
+    uint32_t max_bus_us;      //!< Longest transaction
+    uint32_t hist[I2C_DEV_TRACE_HIST_BINS]; /*!< Transactions by bus time: bin 0 is below 64 us,
+                                                 every next bin is twice as wide, the last one
+                                                 is open-ended */
+} i2c_dev_trace_stats_t;
+
+/**
+ * One transaction in the trace ring
+ */
+typedef struct
+{
+    int64_t timestamp_us;     //!< Start of the transaction, esp_timer_get_time() time
+    uint32_t wait_us;         //!< Wait for the port
+    uint32_t bus_us;          //!< Transaction time
+    uint16_t bytes;           //!< Data bytes
+    uint8_t port;             //!< I2C port number
+    uint8_t addr;             //!< Unshifted address
+    esp_err_t res;            //!< Result
+} i2c_dev_trace_event_t;
+
+/**
+ * Output of ::i2c_dev_trace_dump(): one text line without a line end
+ */
+typedef void (*i2c_dev_trace_out_t)(const char *line, void *arg);
+
+/**
+ * @brief Copy the statistics of the devices seen so far
+ *
+ * @param[out] out Array for the statistics
+ * @param max Size of the array
+ * @return Number of entries copied, 0 if tracing is disabled
+ */
+size_t i2c_dev_trace_get(i2c_dev_trace_stats_t *out, size_t max);
+
+/**
+ * @brief Read transactions from the trace ring
+ *
+ * The ring is never blocked by readers: entries overwritten before they were
+ * read are skipped and counted in `lost`.
+ *
+ * @param[in,out] cursor Position in the ring, start with 0
+ * @param[out] out Array for the transactions, oldest first
+ * @param max Size of the array
+ * @param[out] lost Number of skipped entries, may be NULL
+ * @return Number of entries copied
+ */
+size_t i2c_dev_trace_read(uint32_t *cursor, i2c_dev_trace_event_t *out, size_t max, uint32_t *lost);
+
+/**
+ * @brief Format the statistics as text, one line per device
+ *
+ * Lines are `i2c P:AA n=... B=... wait=.../... bus=.../... nack=... tmo=... err=... hist=...`,
+ * with totals and maximums in microseconds. Use it to send the statistics
+ * over a serial link or to write them to a log.
+ *
+ * @param out Line output
+ * @param arg Argument of `out`
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if tracing is disabled
+ */
+esp_err_t i2c_dev_trace_dump(i2c_dev_trace_out_t out, void *arg);
+
+/**
+ * @brief Clear the statistics of all devices
+ *
+ * Transactions running during the reset may be counted partially.
+ */
+void i2c_dev_trace_reset(void);
+
 #define I2C_DEV_TAKE_MUTEX(dev) do { \
         esp_err_t __ = i2c_dev_take_mutex(dev); \
         if (__ != ESP_OK) return __;\
@@ -0,0 +1,247 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 deity
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file i2cdev_trace.c
+ *
+ * Bus statistics per device and a ring of the last transactions
+ *
+ * Copyright (c) 2026 deity
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include "i2cdev_trace.h"
+
+#if CONFIG_I2CDEV_TRACE
+
+#define RING_MASK (CONFIG_I2CDEV_TRACE_RING_LEN - 1)
+
+_Static_assert((CONFIG_I2CDEV_TRACE_RING_LEN & RING_MASK) == 0, "CONFIG_I2CDEV_TRACE_RING_LEN must be a power of two");
+
+#define DEV_KEY(port, addr) (0x10000u | ((unsigned)(port) << 8) | (addr))
+
+typedef struct
+{
+    atomic_uint key;          //!< DEV_KEY() of the device, 0 if the entry is free
+    i2c_dev_trace_stats_t st;
+} trace_dev_t;
+
+typedef struct
+{
+    atomic_uint seq;          //!< Ring position + 1 once the event is written, 0 while it is
+    i2c_dev_trace_event_t ev;
+} trace_slot_t;
+
+static trace_dev_t devs[CONFIG_I2CDEV_TRACE_DEVICES];
+static trace_slot_t ring[CONFIG_I2CDEV_TRACE_RING_LEN];
+static atomic_uint head;
+
+// Entries are only ever claimed, devices on different ports may race for one
+static trace_dev_t *find_dev(const i2c_dev_t *dev)
+{
+    unsigned key = DEV_KEY(dev->port, dev->addr);
+
+    for (size_t i = 0; i < CONFIG_I2CDEV_TRACE_DEVICES; i++)
+    {
+        unsigned cur = atomic_load_explicit(&devs[i].key, memory_order_acquire);
+        if (cur == key)
+            return &devs[i];
+        if (!cur)
+        {
+            if (atomic_compare_exchange_strong(&devs[i].key, &cur, key) || cur == key)
+                return &devs[i];
+        }
+    }
+    return NULL;
+}
+
+static unsigned hist_bin(uint32_t us)
+{
+    unsigned bin = 0;
+    for (us >>= 6; us && bin < I2C_DEV_TRACE_HIST_BINS - 1; us >>= 1)
+        bin++;
+    return bin;
+}
+
+void i2c_dev_trace_record(const i2c_dev_t *dev, size_t bytes, int64_t t_wait, int64_t t_bus, esp_err_t res)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t wait_us = (uint32_t)(t_bus - t_wait);
+    uint32_t bus_us = (uint32_t)(now - t_bus);
+
+    trace_dev_t *d = find_dev(dev);
+    if (d)
+    {
+        i2c_dev_trace_stats_t *st = &d->st;
+        st->transactions++;
+        st->bytes += bytes;
+        if (res == ESP_FAIL)
+            st->nacks++;
+        else if (res == ESP_ERR_TIMEOUT)
+            st->timeouts++;
+        else if (res != ESP_OK)
+            st->errors++;
+        st->wait_us += wait_us;
+        st->bus_us += bus_us;
+        if (wait_us > st->max_wait_us)
+            st->max_wait_us = wait_us;
+        if (bus_us > st->max_bus_us)
+            st->max_bus_us = bus_us;
+        st->hist[hist_bin(bus_us)]++;
+    }
+
+    // ports write the ring concurrently: each takes its own position
+    unsigned pos = atomic_fetch_add_explicit(&head, 1, memory_order_relaxed);
+    trace_slot_t *slot = &ring[pos & RING_MASK];
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->ev.timestamp_us = t_bus;
+    slot->ev.wait_us = wait_us;
+    slot->ev.bus_us = bus_us;
+    slot->ev.bytes = bytes > UINT16_MAX ? UINT16_MAX : (uint16_t)bytes;
+    slot->ev.port = dev->port;
+    slot->ev.addr = dev->addr;
+    slot->ev.res = res;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+}
+
+static bool copy_dev(size_t i, i2c_dev_trace_stats_t *out)
+{
+    unsigned key = atomic_load_explicit(&devs[i].key, memory_order_acquire);
+    if (!key) return false;
+
+    *out = devs[i].st;
+    out->port = (key >> 8) & 0xff;
+    out->addr = key & 0xff;
+    return true;
+}
+
+size_t i2c_dev_trace_get(i2c_dev_trace_stats_t *out, size_t max)
+{
+    if (!out) return 0;
+
+    size_t n = 0;
+    for (size_t i = 0; i < CONFIG_I2CDEV_TRACE_DEVICES && n < max; i++)
+    {
+        if (copy_dev(i, &out[n]))
+            n++;
+    }
+    return n;
+}
+
+size_t i2c_dev_trace_read(uint32_t *cursor, i2c_dev_trace_event_t *out, size_t max, uint32_t *lost)
+{
+    if (lost) *lost = 0;
+    if (!cursor || !out) return 0;
+
+    unsigned end = atomic_load_explicit(&head, memory_order_acquire);
+    unsigned pos = *cursor;
+    uint32_t skipped = 0;
+    if (end - pos > CONFIG_I2CDEV_TRACE_RING_LEN)
+    {
+        skipped = end - pos - CONFIG_I2CDEV_TRACE_RING_LEN;
+        pos = end - CONFIG_I2CDEV_TRACE_RING_LEN;
+    }
+
+    size_t n = 0;
+    for (; pos != end && n < max; pos++)
+    {
+        trace_slot_t *slot = &ring[pos & RING_MASK];
+        unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        // not written yet: read it next time
+        if (!seq || (int)(seq - (pos + 1)) < 0)
+            break;
+        if (seq == pos + 1)
+        {
+            out[n] = slot->ev;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&slot->seq, memory_order_relaxed) == pos + 1)
+            {
+                n++;
+                continue;
+            }
+        }
+        // overwritten by a newer event
+        skipped++;
+    }
+
+    *cursor = pos;
+    if (lost) *lost = skipped;
+    return n;
+}
+
+esp_err_t i2c_dev_trace_dump(i2c_dev_trace_out_t out, void *arg)
+{
+    if (!out) return ESP_ERR_INVALID_ARG;
+
+    char line[200];
+    i2c_dev_trace_stats_t st;
+    for (size_t i = 0; i < CONFIG_I2CDEV_TRACE_DEVICES; i++)
+    {
+        if (!copy_dev(i, &st)) continue;
+
+        int n = snprintf(line, sizeof(line),
+                "i2c %d:%02x n=%" PRIu32 " B=%" PRIu64 " wait=%" PRIu64 "/%" PRIu32 " bus=%" PRIu64 "/%" PRIu32
+                " nack=%" PRIu32 " tmo=%" PRIu32 " err=%" PRIu32 " hist=",
+                (int)st.port, st.addr, st.transactions, st.bytes, st.wait_us, st.max_wait_us,
+                st.bus_us, st.max_bus_us, st.nacks, st.timeouts, st.errors);
+        for (unsigned b = 0; b < I2C_DEV_TRACE_HIST_BINS && n > 0 && (size_t)n < sizeof(line); b++)
+            n += snprintf(line + n, sizeof(line) - n, b ? "/%" PRIu32 : "%" PRIu32, st.hist[b]);
+        out(line, arg);
+    }
+    return ESP_OK;
+}
+
+void i2c_dev_trace_reset(void)
+{
+    for (size_t i = 0; i < CONFIG_I2CDEV_TRACE_DEVICES; i++)
+        memset(&devs[i].st, 0, sizeof(devs[i].st));
+}
+
+#else
+
+size_t i2c_dev_trace_get(i2c_dev_trace_stats_t *out, size_t max)
+{
+    return 0;
+}
+
+size_t i2c_dev_trace_read(uint32_t *cursor, i2c_dev_trace_event_t *out, size_t max, uint32_t *lost)
+{
+    if (lost) *lost = 0;
+    return 0;
+}
+
+esp_err_t i2c_dev_trace_dump(i2c_dev_trace_out_t out, void *arg)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void i2c_dev_trace_reset(void)
+{
+}
+
+#endif /* CONFIG_I2CDEV_TRACE */
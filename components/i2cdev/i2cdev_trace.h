@@ -0,0 +1,64 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 deity
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file i2cdev_trace.h
+ *
+ * Private hooks of the i2cdev bus statistics, see CONFIG_I2CDEV_TRACE
+ *
+ * Copyright (c) 2026 deity
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __I2CDEV_TRACE_H__
+#define __I2CDEV_TRACE_H__
+
+#include "i2cdev.h"
+
+#if CONFIG_I2CDEV_TRACE
+
+#include <esp_timer.h>
+
+/**
+ * Account one transaction of `dev`. Called with the port mutex held, so
+ * the counters of a device are never updated concurrently.
+ *
+ * @param dev Device
+ * @param bytes Data bytes
+ * @param t_wait Time the caller started to wait for the port
+ * @param t_bus Time the transaction started
+ * @param res Result of the transaction
+ */
+void i2c_dev_trace_record(const i2c_dev_t *dev, size_t bytes, int64_t t_wait, int64_t t_bus, esp_err_t res);
+
+#define I2CDEV_TRACE_MARK(t) int64_t t = esp_timer_get_time()
+#define I2CDEV_TRACE_RECORD(dev, bytes, t_wait, t_bus, res) i2c_dev_trace_record(dev, bytes, t_wait, t_bus, res)
+
+#else
+
+#define I2CDEV_TRACE_MARK(t)
+#define I2CDEV_TRACE_RECORD(dev, bytes, t_wait, t_bus, res)
+
+#endif /* CONFIG_I2CDEV_TRACE */
+
+#endif /* __I2CDEV_TRACE_H__ */
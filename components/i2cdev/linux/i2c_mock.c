@@ -0,0 +1,329 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 deity
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file i2c_mock.c
+ *
+ * Emulated I2C bus for host builds (linux target)
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include "i2c_mock.h"
+
+static const char *TAG = "i2c_mock";
+
+#define DEFAULT_CLK_SPEED 100000
+
+typedef enum {
+    OP_START = 0,
+    OP_WRITE,
+    OP_READ,
+    OP_STOP,
+} op_kind_t;
+
+typedef struct
+{
+    union
+    {
+        const uint8_t *w;
+        uint8_t *r;
+    } data;
+    uint32_t len;
+    uint8_t kind;
+    uint8_t byte;  //!< Data of i2c_master_write_byte(), data.w points here
+} op_t;
+
+typedef struct
+{
+    op_t *ops;
+    size_t count;
+    size_t cap;
+    bool is_static;
+} link_t;
+
+_Static_assert(sizeof(op_t) <= I2C_INTERNAL_STRUCT_SIZE, "op does not fit I2C_LINK_RECOMMENDED_SIZE");
+_Static_assert(sizeof(link_t) <= 2 * I2C_INTERNAL_STRUCT_SIZE, "link does not fit I2C_LINK_RECOMMENDED_SIZE");
+
+typedef struct
+{
+    uint8_t addr;
+    uint8_t *regs;
+    size_t size;
+    size_t ptr;
+    i2c_port_t port;
+} device_t;
+
+typedef struct
+{
+    bool installed;
+    uint32_t clk_speed;
+    int timeout;
+    i2c_mock_stats_t stats;
+    uint64_t bus_bits;
+} port_t;
+
+static port_t ports[I2C_NUM_MAX];
+static device_t devices[I2C_MOCK_MAX_DEVICES];
+static size_t device_count;
+
+esp_err_t i2c_mock_add_device(i2c_port_t port, uint8_t addr, uint8_t *regs, size_t size)
+{
+    if (port >= I2C_NUM_MAX || !regs || !size) return ESP_ERR_INVALID_ARG;
+    if (device_count >= I2C_MOCK_MAX_DEVICES) return ESP_ERR_NO_MEM;
+
+    devices[device_count++] = (device_t){ .addr = addr, .regs = regs, .size = size, .port = port };
+    return ESP_OK;
+}
+
+void i2c_mock_get_stats(i2c_port_t port, i2c_mock_stats_t *stats)
+{
+    if (port >= I2C_NUM_MAX || !stats) return;
+    *stats = ports[port].stats;
+    uint32_t clk = ports[port].clk_speed ? ports[port].clk_speed : DEFAULT_CLK_SPEED;
+    stats->bus_us = ports[port].bus_bits * 1000000 / clk;
+}
+
+void i2c_mock_reset_stats(i2c_port_t port)
+{
+    if (port >= I2C_NUM_MAX) return;
+    memset(&ports[port].stats, 0, sizeof(ports[port].stats));
+    ports[port].bus_bits = 0;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_buf_len,
+        size_t slv_tx_buf_len, int intr_alloc_flags)
+{
+    if (i2c_num >= I2C_NUM_MAX || mode != I2C_MODE_MASTER) return ESP_ERR_INVALID_ARG;
+    if (ports[i2c_num].installed) return ESP_FAIL;
+    ports[i2c_num].installed = true;
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_delete(i2c_port_t i2c_num)
+{
+    if (i2c_num >= I2C_NUM_MAX || !ports[i2c_num].installed) return ESP_ERR_INVALID_STATE;
+    ports[i2c_num].installed = false;
+    return ESP_OK;
+}
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t *i2c_conf)
+{
+    if (i2c_num >= I2C_NUM_MAX || !i2c_conf) return ESP_ERR_INVALID_ARG;
+    ports[i2c_num].clk_speed = i2c_conf->master.clk_speed;
+    return ESP_OK;
+}
+
+esp_err_t i2c_set_timeout(i2c_port_t i2c_num, int timeout)
+{
+    if (i2c_num >= I2C_NUM_MAX || timeout <= 0) return ESP_ERR_INVALID_ARG;
+    ports[i2c_num].timeout = timeout;
+    return ESP_OK;
+}
+
+esp_err_t i2c_get_timeout(i2c_port_t i2c_num, int *timeout)
+{
+    if (i2c_num >= I2C_NUM_MAX || !timeout) return ESP_ERR_INVALID_ARG;
+    *timeout = ports[i2c_num].timeout;
+    return ESP_OK;
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create(void)
+{
+    return calloc(1, sizeof(link_t));
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t *buffer, uint32_t size)
+{
+    if (!buffer || size < sizeof(link_t)) return NULL;
+
+    link_t *link = (link_t *)buffer;
+    link->ops = (op_t *)(buffer + 2 * I2C_INTERNAL_STRUCT_SIZE);
+    link->count = 0;
+    // as many commands as the driver fits, whatever the size of op_t
+    link->cap = size > 2 * I2C_INTERNAL_STRUCT_SIZE ? (size - 2 * I2C_INTERNAL_STRUCT_SIZE) / I2C_INTERNAL_STRUCT_SIZE : 0;
+    link->is_static = true;
+    return link;
+}
+
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd_handle)
+{
+    link_t *link = cmd_handle;
+    if (!link) return;
+    free(link->ops);
+    free(link);
+}
+
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd_handle)
+{
+}
+
+static op_t *add_op(i2c_cmd_handle_t cmd_handle, op_kind_t kind)
+{
+    link_t *link = cmd_handle;
+    if (!link) return NULL;
+
+    if (link->count == link->cap)
+    {
+        if (link->is_static) return NULL;
+        size_t cap = link->cap ? link->cap * 2 : 8;
+        op_t *ops = realloc(link->ops, cap * sizeof(op_t));
+        if (!ops) return NULL;
+        link->ops = ops;
+        link->cap = cap;
+    }
+    op_t *op = &link->ops[link->count++];
+    memset(op, 0, sizeof(*op));
+    op->kind = kind;
+    return op;
+}
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd_handle)
+{
+    return add_op(cmd_handle, OP_START) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd_handle, uint8_t data, bool ack_en)
+{
+    op_t *op = add_op(cmd_handle, OP_WRITE);
+    if (!op) return ESP_ERR_NO_MEM;
+    op->byte = data;
+    op->len = 1;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd_handle, const uint8_t *data, size_t data_len, bool ack_en)
+{
+    if (!data || !data_len) return ESP_ERR_INVALID_ARG;
+    op_t *op = add_op(cmd_handle, OP_WRITE);
+    if (!op) return ESP_ERR_NO_MEM;
+    op->data.w = data;
+    op->len = data_len;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd_handle, uint8_t *data, size_t data_len, i2c_ack_type_t ack)
+{
+    if (!data || !data_len) return ESP_ERR_INVALID_ARG;
+    // like the driver: all bytes but the last ACKed in one command, the last one NACKed in another
+    if (ack == I2C_MASTER_LAST_NACK && data_len > 1)
+    {
+        esp_err_t res = i2c_master_read(cmd_handle, data, data_len - 1, I2C_MASTER_ACK);
+        if (res != ESP_OK) return res;
+        return i2c_master_read(cmd_handle, data + data_len - 1, 1, I2C_MASTER_NACK);
+    }
+    op_t *op = add_op(cmd_handle, OP_READ);
+    if (!op) return ESP_ERR_NO_MEM;
+    op->data.r = data;
+    op->len = data_len;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd_handle)
+{
+    return add_op(cmd_handle, OP_STOP) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static device_t *find_device(i2c_port_t port, uint8_t addr)
+{
+    for (size_t i = 0; i < device_count; i++)
+        if (devices[i].port == port && devices[i].addr == addr)
+            return &devices[i];
+    return NULL;
+}
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd_handle, TickType_t ticks_to_wait)
+{
+    if (i2c_num >= I2C_NUM_MAX || !cmd_handle) return ESP_ERR_INVALID_ARG;
+    if (!ports[i2c_num].installed) return ESP_ERR_INVALID_STATE;
+
+    port_t *p = &ports[i2c_num];
+    link_t *link = cmd_handle;
+    device_t *dev = NULL;
+    bool addressed = false; // next written byte is the address
+    bool reg_set = false;   // register pointer written in this write phase
+
+    p->stats.transactions++;
+
+    for (size_t i = 0; i < link->count; i++)
+    {
+        op_t *op = &link->ops[i];
+        switch (op->kind)
+        {
+            case OP_START:
+                p->stats.starts++;
+                p->bus_bits += 1;
+                addressed = true;
+                break;
+            case OP_STOP:
+                p->bus_bits += 1;
+                dev = NULL;
+                break;
+            case OP_WRITE:
+            {
+                const uint8_t *data = op->data.w ? op->data.w : &op->byte;
+                for (uint32_t n = 0; n < op->len; n++)
+                {
+                    // 8 data bits and ACK
+                    p->bus_bits += 9;
+                    p->stats.bytes++;
+                    if (addressed)
+                    {
+                        addressed = false;
+                        dev = find_device(i2c_num, data[n] >> 1);
+                        reg_set = false;
+                        if (!dev)
+                        {
+                            p->stats.nacks++;
+                            ESP_LOGD(TAG, "No device at 0x%02x on port %d", data[n] >> 1, i2c_num);
+                            return ESP_FAIL;
+                        }
+                        continue;
+                    }
+                    if (!reg_set)
+                    {
+                        dev->ptr = data[n] % dev->size;
+                        reg_set = true;
+                        continue;
+                    }
+                    dev->regs[dev->ptr] = data[n];
+                    dev->ptr = (dev->ptr + 1) % dev->size;
+                }
+                break;
+            }
+            case OP_READ:
+                if (!dev) return ESP_FAIL;
+                for (uint32_t n = 0; n < op->len; n++)
+                {
+                    p->bus_bits += 9;
+                    p->stats.bytes++;
+                    op->data.r[n] = dev->regs[dev->ptr];
+                    dev->ptr = (dev->ptr + 1) % dev->size;
+                }
+                break;
+        }
+    }
+    return ESP_OK;
+}
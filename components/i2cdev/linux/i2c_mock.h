@@ -0,0 +1,94 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 deity
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file i2c_mock.h
+ * @defgroup i2c_mock i2c_mock
+ * @{
+ *
+ * Emulated I2C bus for host builds (linux target)
+ *
+ * Devices are register files: the first byte written after the address sets
+ * the register pointer, further writes and reads auto-increment it. The bus
+ * counts driver transactions, START conditions and bytes and accumulates
+ * the time they would take on the wire at the configured clock, so the
+ * cost of an access pattern can be compared without hardware.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __I2C_MOCK_H__
+#define __I2C_MOCK_H__
+
+#include <driver/i2c.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define I2C_MOCK_MAX_DEVICES 8
+
+/**
+ * Bus counters
+ */
+typedef struct
+{
+    uint32_t transactions; //!< i2c_master_cmd_begin() calls
+    uint32_t starts;       //!< START and repeated START conditions
+    uint32_t bytes;        //!< Bytes on the wire, address bytes included
+    uint32_t nacks;        //!< Addresses nobody answered
+    uint64_t bus_us;       //!< Time on the wire at the port clock
+} i2c_mock_stats_t;
+
+/**
+ * @brief Attach an emulated device to the bus
+ *
+ * @param port I2C port
+ * @param addr Unshifted address
+ * @param regs Register file, owned by the caller
+ * @param size Register file size
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if I2C_MOCK_MAX_DEVICES are attached
+ */
+esp_err_t i2c_mock_add_device(i2c_port_t port, uint8_t addr, uint8_t *regs, size_t size);
+
+/**
+ * @brief Get bus counters
+ *
+ * @param port I2C port
+ * @param[out] stats Counters since start or last reset
+ */
+void i2c_mock_get_stats(i2c_port_t port, i2c_mock_stats_t *stats);
+
+/**
+ * @brief Reset bus counters
+ *
+ * @param port I2C port
+ */
+void i2c_mock_reset_stats(i2c_port_t port);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __I2C_MOCK_H__ */
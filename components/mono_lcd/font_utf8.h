@@ -0,0 +1,352 @@
+//
+// Created by deity on 17.10.2026.
+//
+
+#ifndef FONT_UTF8_H
+#define FONT_UTF8_H
+#include <stdint.h>
+
+// Пропорциональный шрифт 8 px: ASCII, кириллица (А-я, Ё, ё) и знак градуса.
+// font_glyphs отсортирован по кодовой точке, у каждого символа ширина без
+// пустых столбцов по краям и смещение его столбцов в font_cols (байт на
+// столбец, бит 0 - верхняя строка). Пробел - только ширина, столбцов нет.
+// Между символами при выводе добавляется один пустой столбец.
+typedef struct {
+    uint16_t cp;
+    uint8_t  width;
+    uint16_t offset;
+} font_glyph_t;
+
+#define FONT_GAP        1
+#define FONT_FALLBACK   '?'
+
+static const font_glyph_t font_glyphs[] = {
+    {0x0020, 3,    0},   // ' '
+    {0x0021, 2,    0},   // !
+    {0x0022, 3,    2},   // "
+    {0x0023, 5,    5},   // #
+    {0x0024, 5,   10},   // $
+    {0x0025, 5,   15},   // %
+    {0x0026, 5,   20},   // &
+    {0x0027, 1,   25},   // '
+    {0x0028, 3,   26},   // (
+    {0x0029, 3,   29},   // )
+    {0x002A, 5,   32},   // *
+    {0x002B, 5,   37},   // +
+    {0x002C, 2,   42},   // ,
+    {0x002D, 4,   44},   // -
+    {0x002E, 2,   48},   // .
+    {0x002F, 5,   50},   // /
+    {0x0030, 5,   55},   // 0
+    {0x0031, 3,   60},   // 1
+    {0x0032, 5,   63},   // 2
+    {0x0033, 5,   68},   // 3
+    {0x0034, 5,   73},   // 4
+    {0x0035, 5,   78},   // 5
+    {0x0036, 5,   83},   // 6
+    {0x0037, 5,   88},   // 7
+    {0x0038, 5,   93},   // 8
+    {0x0039, 5,   98},   // 9
+    {0x003A, 2,  103},   // :
+    {0x003B, 2,  105},   // ;
+    {0x003C, 4,  107},   // <
+    {0x003D, 5,  111},   // =
+    {0x003E, 4,  116},   // >
+    {0x003F, 5,  120},   // ?
+    {0x0040, 5,  125},   // @
+    {0x0041, 5,  130},   // A
+    {0x0042, 5,  135},   // B
+    {0x0043, 5,  140},   // C
+    {0x0044, 5,  145},   // D
+    {0x0045, 5,  150},   // E
+    {0x0046, 5,  155},   // F
+    {0x0047, 5,  160},   // G
+    {0x0048, 5,  165},   // H
+    {0x0049, 3,  170},   // I
+    {0x004A, 5,  173},   // J
+    {0x004B, 5,  178},   // K
+    {0x004C, 5,  183},   // L
+    {0x004D, 5,  188},   // M
+    {0x004E, 5,  193},   // N
+    {0x004F, 5,  198},   // O
+    {0x0050, 5,  203},   // P
+    {0x0051, 5,  208},   // Q
+    {0x0052, 5,  213},   // R
+    {0x0053, 5,  218},   // S
+    {0x0054, 5,  223},   // T
+    {0x0055, 5,  228},   // U
+    {0x0056, 5,  233},   // V
+    {0x0057, 5,  238},   // W
+    {0x0058, 5,  243},   // X
+    {0x0059, 5,  248},   // Y
+    {0x005A, 5,  253},   // Z
+    {0x005B, 3,  258},   // [
+    {0x005C, 5,  261},   // '\'
+    {0x005D, 3,  266},   // ]
+    {0x005E, 5,  269},   // ^
+    {0x005F, 5,  274},   // _
+    {0x0060, 3,  279},   // `
+    {0x0061, 5,  282},   // a
+    {0x0062, 5,  287},   // b
+    {0x0063, 5,  292},   // c
+    {0x0064, 5,  297},   // d
+    {0x0065, 5,  302},   // e
+    {0x0066, 5,  307},   // f
+    {0x0067, 5,  312},   // g
+    {0x0068, 5,  317},   // h
+    {0x0069, 3,  322},   // i
+    {0x006A, 4,  325},   // j
+    {0x006B, 4,  329},   // k
+    {0x006C, 3,  333},   // l
+    {0x006D, 5,  336},   // m
+    {0x006E, 5,  341},   // n
+    {0x006F, 5,  346},   // o
+    {0x0070, 5,  351},   // p
+    {0x0071, 5,  356},   // q
+    {0x0072, 5,  361},   // r
+    {0x0073, 5,  366},   // s
+    {0x0074, 5,  371},   // t
+    {0x0075, 5,  376},   // u
+    {0x0076, 5,  381},   // v
+    {0x0077, 5,  386},   // w
+    {0x0078, 5,  391},   // x
+    {0x0079, 5,  396},   // y
+    {0x007A, 5,  401},   // z
+    {0x007B, 3,  406},   // {
+    {0x007C, 1,  409},   // |
+    {0x007D, 3,  410},   // }
+    {0x007E, 5,  413},   // ~
+    {0x00B0, 4,  418},   // °
+    {0x0401, 5,  422},   // Ё
+    {0x0410, 5,  427},   // А
+    {0x0411, 5,  432},   // Б
+    {0x0412, 5,  437},   // В
+    {0x0413, 5,  442},   // Г
+    {0x0414, 5,  447},   // Д
+    {0x0415, 5,  452},   // Е
+    {0x0416, 5,  457},   // Ж
+    {0x0417, 5,  462},   // З
+    {0x0418, 5,  467},   // И
+    {0x0419, 5,  472},   // Й
+    {0x041A, 5,  477},   // К
+    {0x041B, 5,  482},   // Л
+    {0x041C, 5,  487},   // М
+    {0x041D, 5,  492},   // Н
+    {0x041E, 5,  497},   // О
+    {0x041F, 5,  502},   // П
+    {0x0420, 5,  507},   // Р
+    {0x0421, 5,  512},   // С
+    {0x0422, 5,  517},   // Т
+    {0x0423, 5,  522},   // У
+    {0x0424, 5,  527},   // Ф
+    {0x0425, 5,  532},   // Х
+    {0x0426, 5,  537},   // Ц
+    {0x0427, 5,  542},   // Ч
+    {0x0428, 5,  547},   // Ш
+    {0x0429, 6,  552},   // Щ
+    {0x042A, 5,  558},   // Ъ
+    {0x042B, 5,  563},   // Ы
+    {0x042C, 5,  568},   // Ь
+    {0x042D, 5,  573},   // Э
+    {0x042E, 5,  578},   // Ю
+    {0x042F, 5,  583},   // Я
+    {0x0430, 5,  588},   // а
+    {0x0431, 5,  593},   // б
+    {0x0432, 5,  598},   // в
+    {0x0433, 5,  603},   // г
+    {0x0434, 5,  608},   // д
+    {0x0435, 5,  613},   // е
+    {0x0436, 5,  618},   // ж
+    {0x0437, 5,  623},   // з
+    {0x0438, 5,  628},   // и
+    {0x0439, 5,  633},   // й
+    {0x043A, 4,  638},   // к
+    {0x043B, 5,  642},   // л
+    {0x043C, 5,  647},   // м
+    {0x043D, 5,  652},   // н
+    {0x043E, 5,  657},   // о
+    {0x043F, 5,  662},   // п
+    {0x0440, 5,  667},   // р
+    {0x0441, 5,  672},   // с
+    {0x0442, 5,  677},   // т
+    {0x0443, 5,  682},   // у
+    {0x0444, 5,  687},   // ф
+    {0x0445, 5,  692},   // х
+    {0x0446, 5,  697},   // ц
+    {0x0447, 5,  702},   // ч
+    {0x0448, 5,  707},   // ш
+    {0x0449, 6,  712},   // щ
+    {0x044A, 5,  718},   // ъ
+    {0x044B, 5,  723},   // ы
+    {0x044C, 5,  728},   // ь
+    {0x044D, 5,  733},   // э
+    {0x044E, 5,  738},   // ю
+    {0x044F, 5,  743},   // я
+    {0x0451, 5,  748},   // ё
+};
+
+static const uint8_t font_cols[] = {
+    0x5F,0x5F,                      // !
+    0x07,0x00,0x07,                 // "
+    0x14,0x7F,0x14,0x7F,0x14,       // #
+    0x24,0x2A,0x7F,0x2A,0x12,       // $
+    0x23,0x13,0x08,0x64,0x62,       // %
+    0x36,0x49,0x56,0x20,0x50,       // &
+    0x07,                           // '
+    0x1C,0x22,0x41,                 // (
+    0x41,0x22,0x1C,                 // )
+    0x2A,0x1C,0x7F,0x1C,0x2A,       // *
+    0x08,0x08,0x3E,0x08,0x08,       // +
+    0x50,0x30,                      // ,
+    0x08,0x08,0x08,0x08,            // -
+    0x60,0x60,                      // .
+    0x20,0x10,0x08,0x04,0x02,       // /
+    0x3E,0x51,0x49,0x45,0x3E,       // 0
+    0x42,0x7F,0x40,                 // 1
+    0x42,0x61,0x51,0x49,0x46,       // 2
+    0x21,0x41,0x45,0x4B,0x31,       // 3
+    0x18,0x14,0x12,0x7F,0x10,       // 4
+    0x27,0x45,0x45,0x45,0x39,       // 5
+    0x3C,0x4A,0x49,0x49,0x30,       // 6
+    0x01,0x71,0x09,0x05,0x03,       // 7
+    0x36,0x49,0x49,0x49,0x36,       // 8
+    0x06,0x49,0x49,0x29,0x1E,       // 9
+    0x36,0x36,                      // :
+    0x56,0x36,                      // ;
+    0x08,0x14,0x22,0x41,            // <
+    0x14,0x14,0x14,0x14,0x14,       // =
+    0x41,0x22,0x14,0x08,            // >
+    0x02,0x01,0x51,0x09,0x06,       // ?
+    0x32,0x49,0x79,0x41,0x3E,       // @
+    0x7E,0x11,0x11,0x11,0x7E,       // A
+    0x7F,0x49,0x49,0x49,0x36,       // B
+    0x3E,0x41,0x41,0x41,0x22,       // C
+    0x7F,0x41,0x41,0x22,0x1C,       // D
+    0x7F,0x49,0x49,0x49,0x41,       // E
+    0x7F,0x09,0x09,0x09,0x01,       // F
+    0x3E,0x41,0x49,0x49,0x7A,       // G
+    0x7F,0x08,0x08,0x08,0x7F,       // H
+    0x41,0x7F,0x41,                 // I
+    0x20,0x40,0x41,0x3F,0x01,       // J
+    0x7F,0x08,0x14,0x22,0x41,       // K
+    0x7F,0x40,0x40,0x40,0x40,       // L
+    0x7F,0x02,0x0C,0x02,0x7F,       // M
+    0x7F,0x04,0x08,0x10,0x7F,       // N
+    0x3E,0x41,0x41,0x41,0x3E,       // O
+    0x7F,0x09,0x09,0x09,0x06,       // P
+    0x3E,0x41,0x51,0x21,0x5E,       // Q
+    0x7F,0x09,0x19,0x29,0x46,       // R
+    0x46,0x49,0x49,0x49,0x31,       // S
+    0x01,0x01,0x7F,0x01,0x01,       // T
+    0x3F,0x40,0x40,0x40,0x3F,       // U
+    0x1F,0x20,0x40,0x20,0x1F,       // V
+    0x3F,0x40,0x38,0x40,0x3F,       // W
+    0x63,0x14,0x08,0x14,0x63,       // X
+    0x07,0x08,0x70,0x08,0x07,       // Y
+    0x61,0x51,0x49,0x45,0x43,       // Z
+    0x7F,0x41,0x41,                 // [
+    0x02,0x04,0x08,0x10,0x20,       // '\'
+    0x41,0x41,0x7F,                 // ]
+    0x04,0x02,0x01,0x02,0x04,       // ^
+    0x40,0x40,0x40,0x40,0x40,       // _
+    0x01,0x02,0x04,                 // `
+    0x20,0x54,0x54,0x54,0x78,       // a
+    0x7F,0x48,0x44,0x44,0x38,       // b
+    0x38,0x44,0x44,0x44,0x20,       // c
+    0x38,0x44,0x44,0x48,0x7F,       // d
+    0x38,0x54,0x54,0x54,0x18,       // e
+    0x08,0x7E,0x09,0x01,0x02,       // f
+    0x0C,0x52,0x52,0x52,0x3E,       // g
+    0x7F,0x08,0x04,0x04,0x78,       // h
+    0x44,0x7D,0x40,                 // i
+    0x20,0x40,0x44,0x3D,            // j
+    0x7F,0x10,0x28,0x44,            // k
+    0x41,0x7F,0x40,                 // l
+    0x7C,0x04,0x18,0x04,0x78,       // m
+    0x7C,0x08,0x04,0x04,0x78,       // n
+    0x38,0x44,0x44,0x44,0x38,       // o
+    0x7C,0x14,0x14,0x14,0x08,       // p
+    0x08,0x14,0x14,0x18,0x7C,       // q
+    0x7C,0x08,0x04,0x04,0x08,       // r
+    0x48,0x54,0x54,0x54,0x20,       // s
+    0x04,0x3F,0x44,0x40,0x20,       // t
+    0x3C,0x40,0x40,0x20,0x7C,       // u
+    0x1C,0x20,0x40,0x20,0x1C,       // v
+    0x3C,0x40,0x30,0x40,0x3C,       // w
+    0x44,0x28,0x10,0x28,0x44,       // x
+    0x0C,0x50,0x50,0x50,0x3C,       // y
+    0x44,0x64,0x54,0x4C,0x44,       // z
+    0x08,0x36,0x41,                 // {
+    0x7F,                           // |
+    0x41,0x36,0x08,                 // }
+    0x10,0x08,0x08,0x10,0x08,       // ~
+    0x06,0x09,0x09,0x06,            // °
+    0x7C,0x55,0x54,0x55,0x44,       // Ё
+    0x7E,0x11,0x11,0x11,0x7E,       // А
+    0x7F,0x49,0x49,0x49,0x31,       // Б
+    0x7F,0x49,0x49,0x49,0x36,       // В
+    0x7F,0x01,0x01,0x01,0x01,       // Г
+    0x60,0x3F,0x21,0x3F,0x60,       // Д
+    0x7F,0x49,0x49,0x49,0x41,       // Е
+    0x63,0x14,0x7F,0x14,0x63,       // Ж
+    0x22,0x41,0x49,0x49,0x36,       // З
+    0x7F,0x10,0x08,0x04,0x7F,       // И
+    0x7E,0x10,0x09,0x04,0x7E,       // Й
+    0x7F,0x08,0x14,0x22,0x41,       // К
+    0x40,0x3E,0x01,0x01,0x7F,       // Л
+    0x7F,0x02,0x0C,0x02,0x7F,       // М
+    0x7F,0x08,0x08,0x08,0x7F,       // Н
+    0x3E,0x41,0x41,0x41,0x3E,       // О
+    0x7F,0x01,0x01,0x01,0x7F,       // П
+    0x7F,0x09,0x09,0x09,0x06,       // Р
+    0x3E,0x41,0x41,0x41,0x22,       // С
+    0x01,0x01,0x7F,0x01,0x01,       // Т
+    0x27,0x48,0x48,0x48,0x3F,       // У
+    0x1C,0x22,0x7F,0x22,0x1C,       // Ф
+    0x63,0x14,0x08,0x14,0x63,       // Х
+    0x3F,0x20,0x20,0x3F,0x60,       // Ц
+    0x07,0x08,0x08,0x08,0x7F,       // Ч
+    0x7F,0x40,0x7C,0x40,0x7F,       // Ш
+    0x3F,0x20,0x3F,0x20,0x3F,0x60,  // Щ
+    0x01,0x7F,0x48,0x48,0x30,       // Ъ
+    0x7F,0x48,0x78,0x00,0x7F,       // Ы
+    0x7F,0x48,0x48,0x48,0x30,       // Ь
+    0x22,0x41,0x49,0x49,0x3E,       // Э
+    0x7F,0x08,0x3E,0x41,0x3E,       // Ю
+    0x46,0x29,0x19,0x09,0x7F,       // Я
+    0x20,0x54,0x54,0x54,0x78,       // а
+    0x3E,0x45,0x45,0x45,0x38,       // б
+    0x7C,0x54,0x54,0x54,0x28,       // в
+    0x7C,0x04,0x04,0x04,0x04,       // г
+    0x60,0x3C,0x24,0x3C,0x60,       // д
+    0x38,0x54,0x54,0x54,0x18,       // е
+    0x44,0x28,0x7C,0x28,0x44,       // ж
+    0x28,0x44,0x54,0x54,0x28,       // з
+    0x7C,0x20,0x10,0x08,0x7C,       // и
+    0x7C,0x20,0x12,0x08,0x7C,       // й
+    0x7C,0x10,0x28,0x44,            // к
+    0x40,0x38,0x04,0x04,0x7C,       // л
+    0x7C,0x08,0x10,0x08,0x7C,       // м
+    0x7C,0x10,0x10,0x10,0x7C,       // н
+    0x38,0x44,0x44,0x44,0x38,       // о
+    0x7C,0x04,0x04,0x04,0x7C,       // п
+    0x7C,0x14,0x14,0x14,0x08,       // р
+    0x38,0x44,0x44,0x44,0x20,       // с
+    0x04,0x04,0x7C,0x04,0x04,       // т
+    0x0C,0x50,0x50,0x50,0x3C,       // у
+    0x18,0x24,0x7F,0x24,0x18,       // ф
+    0x44,0x28,0x10,0x28,0x44,       // х
+    0x3C,0x20,0x20,0x3C,0x60,       // ц
+    0x0C,0x10,0x10,0x10,0x7C,       // ч
+    0x7C,0x40,0x7C,0x40,0x7C,       // ш
+    0x3C,0x20,0x3C,0x20,0x3C,0x60,  // щ
+    0x04,0x7C,0x50,0x50,0x20,       // ъ
+    0x7C,0x50,0x70,0x00,0x7C,       // ы
+    0x7C,0x50,0x50,0x50,0x20,       // ь
+    0x28,0x44,0x54,0x54,0x38,       // э
+    0x7C,0x10,0x38,0x44,0x38,       // ю
+    0x48,0x34,0x14,0x14,0x7C,       // я
+    0x38,0x55,0x54,0x55,0x18,       // ё
+};
+
+#endif //FONT_UTF8_H
@@ -1,131 +0,0 @@
-//
-// Created by deity on 29.06.2025.
-//
-
-#ifndef FONTS6X8_H
-#define FONTS6X8_H
-#include <stdint.h>
-static const uint8_t font6x8_alpha[128][8] = {
-    [0 ... 31] = {0,0,0,0,0,0},
-   // 0x20: Пробел ' '
-    [32] = {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
-
-    // 0x21: Восклицательный знак '!'
-    [33] = {0x00,0x00,0x00,0x5F,0x5F,0x00,0x00,0x00},
-
-    // 0x22: Кавычки '"'
-    [34] = {0x00,0x07,0x00,0x07,0x00,0x00,0x00,0x00},
-
-    // 0x23: Решетка '#'
-    [35] = {0x14,0x7F,0x14,0x7F,0x14,0x00,0x00,0x00},
-
-    // 0x30-0x39: Цифры 0-9
-    [48] = {0x3E,0x51,0x49,0x45,0x3E,0x00,0x00,0x00}, // '0'
-    [49] = {0x00,0x42,0x7F,0x40,0x00,0x00,0x00,0x00}, // '1'
-    [50] = {0x42,0x61,0x51,0x49,0x46,0x00,0x00,0x00}, // '2'
-    [51] = {0x21,0x41,0x45,0x4B,0x31,0x00,0x00,0x00}, // '3'
-    [52] = {0x18,0x14,0x12,0x7F,0x10,0x00,0x00,0x00}, // '4'
-    [53] = {0x27,0x45,0x45,0x45,0x39,0x00,0x00,0x00}, // '5'
-    [54] = {0x3C,0x4A,0x49,0x49,0x30,0x00,0x00,0x00}, // '6'
-    [55] = {0x01,0x71,0x09,0x05,0x03,0x00,0x00,0x00}, // '7'
-    [56] = {0x36,0x49,0x49,0x49,0x36,0x00,0x00,0x00}, // '8'
-    [57] = {0x06,0x49,0x49,0x29,0x1E,0x00,0x00,0x00}, // '9'
-
-    // 0x41-0x5A: Заглавные буквы A-Z
-    [65] = {0x7E,0x11,0x11,0x11,0x7E,0x00,0x00,0x00}, // 'A'
-    [66] = {0x7F,0x49,0x49,0x49,0x36,0x00,0x00,0x00}, // 'B'
-    [67] = {0x3E,0x41,0x41,0x41,0x22,0x00,0x00,0x00}, // 'C'
-    [68] = {0x7F,0x41,0x41,0x22,0x1C,0x00,0x00,0x00}, // 'D'
-    [69] = {0x7F,0x49,0x49,0x49,0x41,0x00,0x00,0x00}, // 'E'
-    [70] = {0x7F,0x09,0x09,0x09,0x01,0x00,0x00,0x00}, // 'F'
-    [71] = {0x3E,0x41,0x49,0x49,0x7A,0x00,0x00,0x00}, // 'G'
-    [72] = {0x7F,0x08,0x08,0x08,0x7F,0x00,0x00,0x00}, // 'H'
-    [73] = {0x00,0x41,0x7F,0x41,0x00,0x00,0x00,0x00}, // 'I'
-    [74] = {0x20,0x40,0x41,0x3F,0x01,0x00,0x00,0x00}, // 'J'
-    [75] = {0x7F,0x08,0x14,0x22,0x41,0x00,0x00,0x00}, // 'K'
-    [76] = {0x7F,0x40,0x40,0x40,0x40,0x00,0x00,0x00}, // 'L'
-    [77] = {0x7F,0x02,0x0C,0x02,0x7F,0x00,0x00,0x00}, // 'M'
-    [78] = {0x7F,0x04,0x08,0x10,0x7F,0x00,0x00,0x00}, // 'N'
-    [79] = {0x3E,0x41,0x41,0x41,0x3E,0x00,0x00,0x00}, // 'O'
-    [80] = {0x7F,0x09,0x09,0x09,0x06,0x00,0x00,0x00}, // 'P'
-    [81] = {0x3E,0x41,0x51,0x21,0x5E,0x00,0x00,0x00}, // 'Q'
-    [82] = {0x7F,0x09,0x19,0x29,0x46,0x00,0x00,0x00}, // 'R'
-    [83] = {0x46,0x49,0x49,0x49,0x31,0x00,0x00,0x00}, // 'S'
-    [84] = {0x01,0x01,0x7F,0x01,0x01,0x00,0x00,0x00}, // 'T'
-    [85] = {0x3F,0x40,0x40,0x40,0x3F,0x00,0x00,0x00}, // 'U'
-    [86] = {0x1F,0x20,0x40,0x20,0x1F,0x00,0x00,0x00}, // 'V'
-    [87] = {0x3F,0x40,0x38,0x40,0x3F,0x00,0x00,0x00}, // 'W'
-    [88] = {0x63,0x14,0x08,0x14,0x63,0x00,0x00,0x00}, // 'X'
-    [89] = {0x07,0x08,0x70,0x08,0x07,0x00,0x00,0x00}, // 'Y'
-    [90] = {0x61,0x51,0x49,0x45,0x43,0x00,0x00,0x00}, // 'Z'
-       // 0x5B: Левая квадратная скобка '['
-    [91] = {0x00,0x7F,0x41,0x41,0x00,0x00,0x00,0x00},
-
-    // 0x5C: Обратный слэш '\'
-    [92] = {0x02,0x04,0x08,0x10,0x20,0x00,0x00,0x00},
-
-    // 0x5D: Правая квадратная скобка ']'
-    [93] = {0x00,0x41,0x41,0x7F,0x00,0x00,0x00,0x00},
-
-    // 0x5E: Циркумфлекс '^'
-    [94] = {0x04,0x02,0x01,0x02,0x04,0x00,0x00,0x00},
-
-    // 0x5F: Подчеркивание '_'
-    [95] = {0x40,0x40,0x40,0x40,0x40,0x00,0x00,0x00},
-
-    // 0x60: Обратный апостроф '`'
-    [96] = {0x00,0x01,0x02,0x04,0x00,0x00,0x00,0x00},
-
-    // 0x61-0x7A: Строчные буквы a-z
-    [97] = {0x20,0x54,0x54,0x54,0x78,0x00,0x00,0x00},  // 'a'
-    [98] = {0x7F,0x48,0x44,0x44,0x38,0x00,0x00,0x00},  // 'b'
-    [99] = {0x38,0x44,0x44,0x44,0x20,0x00,0x00,0x00},  // 'c'
-    [100] = {0x38,0x44,0x44,0x48,0x7F,0x00,0x00,0x00}, // 'd'
-    [101] = {0x38,0x54,0x54,0x54,0x18,0x00,0x00,0x00}, // 'e'
-    [102] = {0x08,0x7E,0x09,0x01,0x02,0x00,0x00,0x00}, // 'f'
-    [103] = {0x0C,0x52,0x52,0x52,0x3E,0x00,0x00,0x00}, // 'g'
-    [104] = {0x7F,0x08,0x04,0x04,0x78,0x00,0x00,0x00}, // 'h'
-    [105] = {0x00,0x44,0x7D,0x40,0x00,0x00,0x00,0x00}, // 'i'
-    [106] = {0x20,0x40,0x44,0x3D,0x00,0x00,0x00,0x00}, // 'j'
-    [107] = {0x7F,0x10,0x28,0x44,0x00,0x00,0x00,0x00}, // 'k'
-    [108] = {0x00,0x41,0x7F,0x40,0x00,0x00,0x00,0x00}, // 'l'
-    [109] = {0x7C,0x04,0x18,0x04,0x78,0x00,0x00,0x00}, // 'm'
-    [110] = {0x7C,0x08,0x04,0x04,0x78,0x00,0x00,0x00}, // 'n'
-    [111] = {0x38,0x44,0x44,0x44,0x38,0x00,0x00,0x00}, // 'o'
-    [112] = {0x7C,0x14,0x14,0x14,0x08,0x00,0x00,0x00}, // 'p'
-    [113] = {0x08,0x14,0x14,0x18,0x7C,0x00,0x00,0x00}, // 'q'
-    [114] = {0x7C,0x08,0x04,0x04,0x08,0x00,0x00,0x00}, // 'r'
-    [115] = {0x48,0x54,0x54,0x54,0x20,0x00,0x00,0x00}, // 's'
-    [116] = {0x04,0x3F,0x44,0x40,0x20,0x00,0x00,0x00}, // 't'
-    [117] = {0x3C,0x40,0x40,0x20,0x7C,0x00,0x00,0x00}, // 'u'
-    [118] = {0x1C,0x20,0x40,0x20,0x1C,0x00,0x00,0x00}, // 'v'
-    [119] = {0x3C,0x40,0x30,0x40,0x3C,0x00,0x00,0x00}, // 'w'
-    [120] = {0x44,0x28,0x10,0x28,0x44,0x00,0x00,0x00}, // 'x'
-    [121] = {0x0C,0x50,0x50,0x50,0x3C,0x00,0x00,0x00}, // 'y'
-    [122] = {0x44,0x64,0x54,0x4C,0x44,0x00,0x00,0x00}, // 'z'
-
-    // 0x7B: Левая фигурная скобка '{'
-    [123] = {0x00,0x08,0x36,0x41,0x00,0x00,0x00,0x00},
-
-    // 0x7C: Вертикальная черта '|'
-    [124] = {0x00,0x00,0x7F,0x00,0x00,0x00,0x00,0x00},
-
-    // 0x7D: Правая фигурная скобка '}'
-    [125] = {0x00,0x41,0x36,0x08,0x00,0x00,0x00,0x00},
-
-    // 0x7E: Тильда '~'
-    [126] = {0x10,0x08,0x08,0x10,0x08,0x00,0x00,0x00},
-
-    // 0x7F: DEL (пустой)
-    [127] = {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
-};
-static inline uint8_t* get_char_data(char c) {
-    // Проверяем границы ASCII
-    if (c < 0 || c > 127) {
-        return font6x8_alpha[32]; // возвращаем пробел для неизвестных символов
-    }
-    return font6x8_alpha[(uint8_t)c];
-}
-
-
-#endif //FONTS6X8_H
@@ -3,135 +3,399 @@
 //
 
 #include "mono_lcd.h"
+#include "mono_lcd_panel.h"
 #include "esp_log.h"
-#include "esp_lcd_panel_io.h"
-#include "driver/i2c.h"
-#include "esp_lcd_panel_ops.h"
-#include "esp_lcd_panel_vendor.h"
-#include "driver/i2c_master.h"
-#include "fonts6x8.h"
+#include "font_utf8.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <string.h>
 
 static const char *TAG = "mono_lcd";
 
-#define I2C_NUM         I2C_NUM_0
-#define I2C_SDA_GPIO    21
-#define I2C_SCL_GPIO    22
-#define I2C_FREQ_HZ     400000
-#define DEV_ADDR        0x3C
-#define SCREEN_W        128
-#define SCREEN_H        64
-#define PAGE_H           8
-#define FONT_W           6
-#define FONT_H           8
+#define WORD_MAX        64      // глифов в слове, длиннее - переносится посимвольно
 #define LINE_BYTES     (SCREEN_W)
 #define MAX_PAGES      (SCREEN_H / PAGE_H)
 
-static uint8_t fb[SCREEN_W * SCREEN_H / 8];
-static esp_lcd_panel_handle_t panel;
+#define FB_SIZE        (SCREEN_W * SCREEN_H / 8)
+#define ALL_PAGES      ((1 << MAX_PAGES) - 1)
 
-// send one page (8-pixel rows)
-static esp_err_t flush_page(int page)
+// back  - сюда рисуют вызывающие, только их контекст
+// front - последний отправленный на показ кадр, под lock
+// shown - что уже ушло (или сейчас уходит) на панель, только задача дисплея
+// Все три лежат в порядке страниц ОЗУ панели. При аппаратной прокрутке
+// логическая страница page хранится в странице ОЗУ (page + start) % MAX_PAGES.
+static uint8_t back[FB_SIZE];
+static uint8_t front[FB_SIZE];
+static uint8_t shown[FB_SIZE];
+static uint8_t back_dirty;                          // страницы back, изменённые с прошлого submit
+static uint8_t front_dirty;                         // страницы front, ещё не отправленные, под lock
+static bool front_pending;                          // кадр ещё не забран задачей, под lock
+static uint8_t back_start;                          // верхняя страница кадра back
+static uint8_t front_start;                         // то же для front, под lock
+static int panel_start = -1;                        // что выставлено на панели, только задача
+static volatile bool hw_scroll = MONO_LCD_HW_SCROLL;
+static SemaphoreHandle_t lock;
+static TaskHandle_t task;
+static mono_lcd_stats_t stats;
+
+// hand the back buffer over to the display task, never waits for I2C
+static void submit(void)
 {
-    return esp_lcd_panel_draw_bitmap(panel,
-                                     0, page*PAGE_H,
-                                     SCREEN_W,(page+1)*PAGE_H,
-                                     fb + page*LINE_BYTES);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    // задача развернула front к другому порядку страниц - копируем всё
+    if (front_start != back_start) back_dirty = ALL_PAGES;
+    for (int page=0; page<MAX_PAGES; ++page) {
+        if (back_dirty & (1 << page)) {
+            memcpy(front + page*LINE_BYTES, back + page*LINE_BYTES, LINE_BYTES);
+        }
+    }
+    front_dirty |= back_dirty;
+    front_start = back_start;
+    // задача ещё не забрала предыдущий кадр - он просто заменён этим
+    if (front_pending) stats.coalesced++;
+    front_pending = true;
+    stats.submitted++;
+    xSemaphoreGive(lock);
+
+    back_dirty = 0;
+    xTaskNotifyGive(task);
 }
 
-// draw a word buffer to fb at given page,x
-static void draw_word(int page, int x, const char *word, int len)
+// take the pending frame: changed columns go from front to shown under lock,
+// the I2C transfer itself runs without it
+static uint8_t take_frame(uint8_t x0[], uint8_t x1[], uint8_t *start)
 {
-    uint8_t *dst = fb + page*LINE_BYTES + x;
-    for (int i=0; i<len; ++i) {
-        const uint8_t *glyph = get_char_data((uint8_t)word[i]);
-        memcpy(dst, glyph, FONT_W);
-        dst += FONT_W;
-        flush_page(page);
+    uint8_t pages = 0;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (int page=0; page<MAX_PAGES; ++page) {
+        if (!(front_dirty & (1 << page))) continue;
+
+        const uint8_t *src = front + page*LINE_BYTES;
+        uint8_t *dst = shown + page*LINE_BYTES;
+        int l = 0, r = LINE_BYTES;
+        while (l < r && src[l] == dst[l]) l++;
+        while (r > l && src[r-1] == dst[r-1]) r--;
+        if (l == r) continue;
+
+        memcpy(dst + l, src + l, r - l);
+        x0[page] = l;
+        x1[page] = r - 1;
+        pages |= 1 << page;
     }
+    front_dirty = 0;
+    front_pending = false;
+    *start = front_start;
+    xSemaphoreGive(lock);
+    return pages;
 }
 
-// main draw function
-esp_err_t mono_lcd_draw_text(const char *str)
+// swap two pages of a frame buffer through a small buffer
+static void swap_pages(uint8_t *buf, int a, int b)
+{
+    uint8_t tmp[LINE_BYTES];
+    memcpy(tmp, buf + a*LINE_BYTES, LINE_BYTES);
+    memcpy(buf + a*LINE_BYTES, buf + b*LINE_BYTES, LINE_BYTES);
+    memcpy(buf + b*LINE_BYTES, tmp, LINE_BYTES);
+}
+
+static void reverse_pages(uint8_t *buf, int from, int to)
+{
+    while (from < to) swap_pages(buf, from++, to--);
+}
+
+// кадр с верхней страницей start -> порядок страниц с нуля,
+// поворот на start страниц тремя разворотами
+static void rotate_to_zero(uint8_t *buf, uint8_t start)
+{
+    if (start == 0) return;
+    reverse_pages(buf, 0, start - 1);
+    reverse_pages(buf, start, MAX_PAGES - 1);
+    reverse_pages(buf, 0, MAX_PAGES - 1);
+}
+
+static void display_task(void *arg)
+{
+    uint8_t x0[MAX_PAGES], x1[MAX_PAGES];
+    uint8_t start;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint8_t pages = take_frame(x0, x1, &start);
+
+        // сначала сдвиг: новая строка на миг покажется внизу со старым
+        // содержимым, а не вверху поверх старой первой строки
+        if (start != panel_start) {
+            esp_err_t ret = mono_panel_start_line(start*PAGE_H);
+            if (ret == ESP_OK) {
+                panel_start = start;
+            } else if (hw_scroll || start != 0) {
+                // дальше только программная прокрутка. Кадр уже забран и может
+                // лежать со сдвигом: разворачиваем front к порядку страниц с нуля
+                // и отправляем заново целиком вместе с повтором команды, back
+                // развернёт unrotate(). Снова отказала - рисуем как есть
+                if (hw_scroll) {
+                    ESP_LOGW(TAG, "Start line command failed, software scrolling: %s", esp_err_to_name(ret));
+                    hw_scroll = false;
+                }
+                xSemaphoreTake(lock, portMAX_DELAY);
+                rotate_to_zero(front, front_start);
+                front_start = 0;
+                front_dirty = ALL_PAGES;
+                memset(shown, 0xff, sizeof shown);
+                xSemaphoreGive(lock);
+                xTaskNotifyGive(task);
+                continue;
+            }
+        }
+        if (!pages) continue;
+
+        for (int page=0; page<MAX_PAGES; ++page) {
+            if (!(pages & (1 << page))) continue;
+
+            esp_err_t ret = mono_panel_draw(page, x0[page], x1[page] + 1,
+                                            shown + page*LINE_BYTES + x0[page]);
+            if (ret != ESP_OK) {
+                // содержимое панели неизвестно - следующий кадр уйдёт целиком
+                ESP_LOGW(TAG, "Page %d transfer failed: %s", page, esp_err_to_name(ret));
+                xSemaphoreTake(lock, portMAX_DELAY);
+                memset(shown, 0xff, sizeof shown);
+                front_dirty = ALL_PAGES;
+                xSemaphoreGive(lock);
+                xTaskNotifyGive(task);
+                break;
+            }
+            stats.pages++;
+            stats.bytes += x1[page] + 1 - x0[page];
+        }
+        mono_panel_frame_done();
+        stats.frames++;
+    }
+}
+
+// next code point; broken sequences give U+FFFD and never skip the terminator
+static uint32_t utf8_next(const char **s)
+{
+    const uint8_t *p = (const uint8_t *)*s;
+    uint32_t cp;
+    int n;
+
+    if (p[0] < 0x80) { *s += 1; return p[0]; }
+    if ((p[0] & 0xE0) == 0xC0) { cp = p[0] & 0x1F; n = 1; }
+    else if ((p[0] & 0xF0) == 0xE0) { cp = p[0] & 0x0F; n = 2; }
+    else if ((p[0] & 0xF8) == 0xF0) { cp = p[0] & 0x07; n = 3; }
+    else { *s += 1; return 0xFFFD; }
+
+    for (int i=1; i<=n; ++i) {
+        if ((p[i] & 0xC0) != 0x80) { *s += i; return 0xFFFD; }
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    *s += n + 1;
+    return cp;
+}
+
+static const font_glyph_t *font_find(uint32_t cp)
+{
+    int lo = 0, hi = sizeof font_glyphs / sizeof font_glyphs[0] - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (font_glyphs[mid].cp == cp) return &font_glyphs[mid];
+        if (font_glyphs[mid].cp < cp) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+// ASCII лежит в начале font_glyphs подряд, индекс = cp - ' ', остальное
+// (кириллица) - двоичным поиском. Столбцы уже готовы в font_cols, кэшировать нечего
+static const font_glyph_t *glyph_get(uint32_t cp)
+{
+    const font_glyph_t *g = NULL;
+    if (cp >= ' ' && cp - ' ' < sizeof font_glyphs / sizeof font_glyphs[0] && font_glyphs[cp - ' '].cp == cp) {
+        g = &font_glyphs[cp - ' '];
+    } else if (cp <= 0xFFFF) {
+        g = font_find(cp);
+    }
+    return g ? g : &font_glyphs[FONT_FALLBACK - ' '];
+}
+
+// logical page -> page of the panel RAM
+static inline uint8_t *page_ptr(int page)
+{
+    return back + ((page + back_start) % MAX_PAGES)*LINE_BYTES;
+}
+
+static void draw_glyph(int page, int x, const font_glyph_t *g)
+{
+    int w = g->width;
+    if (g->cp == ' ') return;
+    if (x + w > LINE_BYTES) w = LINE_BYTES - x;
+    memcpy(page_ptr(page) + x, font_cols + g->offset, w);
+    back_dirty |= 1 << ((page + back_start) % MAX_PAGES);
+}
+
+// аппаратная прокрутка отказала: возвращаем back к порядку страниц с нуля
+static void unrotate(void)
+{
+    if (hw_scroll || back_start == 0) return;
+
+    rotate_to_zero(back, back_start);
+    back_start = 0;
+    back_dirty = ALL_PAGES;
+}
+
+// everything moves up one line, the bottom line is cleared
+static void scroll_up(void)
+{
+    if (hw_scroll) {
+        // верхняя страница ОЗУ становится нижней, остальное сдвигает панель
+        back_start = (back_start + 1) % MAX_PAGES;
+    } else {
+        memmove(back, back + LINE_BYTES, (MAX_PAGES - 1)*LINE_BYTES);
+        back_dirty = ALL_PAGES;
+    }
+    memset(page_ptr(MAX_PAGES - 1), 0, LINE_BYTES);
+    back_dirty |= 1 << ((MAX_PAGES - 1 + back_start) % MAX_PAGES);
+    stats.scrolls++;
+}
+
+// next line: a new page of the frame, or in scroll mode a scroll
+static bool next_line(int *page, bool scroll)
 {
-    int cur_x=0, cur_page=0;
+    if (!scroll) return ++*page < MAX_PAGES;
+    scroll_up();
+    return true;
+}
+
+// lay the text out in the back buffer, nothing is sent here. Every glyph is
+// looked up and measured once; words wrap as a whole unless wider than a line.
+// In scroll mode the text goes to the bottom line and wrapping scrolls.
+// On overflow *rest (if given) points to the first character that did not fit.
+static esp_err_t layout_text(const char *str, bool scroll, const char **rest)
+{
+    const font_glyph_t *word[WORD_MAX];
+    const font_glyph_t *space = glyph_get(' ');
+    int x = 0, page = scroll ? MAX_PAGES - 1 : 0;
     const char *p = str;
 
-    memset(fb,0,sizeof fb);
-    for (; *p && cur_page<MAX_PAGES;) {
-        // skip spaces
-        while (*p==' ') {
-            if (cur_x>LINE_BYTES-FONT_W) { cur_x=0; cur_page++; if (cur_page>=MAX_PAGES) return ESP_FAIL; }
-            memset(fb+cur_page*LINE_BYTES+cur_x,0,FONT_W);
-            flush_page(cur_page);
-            cur_x+=FONT_W; p++;
+    while (*p) {
+        if (*p == '\n') {
+            x = 0; p++;
+            if (!next_line(&page, scroll)) goto overflow;
+            continue;
+        }
+        if (*p == ' ') {
+            // пробелы в начале строки не рисуем, back уже очищен
+            if (x) x += space->width + FONT_GAP;
+            p++;
+            continue;
+        }
+
+        // collect and measure the word
+        const char *word_start = p;
+        int len = 0, w = 0;
+        while (*p && *p != ' ' && *p != '\n' && len < WORD_MAX) {
+            const font_glyph_t *g = glyph_get(utf8_next(&p));
+            w += g->width + FONT_GAP;
+            word[len++] = g;
+        }
+        w -= FONT_GAP;
+
+        if (x && x + w > LINE_BYTES) {
+            x = 0;
+            if (!next_line(&page, scroll)) {
+                p = word_start;
+                goto overflow;
+            }
+        }
+        for (int i=0; i<len; ++i) {
+            // слово шире строки - рвём по символам
+            if (x + word[i]->width > LINE_BYTES) {
+                x = 0;
+                if (!next_line(&page, scroll)) {
+                    // остаток начинается с i-го символа слова
+                    p = word_start;
+                    for (int k=0; k<i; ++k) utf8_next(&p);
+                    goto overflow;
+                }
+            }
+            draw_glyph(page, x, word[i]);
+            x += word[i]->width + FONT_GAP;
         }
-        // collect word
-        char buf[16]; int len=0;
-        while (*p && *p!=' ' && len<16) buf[len++] = *p++;
-        if (len==0) continue;
-        int wbytes = len*FONT_W;
-        if (cur_x>LINE_BYTES-wbytes) { cur_x=0; cur_page++; if (cur_page>=MAX_PAGES) return ESP_FAIL; }
-        draw_word(cur_page, cur_x, buf, len);
-        cur_x += wbytes;
     }
     return ESP_OK;
+
+overflow:
+    if (rest) *rest = p;
+    return ESP_FAIL;
+}
+
+// whole frame from the top, the rest of the text goes to *rest
+static esp_err_t draw_frame(const char *str, const char **rest)
+{
+    unrotate();
+    memset(back,0,sizeof back);
+    back_dirty = ALL_PAGES;
+
+    esp_err_t ret = layout_text(str, false, rest);
+    // то, что влезло, показываем даже при переполнении
+    submit();
+    return ret;
+}
+
+// main draw function
+esp_err_t mono_lcd_draw_text(const char *str)
+{
+    return draw_frame(str, NULL);
+}
+
+esp_err_t mono_lcd_draw_page(const char *str, const char **rest)
+{
+    const char *next = NULL;
+    draw_frame(str, &next);
+    // хвост из одних переводов строки страницы не стоит
+    while (next && *next == '\n') next++;
+    *rest = next && *next ? next : NULL;
+    return ESP_OK;
 }
 
 esp_err_t mono_lcd_clear(void)
 {
-    memset(fb,0,sizeof fb);
-    for (int page=0; page<MAX_PAGES; ++page) {
-        esp_err_t ret = flush_page(page);
-        if (ret!=ESP_OK) return ret;
-    }
+    unrotate();
+    memset(back,0,sizeof back);
+    back_dirty = ALL_PAGES;
+    submit();
     return ESP_OK;
 }
 
-esp_err_t mono_lcd_init(void)
+esp_err_t mono_lcd_scroll_line(const char *str)
 {
-    // I2C master init
-    i2c_master_bus_handle_t bus;
-    i2c_master_bus_config_t cfg = {
-        .clk_source = I2C_CLK_SRC_DEFAULT,
-        .glitch_ignore_cnt = 7,
-        .i2c_port = I2C_NUM,
-        .sda_io_num = I2C_SDA_GPIO,
-        .scl_io_num = I2C_SCL_GPIO,
-        .flags.enable_internal_pullup = true,
-        .intr_priority = 0,
-    };
-    esp_err_t err = i2c_new_master_bus(&cfg, &bus);
-    if (err!=ESP_OK) {
-        ESP_LOGE(TAG, "I2C init failed: %s", esp_err_to_name(err));
-        return err;
-    }
+    unrotate();
+    scroll_up();
+    layout_text(str, true, NULL);
+    submit();
+    return ESP_OK;
+}
 
-    // panel IO
-    esp_lcd_panel_io_handle_t io;
-    esp_lcd_panel_io_i2c_config_t io_cfg = {
-        .dev_addr = DEV_ADDR,
-        .scl_speed_hz = I2C_FREQ_HZ,
-        .control_phase_bytes = 1,
-        .dc_bit_offset = 6,
-        .lcd_cmd_bits = 8,
-        .lcd_param_bits = 8,
-    };
-    err = esp_lcd_new_panel_io_i2c(bus, &io_cfg, &io);
-    if (err!=ESP_OK) return err;
+void mono_lcd_get_stats(mono_lcd_stats_t *out)
+{
+    *out = stats;
+}
 
-    // panel
-    esp_lcd_panel_dev_config_t panel_cfg = {
-        .bits_per_pixel = 1,
-        .reset_gpio_num = -1,
-    };
-    err = esp_lcd_new_panel_ssd1306(io, &panel_cfg, &panel);
+esp_err_t mono_lcd_init(void)
+{
+    esp_err_t err = mono_panel_init();
     if (err!=ESP_OK) return err;
 
-    // init & turn on
-    esp_lcd_panel_init(panel);
-    esp_lcd_panel_disp_on_off(panel, true);
+    lock = xSemaphoreCreateMutex();
+    if (!lock) return ESP_ERR_NO_MEM;
+    if (xTaskCreate(display_task, "mono_lcd", MONO_LCD_TASK_STACK, NULL, MONO_LCD_TASK_PRIO, &task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
 
-    // clear on start
+    // clear on start: panel RAM is unknown, make every column differ
+    memset(shown,0xff,sizeof shown);
     return mono_lcd_clear();
 }
\ No newline at end of file
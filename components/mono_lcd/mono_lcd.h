@@ -6,6 +6,26 @@
 #define LCD_H
 
 #include <esp_err.h>
+#include <stdint.h>
+
+// Панелью владеет своя задача: draw/clear рисуют в задний буфер и сразу
+// возвращаются, задача шлёт по I2C только изменившиеся столбцы. Если кадры
+// приходят быстрее, чем уходят по шине, промежуточные не показываются.
+#define MONO_LCD_TASK_STACK     3072
+#define MONO_LCD_TASK_PRIO      5
+
+// Прокрутка строк сдвигом начальной строки ОЗУ SSD1306: на строку уходит
+// одна команда и одна страница. 0 - только программный сдвиг буфера.
+#define MONO_LCD_HW_SCROLL      1
+
+typedef struct {
+    uint32_t submitted; // frames handed over by draw/clear calls
+    uint32_t coalesced; // frames replaced by a newer one before being sent
+    uint32_t frames;    // frames actually sent
+    uint32_t pages;     // page transfers actually sent
+    uint32_t bytes;     // framebuffer bytes sent over I2C
+    uint32_t scrolls;   // lines scrolled by mono_lcd_scroll_line()
+} mono_lcd_stats_t;
 
 /**
  * @brief Initialize the SSD1306 display over I2C
@@ -15,16 +35,57 @@ esp_err_t mono_lcd_init(void);
 
 /**
  * @brief Clear entire display
+ *
+ * Does not wait for the transfer, see MONO_LCD_TASK_STACK.
+ *
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t mono_lcd_clear(void);
 
 /**
- * @brief Draw a null-terminated ASCII string, wrapping words
- * @param text    input string (max total length fits display)
- * @return ESP_OK on success, or ESP_FAIL if text too long
+ * @brief Draw a null-terminated UTF-8 string, wrapping words
+ *
+ * Proportional font with ASCII and Cyrillic, see font_utf8.h; unknown
+ * characters are shown as '?'. '\n' starts a new line, words wider than
+ * the screen are broken. Replaces the whole frame and does not wait for
+ * the transfer.
+ *
+ * @param text    input string
+ * @return ESP_OK on success, or ESP_FAIL if the text did not fit (the part
+ *         that fits is still shown)
  */
 esp_err_t mono_lcd_draw_text(const char *text);
 
+/**
+ * @brief Draw one page of a long UTF-8 text
+ *
+ * Lays the text out like mono_lcd_draw_text() and shows as much as fits.
+ * Call again with *rest to show the next page. Leading newlines of the
+ * next page are skipped, spaces are not drawn at line starts anyway.
+ *
+ * @param text    input string
+ * @param rest    set to the first word (or character of a broken word) that
+ *                did not fit, NULL when the whole text is shown
+ * @return ESP_OK
+ */
+esp_err_t mono_lcd_draw_page(const char *text, const char **rest);
+
+/**
+ * @brief Scroll the screen up and print a UTF-8 line at the bottom
+ *
+ * Only the new line is rendered; with MONO_LCD_HW_SCROLL only it is sent,
+ * the panel shifts the rest itself. Long lines wrap and scroll further.
+ * Does not wait for the transfer.
+ *
+ * @param text    input string
+ * @return ESP_OK
+ */
+esp_err_t mono_lcd_scroll_line(const char *text);
+
+/**
+ * @brief Get transfer counters since init
+ * @param out  filled with the counters
+ */
+void mono_lcd_get_stats(mono_lcd_stats_t *out);
 
 #endif //LCD_H
@@ -0,0 +1,29 @@
+//
+// Created by deity on 17.10.2026.
+//
+
+#ifndef MONO_LCD_PANEL_H
+#define MONO_LCD_PANEL_H
+
+#include <stdint.h>
+#include <esp_err.h>
+
+// Геометрия и вывод на панель. На устройстве - SSD1306 по I2C
+// (mono_lcd_ssd1306.c), в сборке под linux - её ОЗУ в памяти с выводом
+// кадров в PGM (mono_lcd_pgm.c). Вызывается только из задачи дисплея.
+#define SCREEN_W        128
+#define SCREEN_H        64
+#define PAGE_H           8
+
+esp_err_t mono_panel_init(void);
+
+// columns [x0, x1) of one page (8-pixel rows) of the panel RAM
+esp_err_t mono_panel_draw(int page, int x0, int x1, const uint8_t *cols);
+
+// RAM row shown at the top of the screen
+esp_err_t mono_panel_start_line(int line);
+
+// all transfers of a frame are done
+void mono_panel_frame_done(void);
+
+#endif //MONO_LCD_PANEL_H
@@ -0,0 +1,62 @@
+//
+// Created by deity on 17.10.2026.
+//
+// Сборка под linux: ОЗУ SSD1306 в памяти. После каждого кадра экран
+// (с учётом начальной строки, как его показала бы панель) пишется в
+// MONO_LCD_PGM_FILE, картинку можно смотреть любым просмотрщиком.
+//
+
+#include "mono_lcd_panel.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "mono_lcd";
+
+#define MONO_LCD_PGM_FILE   "mono_lcd.pgm"
+#define PGM_SCALE           4       // 128x64 слишком мелко для экрана ПК
+
+static uint8_t gddram[SCREEN_W * SCREEN_H / 8];
+static int start_line;
+
+esp_err_t mono_panel_init(void)
+{
+    memset(gddram, 0, sizeof gddram);
+    start_line = 0;
+    ESP_LOGI(TAG, "Panel frames go to %s", MONO_LCD_PGM_FILE);
+    return ESP_OK;
+}
+
+esp_err_t mono_panel_draw(int page, int x0, int x1, const uint8_t *cols)
+{
+    if (page < 0 || page >= SCREEN_H / PAGE_H || x0 < 0 || x1 > SCREEN_W || x0 >= x1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(gddram + page*SCREEN_W + x0, cols, x1 - x0);
+    return ESP_OK;
+}
+
+esp_err_t mono_panel_start_line(int line)
+{
+    start_line = line % SCREEN_H;
+    return ESP_OK;
+}
+
+void mono_panel_frame_done(void)
+{
+    // пишем во временный файл и переименовываем, чтобы просмотрщик
+    // не поймал половину кадра
+    FILE *f = fopen(MONO_LCD_PGM_FILE ".tmp", "wb");
+    if (!f) return;
+
+    fprintf(f, "P5\n%d %d\n255\n", SCREEN_W * PGM_SCALE, SCREEN_H * PGM_SCALE);
+    for (int y = 0; y < SCREEN_H * PGM_SCALE; y++) {
+        int row = (y / PGM_SCALE + start_line) % SCREEN_H;
+        const uint8_t *ram = gddram + (row / PAGE_H)*SCREEN_W;
+        for (int x = 0; x < SCREEN_W * PGM_SCALE; x++) {
+            fputc(ram[x / PGM_SCALE] >> (row % PAGE_H) & 1 ? 255 : 0, f);
+        }
+    }
+    fclose(f);
+    rename(MONO_LCD_PGM_FILE ".tmp", MONO_LCD_PGM_FILE);
+}
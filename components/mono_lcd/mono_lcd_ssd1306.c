@@ -0,0 +1,85 @@
+//
+// Created by deity on 07.07.2025.
+//
+
+#include "mono_lcd_panel.h"
+#include "esp_log.h"
+#include "esp_lcd_panel_io.h"
+#include "driver/i2c.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_vendor.h"
+#include "driver/i2c_master.h"
+
+static const char *TAG = "mono_lcd";
+
+#define I2C_NUM         I2C_NUM_0
+#define I2C_SDA_GPIO    21
+#define I2C_SCL_GPIO    22
+#define I2C_FREQ_HZ     400000
+#define DEV_ADDR        0x3C
+#define CMD_START_LINE  0x40    // | строка ОЗУ, показываемая верхней
+
+static esp_lcd_panel_handle_t panel;
+static esp_lcd_panel_io_handle_t io;
+
+esp_err_t mono_panel_init(void)
+{
+    // I2C master init
+    i2c_master_bus_handle_t bus;
+    i2c_master_bus_config_t cfg = {
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .i2c_port = I2C_NUM,
+        .sda_io_num = I2C_SDA_GPIO,
+        .scl_io_num = I2C_SCL_GPIO,
+        .flags.enable_internal_pullup = true,
+        .intr_priority = 0,
+    };
+    esp_err_t err = i2c_new_master_bus(&cfg, &bus);
+    if (err!=ESP_OK) {
+        ESP_LOGE(TAG, "I2C init failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    // panel IO
+    esp_lcd_panel_io_i2c_config_t io_cfg = {
+        .dev_addr = DEV_ADDR,
+        .scl_speed_hz = I2C_FREQ_HZ,
+        .control_phase_bytes = 1,
+        .dc_bit_offset = 6,
+        .lcd_cmd_bits = 8,
+        .lcd_param_bits = 8,
+    };
+    err = esp_lcd_new_panel_io_i2c(bus, &io_cfg, &io);
+    if (err!=ESP_OK) return err;
+
+    // panel
+    esp_lcd_panel_dev_config_t panel_cfg = {
+        .bits_per_pixel = 1,
+        .reset_gpio_num = -1,
+    };
+    err = esp_lcd_new_panel_ssd1306(io, &panel_cfg, &panel);
+    if (err!=ESP_OK) return err;
+
+    // init & turn on
+    esp_lcd_panel_init(panel);
+    esp_lcd_panel_disp_on_off(panel, true);
+    return ESP_OK;
+}
+
+esp_err_t mono_panel_draw(int page, int x0, int x1, const uint8_t *cols)
+{
+    return esp_lcd_panel_draw_bitmap(panel,
+                                     x0, page*PAGE_H,
+                                     x1, (page+1)*PAGE_H,
+                                     cols);
+}
+
+esp_err_t mono_panel_start_line(int line)
+{
+    return esp_lcd_panel_io_tx_param(io, CMD_START_LINE | line, NULL, 0);
+}
+
+void mono_panel_frame_done(void)
+{
+}
@@ -0,0 +1,223 @@
+//
+// Created by deity on 17.10.2026.
+//
+#include "msg_bus.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+
+static const char *TAG = "msg_bus";
+
+_Static_assert(MSG_BUS_POOL <= 32, "pool bitmap is one 32-bit word");
+
+struct msg_sub {
+    QueueHandle_t q;
+};
+
+typedef struct {
+    msg_sub_t  *subs[MSG_BUS_MAX_SUBS];
+    uint32_t    nsubs;
+    uint32_t    depth;
+    atomic_uint inflight;
+    struct {
+        atomic_uint published;
+        atomic_uint no_pool;
+        atomic_uint over_depth;
+        atomic_uint queue_full;
+    } stats;
+} topic_t;
+
+static msg_t pool[MSG_BUS_POOL];
+static atomic_uint free_mask;               // 1 - блок свободен
+static topic_t topics[MSG_TOPIC_MAX];
+
+esp_err_t msg_bus_init(void)
+{
+    memset(pool, 0, sizeof(pool));
+    memset(topics, 0, sizeof(topics));
+    for (int i = 0; i < MSG_TOPIC_MAX; i++) {
+        topics[i].depth = MSG_BUS_DEFAULT_DEPTH;
+    }
+    atomic_store(&free_mask, MSG_BUS_POOL == 32 ? UINT32_MAX : (1u << MSG_BUS_POOL) - 1);
+    return ESP_OK;
+}
+
+void msg_bus_set_depth(msg_topic_t topic, uint32_t depth)
+{
+    if (topic < MSG_TOPIC_MAX && depth > 0) {
+        topics[topic].depth = depth;
+    }
+}
+
+msg_sub_t *msg_bus_sub_create(uint32_t depth)
+{
+    msg_sub_t *sub = calloc(1, sizeof(*sub));
+    if (!sub) return NULL;
+
+    sub->q = xQueueCreate(depth, sizeof(msg_t *));
+    if (!sub->q) {
+        free(sub);
+        return NULL;
+    }
+    return sub;
+}
+
+esp_err_t msg_bus_subscribe(msg_sub_t *sub, msg_topic_t topic)
+{
+    if (!sub || topic >= MSG_TOPIC_MAX) return ESP_ERR_INVALID_ARG;
+
+    topic_t *t = &topics[topic];
+    if (t->nsubs >= MSG_BUS_MAX_SUBS) return ESP_ERR_NO_MEM;
+    t->subs[t->nsubs] = sub;
+    // публикующий видит подписчика только после того, как тот записан
+    atomic_thread_fence(memory_order_release);
+    t->nsubs++;
+    return ESP_OK;
+}
+
+IRAM_ATTR msg_t *msg_bus_alloc(msg_type_t type, size_t len)
+{
+    if (len > MSG_BUS_PAYLOAD) return NULL;
+
+    unsigned mask = atomic_load(&free_mask);
+    unsigned bit;
+    do {
+        if (!mask) return NULL;
+        bit = mask & -mask;
+    } while (!atomic_compare_exchange_weak(&free_mask, &mask, mask & ~bit));
+
+    msg_t *msg = &pool[__builtin_ctz(bit)];
+    msg->type = type;
+    msg->topic = MSG_TOPIC_MAX;
+    msg->len = len;
+    atomic_store(&msg->refs, 1);
+    return msg;
+}
+
+void IRAM_ATTR msg_bus_release(msg_t *msg)
+{
+    if (!msg) return;
+    if (atomic_fetch_sub(&msg->refs, 1) != 1) return;
+
+    if (msg->topic < MSG_TOPIC_MAX) {
+        atomic_fetch_sub(&topics[msg->topic].inflight, 1);
+    }
+    atomic_fetch_or(&free_mask, 1u << (msg - pool));
+}
+
+static esp_err_t IRAM_ATTR publish(msg_topic_t topic, msg_t *msg, bool isr, BaseType_t *woken)
+{
+    if (!msg) return ESP_ERR_INVALID_ARG;
+    if (topic >= MSG_TOPIC_MAX) {
+        msg_bus_release(msg);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    topic_t *t = &topics[topic];
+    uint32_t nsubs = t->nsubs;
+    atomic_thread_fence(memory_order_acquire);
+    if (nsubs == 0) {
+        msg_bus_release(msg);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // глубина темы: сколько её сообщений ещё не отпущено подписчиками
+    if (atomic_fetch_add(&t->inflight, 1) >= t->depth) {
+        atomic_fetch_sub(&t->inflight, 1);
+        atomic_fetch_add(&t->stats.over_depth, 1);
+        msg_bus_release(msg);
+        return ESP_FAIL;
+    }
+    msg->topic = topic;
+
+    uint32_t delivered = 0;
+    for (uint32_t i = 0; i < nsubs; i++) {
+        atomic_fetch_add(&msg->refs, 1);
+        BaseType_t ok = isr ? xQueueSendFromISR(t->subs[i]->q, &msg, woken)
+                            : xQueueSend(t->subs[i]->q, &msg, 0);
+        if (ok == pdTRUE) {
+            delivered++;
+        } else {
+            atomic_fetch_sub(&msg->refs, 1);
+            atomic_fetch_add(&t->stats.queue_full, 1);
+        }
+    }
+    if (delivered) atomic_fetch_add(&t->stats.published, 1);
+
+    // ссылка публикующего
+    msg_bus_release(msg);
+    return delivered ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t msg_bus_publish(msg_topic_t topic, msg_t *msg)
+{
+    return publish(topic, msg, false, NULL);
+}
+
+esp_err_t IRAM_ATTR msg_bus_publish_from_isr(msg_topic_t topic, msg_t *msg, BaseType_t *woken)
+{
+    return publish(topic, msg, true, woken);
+}
+
+static esp_err_t IRAM_ATTR post(msg_topic_t topic, msg_type_t type, const void *data, size_t len,
+                                bool isr, BaseType_t *woken)
+{
+    if (topic >= MSG_TOPIC_MAX || (!data && len)) return ESP_ERR_INVALID_ARG;
+    if (len > MSG_BUS_PAYLOAD) return ESP_ERR_INVALID_SIZE;
+
+    msg_t *msg = msg_bus_alloc(type, len);
+    if (!msg) {
+        atomic_fetch_add(&topics[topic].stats.no_pool, 1);
+        return ESP_ERR_NO_MEM;
+    }
+    if (len) memcpy(msg->data, data, len);
+    return publish(topic, msg, isr, woken);
+}
+
+esp_err_t msg_bus_post(msg_topic_t topic, msg_type_t type, const void *data, size_t len)
+{
+    return post(topic, type, data, len, false, NULL);
+}
+
+esp_err_t IRAM_ATTR msg_bus_post_from_isr(msg_topic_t topic, msg_type_t type, const void *data, size_t len,
+                                          BaseType_t *woken)
+{
+    return post(topic, type, data, len, true, woken);
+}
+
+esp_err_t msg_bus_post_text(msg_topic_t topic, const char *text)
+{
+    if (!text) return ESP_ERR_INVALID_ARG;
+
+    size_t len = strnlen(text, MSG_BUS_PAYLOAD - 1);
+    msg_t *msg = msg_bus_alloc(MSG_TEXT, len + 1);
+    if (!msg) {
+        if (topic < MSG_TOPIC_MAX) atomic_fetch_add(&topics[topic].stats.no_pool, 1);
+        ESP_LOGD(TAG, "Pool empty, text dropped");
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(msg->data, text, len);
+    msg->data[len] = '\0';
+    return publish(topic, msg, false, NULL);
+}
+
+msg_t *msg_bus_receive(msg_sub_t *sub, TickType_t wait)
+{
+    msg_t *msg = NULL;
+    if (!sub || xQueueReceive(sub->q, &msg, wait) != pdTRUE) return NULL;
+    return msg;
+}
+
+void msg_bus_get_stats(msg_topic_t topic, msg_bus_topic_stats_t *out)
+{
+    if (topic >= MSG_TOPIC_MAX || !out) return;
+
+    topic_t *t = &topics[topic];
+    out->published = atomic_load(&t->stats.published);
+    out->no_pool = atomic_load(&t->stats.no_pool);
+    out->over_depth = atomic_load(&t->stats.over_depth);
+    out->queue_full = atomic_load(&t->stats.queue_full);
+}
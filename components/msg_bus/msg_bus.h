@@ -0,0 +1,131 @@
+//
+// Created by deity on 17.10.2026.
+//
+#pragma once
+
+#ifndef MSG_BUS_H
+#define MSG_BUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+// Шина сообщений между модулями: BLE, UART, датчики -> дисплей и лог.
+// Сообщения лежат в общем пуле блоков и передаются по указателю, каждый
+// подписчик получает ссылку и обязан вернуть её через msg_bus_release().
+// Блок возвращается в пул, когда отпущена последняя ссылка.
+//
+// Пул - битовая маска под атомиками, без мьютексов, поэтому выделять и
+// публиковать можно и из ISR (_from_isr варианты).
+#define MSG_BUS_POOL            32      // блоков в пуле, не больше 32
+#define MSG_BUS_PAYLOAD         64      // байт данных в блоке
+#define MSG_BUS_MAX_SUBS        4       // подписчиков на тему
+#define MSG_BUS_DEFAULT_DEPTH   8       // сообщений темы в обработке одновременно
+
+typedef enum {
+    MSG_TOPIC_DISPLAY,      // текст и команды экрана, пишется и в лог
+    MSG_TOPIC_SPP,          // в кольце приёма ble есть данные
+    MSG_TOPIC_UART,         // строки с UART, см. uart_ingest
+    MSG_TOPIC_SENSOR,       // показания датчиков
+    MSG_TOPIC_MAX,
+} msg_topic_t;
+
+typedef enum {
+    MSG_TEXT,               // data - строка с нулём в конце
+    MSG_ICON,               // data[0] - номер иконки
+    MSG_CLEAR,
+    MSG_SPP_DATA,           // без данных, см. bt_spp_receive()
+    MSG_SENSOR_VALUE,
+} msg_type_t;
+
+typedef struct {
+    uint8_t     type;       // msg_type_t
+    uint8_t     topic;      // msg_topic_t, заполняется при публикации
+    uint16_t    len;
+    atomic_uint refs;
+    uint8_t     data[MSG_BUS_PAYLOAD];
+} msg_t;
+
+typedef struct {
+    uint32_t published;     // accepted and queued to at least one subscriber
+    uint32_t no_pool;       // allocations that found the pool empty
+    uint32_t over_depth;    // rejected, topic already had depth messages in flight
+    uint32_t queue_full;    // deliveries lost because a subscriber queue was full
+} msg_bus_topic_stats_t;
+
+typedef struct msg_sub msg_sub_t;
+
+/**
+ * @brief Create the pool and topics; call once before anything else
+ * @return ESP_OK on success
+ */
+esp_err_t msg_bus_init(void);
+
+/**
+ * @brief Limit the number of messages of \p topic in flight (not yet released)
+ */
+void msg_bus_set_depth(msg_topic_t topic, uint32_t depth);
+
+/**
+ * @brief Create a subscriber queue
+ * @param depth  messages it can hold over all of its topics
+ * @return subscriber, or NULL if out of memory
+ */
+msg_sub_t *msg_bus_sub_create(uint32_t depth);
+
+/**
+ * @brief Deliver \p topic to \p sub as well; not from ISR, do it at start-up
+ * @return ESP_ERR_NO_MEM if the topic has MSG_BUS_MAX_SUBS subscribers already
+ */
+esp_err_t msg_bus_subscribe(msg_sub_t *sub, msg_topic_t topic);
+
+/**
+ * @brief Take a block from the pool, ISR safe
+ * @param len  payload length, at most MSG_BUS_PAYLOAD
+ * @return message with one reference held by the caller, or NULL
+ */
+msg_t *msg_bus_alloc(msg_type_t type, size_t len);
+
+/**
+ * @brief Publish a message, the caller's reference passes to the bus
+ *
+ * The message is freed right away if nobody is subscribed to \p topic.
+ *
+ * @return ESP_OK if at least one subscriber got it, ESP_ERR_NOT_FOUND if
+ *         there are no subscribers, ESP_FAIL if it was dropped
+ */
+esp_err_t msg_bus_publish(msg_topic_t topic, msg_t *msg);
+esp_err_t msg_bus_publish_from_isr(msg_topic_t topic, msg_t *msg, BaseType_t *woken);
+
+/**
+ * @brief Allocate, copy \p data and publish
+ *
+ * @return ESP_ERR_INVALID_ARG if \p data is NULL with a nonzero \p len,
+ *         ESP_ERR_INVALID_SIZE if \p len is over MSG_BUS_PAYLOAD
+ */
+esp_err_t msg_bus_post(msg_topic_t topic, msg_type_t type, const void *data, size_t len);
+esp_err_t msg_bus_post_from_isr(msg_topic_t topic, msg_type_t type, const void *data, size_t len,
+                                BaseType_t *woken);
+
+/**
+ * @brief Publish a MSG_TEXT, cut to MSG_BUS_PAYLOAD - 1 characters
+ */
+esp_err_t msg_bus_post_text(msg_topic_t topic, const char *text);
+
+/**
+ * @brief Wait for the next message of any subscribed topic
+ * @return message (release it when done), or NULL on timeout
+ */
+msg_t *msg_bus_receive(msg_sub_t *sub, TickType_t wait);
+
+/**
+ * @brief Drop a reference, ISR safe
+ */
+void msg_bus_release(msg_t *msg);
+
+void msg_bus_get_stats(msg_topic_t topic, msg_bus_topic_stats_t *out);
+
+#endif //MSG_BUS_H
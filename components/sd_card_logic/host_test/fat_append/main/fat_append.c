@@ -0,0 +1,354 @@
+//
+// Created by deity on 17.10.2026.
+//
+// Дописывание коротких строк в лог на образе FAT: как main_cycle делал до
+// sd_log и как пишет sd_log.
+//
+// Образ - обычный файл, FatFs работает с ним через свой драйвер diskio,
+// который считает команды чтения/записи секторов и может добавлять задержку
+// на команду, как у SD по SPI. fopen/fileno/fsync обёрнуты (--wrap): пути под
+// FAT_ROOT открываются в FatFs и отдаются как FILE* через fopencookie, так
+// что sd_log и старый код работают без изменений.
+//
+// 1. before: на каждую строку get_file_size() дважды (fopen/fseek/ftell/
+//    fclose) и fopen("ab")/fwrite/fclose - тело case DISP_TEXT до sd_log.
+// 2. after: sd_log_append_line() с настройками по умолчанию, файл открыт
+//    всё время, в конце sd_log_close() (последний сброс и fsync).
+//
+// Перед каждым прогоном образ форматируется заново. После прогона файл
+// читается обратно и сверяется построчно.
+//
+// Переменные окружения: FAT_APPEND_IMAGE (fat.img), FAT_APPEND_MB (32),
+// FAT_APPEND_COUNT (2000), FAT_APPEND_CMD_US (0, задержка на команду).
+//
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "ff.h"
+#include "diskio_impl.h"
+#include "sd_log.h"
+
+#define SECTOR_SIZE     512
+#define FAT_ROOT        "/fat/"
+#define LOG_PATH        FAT_ROOT "LOG.TXT"
+#define LINE_LEN        31      // + '\n' = 32 байта, как строка с экрана
+#define FILES_MAX       4
+#define FD_BASE         1000    // fileno() для файлов FatFs
+
+typedef struct {
+    uint32_t reads, writes;     // команд
+    uint32_t rd_sectors, wr_sectors;
+} io_stats_t;
+
+static int img = -1;
+static uint32_t img_sectors;
+static int cmd_us;
+static io_stats_t io;
+static char drv[3];
+
+/* ---------- Образ как диск ---------- */
+
+static void command(void)
+{
+    if (cmd_us) usleep(cmd_us);
+}
+
+static DSTATUS img_init(unsigned char pdrv)
+{
+    return 0;
+}
+
+static DSTATUS img_status(unsigned char pdrv)
+{
+    return 0;
+}
+
+static DRESULT img_read(unsigned char pdrv, unsigned char *buff, uint32_t sector, unsigned count)
+{
+    io.reads++;
+    io.rd_sectors += count;
+    command();
+    ssize_t n = pread(img, buff, (size_t)count * SECTOR_SIZE, (off_t)sector * SECTOR_SIZE);
+    return n == (ssize_t)count * SECTOR_SIZE ? RES_OK : RES_ERROR;
+}
+
+static DRESULT img_write(unsigned char pdrv, const unsigned char *buff, uint32_t sector, unsigned count)
+{
+    io.writes++;
+    io.wr_sectors += count;
+    command();
+    ssize_t n = pwrite(img, buff, (size_t)count * SECTOR_SIZE, (off_t)sector * SECTOR_SIZE);
+    return n == (ssize_t)count * SECTOR_SIZE ? RES_OK : RES_ERROR;
+}
+
+static DRESULT img_ioctl(unsigned char pdrv, unsigned char cmd, void *buff)
+{
+    switch (cmd) {
+        case CTRL_SYNC:
+            return fdatasync(img) == 0 ? RES_OK : RES_ERROR;
+        case GET_SECTOR_COUNT:
+            *(LBA_t *)buff = img_sectors;
+            return RES_OK;
+        case GET_SECTOR_SIZE:
+            *(WORD *)buff = SECTOR_SIZE;
+            return RES_OK;
+        case GET_BLOCK_SIZE:
+            *(DWORD *)buff = 1;
+            return RES_OK;
+        case CTRL_TRIM:
+            return RES_OK;
+        default:
+            return RES_PARERR;
+    }
+}
+
+static const ff_diskio_impl_t img_impl = {
+    .init = img_init,
+    .status = img_status,
+    .read = img_read,
+    .write = img_write,
+    .ioctl = img_ioctl,
+};
+
+// Часы для FatFs; если vfs_fat в сборке, берётся его версия
+__attribute__((weak)) DWORD get_fattime(void)
+{
+    return ((DWORD)(2026 - 1980) << 25) | (10 << 21) | (17 << 16);
+}
+
+/* ---------- stdio поверх FatFs ---------- */
+
+typedef struct {
+    FIL   fil;
+    FILE *f;
+    bool  used;
+} ff_file_t;
+
+static ff_file_t files[FILES_MAX];
+
+FILE *__real_fopen(const char *path, const char *mode);
+int __real_fileno(FILE *f);
+int __real_fsync(int fd);
+
+static ssize_t ff_cookie_read(void *cookie, char *buf, size_t size)
+{
+    UINT n;
+    return f_read(&((ff_file_t *)cookie)->fil, buf, size, &n) == FR_OK ? (ssize_t)n : -1;
+}
+
+static ssize_t ff_cookie_write(void *cookie, const char *buf, size_t size)
+{
+    UINT n = 0;
+    // fopencookie: 0 - ошибка записи
+    f_write(&((ff_file_t *)cookie)->fil, buf, size, &n);
+    return n;
+}
+
+static int ff_cookie_seek(void *cookie, off64_t *pos, int whence)
+{
+    FIL *fil = &((ff_file_t *)cookie)->fil;
+    off64_t base = whence == SEEK_SET ? 0 : whence == SEEK_CUR ? (off64_t)f_tell(fil) : (off64_t)f_size(fil);
+    if (base + *pos < 0 || f_lseek(fil, (FSIZE_t)(base + *pos)) != FR_OK) return -1;
+    *pos = (off64_t)f_tell(fil);
+    return 0;
+}
+
+static int ff_cookie_close(void *cookie)
+{
+    ff_file_t *file = cookie;
+    FRESULT res = f_close(&file->fil);
+    file->used = false;
+    return res == FR_OK ? 0 : -1;
+}
+
+static ff_file_t *ff_file_find(FILE *f)
+{
+    for (int i = 0; i < FILES_MAX; i++) {
+        if (files[i].used && files[i].f == f) return &files[i];
+    }
+    return NULL;
+}
+
+FILE *__wrap_fopen(const char *path, const char *mode)
+{
+    if (strncmp(path, FAT_ROOT, strlen(FAT_ROOT)) != 0) return __real_fopen(path, mode);
+
+    BYTE flags = strchr(mode, '+') ? FA_READ | FA_WRITE : 0;
+    if (mode[0] == 'r') flags |= FA_READ;
+    else if (mode[0] == 'w') flags |= FA_WRITE | FA_CREATE_ALWAYS;
+    else if (mode[0] == 'a') flags |= FA_WRITE | FA_OPEN_APPEND;
+
+    ff_file_t *file = NULL;
+    for (int i = 0; i < FILES_MAX && !file; i++) {
+        if (!files[i].used) file = &files[i];
+    }
+    char ff_path[64];
+    snprintf(ff_path, sizeof(ff_path), "%s/%s", drv, path + strlen(FAT_ROOT));
+    if (!file || f_open(&file->fil, ff_path, flags) != FR_OK) return NULL;
+
+    cookie_io_functions_t fns = {
+        .read = ff_cookie_read,
+        .write = ff_cookie_write,
+        .seek = ff_cookie_seek,
+        .close = ff_cookie_close,
+    };
+    file->used = true;
+    file->f = fopencookie(file, mode, fns);
+    if (!file->f) {
+        f_close(&file->fil);
+        file->used = false;
+    }
+    return file->f;
+}
+
+int __wrap_fileno(FILE *f)
+{
+    ff_file_t *file = ff_file_find(f);
+    return file ? FD_BASE + (int)(file - files) : __real_fileno(f);
+}
+
+int __wrap_fsync(int fd)
+{
+    if (fd < FD_BASE || fd >= FD_BASE + FILES_MAX) return __real_fsync(fd);
+    return f_sync(&files[fd - FD_BASE].fil) == FR_OK ? 0 : -1;
+}
+
+/* ---------- Прогоны ---------- */
+
+static bool format(void)
+{
+    static FATFS fs;
+    static uint8_t work[FF_MAX_SS];
+    MKFS_PARM opt = { .fmt = FM_ANY };
+
+    f_mount(NULL, drv, 0);
+    if (f_mkfs(drv, &opt, work, sizeof(work)) != FR_OK) return false;
+    if (f_mount(&fs, drv, 1) != FR_OK) return false;
+
+    // как на карте после первой записи: файл уже есть
+    FILE *f = fopen(LOG_PATH, "wb");
+    if (!f) return false;
+    fclose(f);
+    return true;
+}
+
+static void line(char *buf, uint32_t i)
+{
+    int n = snprintf(buf, LINE_LEN + 1, "msg %05lu ", (unsigned long)i);
+    while (n < LINE_LEN) {
+        buf[n] = 'a' + (n % 26);
+        n++;
+    }
+    buf[LINE_LEN] = '\0';
+}
+
+// get_file_size() и тело case DISP_TEXT из main_cycle до sd_log
+static long get_file_size(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    if (fseek(f, 0, SEEK_END) != 0) {
+        fclose(f);
+        return -1;
+    }
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+static bool append_before(const char *text)
+{
+    long old_size = get_file_size(LOG_PATH);
+    FILE *f = fopen(LOG_PATH, "ab");
+    if (!f) return false;
+    fwrite(text, 1, strlen(text), f);
+    fwrite("\n", 1, 1, f);
+    fclose(f);
+    return get_file_size(LOG_PATH) == old_size + (long)strlen(text) + 1;
+}
+
+static bool same_content(uint32_t count)
+{
+    char expect[LINE_LEN + 1], got[LINE_LEN + 2];
+    FILE *f = fopen(LOG_PATH, "rb");
+    if (!f) return false;
+
+    bool same = true;
+    for (uint32_t i = 0; i < count && same; i++) {
+        line(expect, i);
+        same = fread(got, 1, LINE_LEN + 1, f) == LINE_LEN + 1
+               && memcmp(got, expect, LINE_LEN) == 0 && got[LINE_LEN] == '\n';
+    }
+    same = same && fread(got, 1, 1, f) == 0;
+    fclose(f);
+    return same;
+}
+
+static double run(const char *name, uint32_t count, bool with_log)
+{
+    char text[LINE_LEN + 1];
+    sd_log_t log;
+    bool ok = format();
+
+    memset(&io, 0, sizeof(io));
+    int64_t start = esp_timer_get_time();
+    if (ok && with_log) ok = sd_log_open(&log, LOG_PATH, NULL) == ESP_OK;
+    for (uint32_t i = 0; i < count && ok; i++) {
+        line(text, i);
+        ok = with_log ? sd_log_append_line(&log, text) == ESP_OK : append_before(text);
+    }
+    if (ok && with_log) ok = sd_log_close(&log) == ESP_OK;
+    int64_t us = esp_timer_get_time() - start;
+    io_stats_t st = io;
+
+    ok = ok && same_content(count);
+    double rate = count / (us / 1e6);
+    printf("%-6s: %lu appends in %lld ms (%.0f/s); per append %.2f reads (%.2f sectors), "
+           "%.2f writes (%.2f sectors)%s\n",
+           name, (unsigned long)count, (long long)us / 1000, rate,
+           (double)st.reads / count, (double)st.rd_sectors / count,
+           (double)st.writes / count, (double)st.wr_sectors / count,
+           ok ? "" : ", FAILED");
+    return ok ? rate : 0;
+}
+
+void app_main(void)
+{
+    const char *path = getenv("FAT_APPEND_IMAGE");
+    if (!path) path = "fat.img";
+    const char *env = getenv("FAT_APPEND_MB");
+    uint32_t mb = env ? (uint32_t)atoi(env) : 32;
+    env = getenv("FAT_APPEND_COUNT");
+    uint32_t count = env ? (uint32_t)atoi(env) : 2000;
+    env = getenv("FAT_APPEND_CMD_US");
+    cmd_us = env ? atoi(env) : 0;
+
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    img = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    img_sectors = mb * 1024 * 1024 / SECTOR_SIZE;
+    BYTE pdrv = 0xFF;
+    if (img < 0 || ftruncate(img, (off_t)img_sectors * SECTOR_SIZE) != 0
+        || ff_diskio_get_drive(&pdrv) != ESP_OK || pdrv == 0xFF) {
+        printf("image %s: setup failed\n", path);
+        exit(1);
+    }
+    ff_diskio_register(pdrv, &img_impl);
+    drv[0] = (char)('0' + pdrv);
+    drv[1] = ':';
+
+    double before = run("before", count, false);
+    double after = run("after", count, true);
+
+    bool ok = before > 0 && after > 0;
+    printf("%lu appends of %d B, %lu MB image, %d us per command: before %.0f/s, after %.0f/s (x%.1f): %s\n",
+           (unsigned long)count, LINE_LEN + 1, (unsigned long)mb, cmd_us, before, after,
+           before > 0 ? after / before : 0, ok ? "OK" : "FAILED");
+    fflush(stdout);
+    exit(ok ? 0 : 1);
+}
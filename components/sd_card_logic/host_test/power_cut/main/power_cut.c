@@ -0,0 +1,357 @@
+//
+// Created by deity on 17.10.2026.
+//
+// Обрыв питания в случайный момент записи лога.
+//
+// Все изменения на "карте" (fopen на запись, fwrite, rename, unlink) идут
+// через счётчик: каждый байт fwrite и каждая операция над файлом - единица.
+// Дочерний процесс гоняет нагрузку (короткие сессии писателя, ротации,
+// компактация) и умирает через _exit(), когда счётчик дошёл до случайного
+// порога, - посреди fwrite остаётся только начало буфера. Второй процесс
+// поднимает лог как после загрузки и проверяет:
+//   - манифест читается, MANIFEST.TMP подхвачен или удалён;
+//   - на диске нет сегментов вне манифеста (GC при старте);
+//   - записи идут подряд с seq 0 без дыр и с верными данными;
+//   - после восстановления писатель продолжает лог без разрыва.
+//
+// Кроме случайных порогов, обрыв ставится ровно перед каждым rename полного
+// прогона. Переменные окружения: POWER_CUT_RUNS (200), POWER_CUT_SEED (время).
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sd_card_logic.h"
+#include "sd_segment.h"
+#include "sd_writer.h"
+
+#define LOG_DIR         SD_CARD_MOUNT_POINT "/pcut"
+#define SESSIONS        400     // ~1.6 МБ: 6 ротаций и компактация
+#define TAIL_RECORDS    10
+#define CUT_EXIT        3
+
+#define RENAMES_MAX     64
+
+static long long budget = -1;           // -1 - без обрыва
+static atomic_llong spent;
+
+// Где в полном прогоне были rename: обрыв ровно перед ним оставляет только
+// MANIFEST.TMP, а случайный байт в это окно почти не попадает
+static long long renames[RENAMES_MAX];
+static atomic_int renames_count;
+
+/* ---------- Счётчик записи на карту ---------- */
+
+FILE *__real_fopen(const char *path, const char *mode);
+size_t __real_fwrite(const void *data, size_t size, size_t n, FILE *f);
+int __real_rename(const char *from, const char *to);
+int __real_unlink(const char *path);
+
+// Сколько единиц из n ещё можно потратить до обрыва
+static long long take(long long n)
+{
+    long long before = atomic_fetch_add(&spent, n);
+    if (budget < 0 || before + n <= budget) return n;
+    return before < budget ? budget - before : 0;
+}
+
+static void power_off(void)
+{
+    _exit(CUT_EXIT);
+}
+
+FILE *__wrap_fopen(const char *path, const char *mode)
+{
+    if (strpbrk(mode, "wa") && take(1) < 1) power_off();
+    return __real_fopen(path, mode);
+}
+
+size_t __wrap_fwrite(const void *data, size_t size, size_t n, FILE *f)
+{
+    long long bytes = (long long)(size * n);
+    long long ok = take(bytes);
+    if (ok < bytes) {
+        // до карты доходит только начало буфера
+        __real_fwrite(data, 1, (size_t)ok, f);
+        fflush(f);
+        power_off();
+    }
+    return __real_fwrite(data, size, n, f);
+}
+
+int __wrap_rename(const char *from, const char *to)
+{
+    if (budget < 0) {
+        long long at = atomic_fetch_add(&spent, 1);
+        int i = atomic_fetch_add(&renames_count, 1);
+        if (i < RENAMES_MAX) renames[i] = at;
+    } else if (take(1) < 1) {
+        power_off();
+    }
+    return __real_rename(from, to);
+}
+
+int __wrap_unlink(const char *path)
+{
+    if (take(1) < 1) power_off();
+    return __real_unlink(path);
+}
+
+/* ---------- Нагрузка ---------- */
+
+static void fill(uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)(len + i * 7);
+    }
+}
+
+// Короткие сессии писателя: каждая начинается с нового блока, поэтому
+// сегменты выходят рыхлыми и компактация находит, что сжать
+static void workload(void)
+{
+    uint8_t buf[256];
+    srand(1);
+
+    if (sd_segment_init(LOG_DIR) != ESP_OK) exit(1);
+    for (int s = 0; s < SESSIONS; s++) {
+        if (sd_writer_start() != ESP_OK) exit(1);
+        int records = 1 + rand() % 24;
+        for (int i = 0; i < records; i++) {
+            size_t len = 8 + rand() % (sizeof(buf) - 8);
+            fill(buf, len);
+            while (sd_writer_write_record(SD_REC_RAW, buf, len) == ESP_ERR_NO_MEM) {
+                vTaskDelay(1);
+            }
+        }
+        sd_writer_stop();
+    }
+    // даём компактации догнать последнюю ротацию
+    vTaskDelay(pdMS_TO_TICKS(200));
+    sd_segment_deinit();
+}
+
+/* ---------- Проверка после "загрузки" ---------- */
+
+typedef struct {
+    uint32_t next;
+    uint32_t bad;
+} check_t;
+
+static bool check_record(const sd_record_t *rec, void *arg)
+{
+    check_t *c = arg;
+    uint8_t buf[256];
+
+    fill(buf, rec->len);
+    if (rec->seq != c->next || rec->len > sizeof(buf) || memcmp(rec->data, buf, rec->len) != 0) {
+        if (!c->bad) printf("record %lu: expected seq %lu\n", (unsigned long)rec->seq, (unsigned long)c->next);
+        c->bad++;
+    }
+    c->next = rec->seq + 1;
+    return true;
+}
+
+static int count_files(const char *prefix)
+{
+    DIR *d = opendir(LOG_DIR);
+    if (!d) return 0;
+    int n = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (strncmp(e->d_name, prefix, strlen(prefix)) == 0) n++;
+    }
+    closedir(d);
+    return n;
+}
+
+static bool exists(const char *name)
+{
+    char path[64];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s", LOG_DIR, name);
+    return stat(path, &st) == 0;
+}
+
+// Код выхода: 0 - всё верно, 1 - ошибка; в stdout строка для родителя
+static int check(void)
+{
+    bool tmp = exists("MANIFEST.TMP") && !exists("MANIFEST.BIN");
+    int before = count_files("SEG");
+
+    if (sd_segment_init(LOG_DIR) != ESP_OK) {
+        printf("init failed\n");
+        return 1;
+    }
+    if (exists("MANIFEST.TMP") || !exists("MANIFEST.BIN")) {
+        printf("manifest not recovered\n");
+        return 1;
+    }
+    int orphans = before - count_files("SEG");
+
+    check_t c = { 0 };
+    sd_segment_read_last(UINT32_MAX, check_record, &c);
+    uint32_t records = c.next;
+
+    // писатель продолжает с хвоста, даже если тот оборван посреди блока
+    uint8_t buf[64];
+    fill(buf, sizeof(buf));
+    if (sd_writer_start() != ESP_OK) {
+        printf("writer failed\n");
+        return 1;
+    }
+    for (int i = 0; i < TAIL_RECORDS; i++) {
+        sd_writer_write_record(SD_REC_RAW, buf, sizeof(buf));
+    }
+    sd_writer_stop();
+
+    c = (check_t){ 0 };
+    sd_segment_read_last(UINT32_MAX, check_record, &c);
+    sd_segment_deinit();
+
+    bool ok = !c.bad && c.next == records + TAIL_RECORDS;
+    printf("CHECK %d %lu %d %d\n", ok, (unsigned long)records, tmp, orphans);
+    return ok ? 0 : 1;
+}
+
+/* ---------- Родитель ---------- */
+
+static void wipe(void)
+{
+    DIR *d = opendir(LOG_DIR);
+    if (!d) return;
+    struct dirent *e;
+    char path[300];
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", LOG_DIR, e->d_name);
+        __real_unlink(path);
+    }
+    closedir(d);
+}
+
+// Запуск себя же с режимом в окружении; строки результата (CHECK, SPENT,
+// RENAME) собираются в out. Возвращает код выхода.
+static int spawn(const char *exe, const char *mode, long long cut, char *out, size_t out_size)
+{
+    char cmd[512], arg[32];
+    snprintf(arg, sizeof(arg), "%lld", cut);
+    setenv("POWER_CUT_MODE", mode, 1);
+    setenv("POWER_CUT_BUDGET", arg, 1);
+    snprintf(cmd, sizeof(cmd), "'%s'", exe);
+
+    FILE *p = popen(cmd, "r");
+    if (!p) return -1;
+    char line[256];
+    size_t len = 0;
+    if (out) out[0] = '\0';
+    while (fgets(line, sizeof(line), p)) {
+        if (out && len < out_size && (strncmp(line, "CHECK ", 6) == 0 || strncmp(line, "SPENT ", 6) == 0
+                                      || strncmp(line, "RENAME ", 7) == 0)) {
+            len += snprintf(out + len, out_size - len, "%s", line);
+        }
+    }
+    int st = pclose(p);
+    return WIFEXITED(st) ? WEXITSTATUS(st) : -1;
+}
+
+static int parent(void)
+{
+    char exe[256];
+    ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (n <= 0) return 1;
+    exe[n] = '\0';
+
+    const char *env = getenv("POWER_CUT_RUNS");
+    int runs = env ? atoi(env) : 200;
+    env = getenv("POWER_CUT_SEED");
+    unsigned seed = env ? (unsigned)atoi(env) : (unsigned)esp_timer_get_time();
+    srand(seed);
+
+    init_card("power_cut");
+    mkdir(LOG_DIR, 0775);
+    wipe();
+
+    // полный прогон без обрыва: сколько всего единиц записи и где rename
+    char out[4096];
+    long long total = 0;
+    int n_renames = 0;
+    if (spawn(exe, "work", -1, out, sizeof(out)) != 0) {
+        printf("workload failed\n");
+        return 1;
+    }
+    for (char *l = strtok(out, "\n"); l; l = strtok(NULL, "\n")) {
+        long long v;
+        if (sscanf(l, "SPENT %lld", &v) == 1) total = v;
+        if (sscanf(l, "RENAME %lld", &v) == 1 && n_renames < RENAMES_MAX) renames[n_renames++] = v;
+    }
+    if (total <= 0) {
+        printf("workload failed\n");
+        return 1;
+    }
+    if (spawn(exe, "check", -1, out, sizeof(out)) != 0) {
+        printf("check of the full run failed: %s", out);
+        return 1;
+    }
+    printf("Full run: %lld units, %s", total, out);
+
+    // сначала обрывы перед каждым rename, затем случайные
+    int failed = 0, cut = 0, tmp = 0, orphans = 0;
+    runs += n_renames;
+    for (int i = 0; i < runs; i++) {
+        wipe();
+        long long at = i < n_renames ? renames[i] : ((long long)rand() << 16 ^ rand()) % total;
+        int rc = spawn(exe, "work", at, NULL, 0);
+        if (rc == CUT_EXIT) cut++;
+
+        int ok, t, o;
+        unsigned long records;
+        if (spawn(exe, "check", -1, out, sizeof(out)) != 0
+            || sscanf(out, "CHECK %d %lu %d %d", &ok, &records, &t, &o) != 4 || !ok) {
+            printf("FAIL: seed %u, cut at %lld of %lld: %s\n", seed, at, total, out);
+            failed++;
+            continue;
+        }
+        tmp += t;
+        orphans += o > 0;
+    }
+    printf("%d runs (%d before rename), %d cut, %d failed; %d recovered from MANIFEST.TMP, "
+           "%d with orphan segments removed (seed %u)\n",
+           runs, n_renames, cut, failed, tmp, orphans, seed);
+    return failed ? 1 : 0;
+}
+
+void app_main(void)
+{
+    const char *mode = getenv("POWER_CUT_MODE");
+    const char *cut = getenv("POWER_CUT_BUDGET");
+    int rc;
+
+    if (!mode) {
+        rc = parent();
+    } else {
+        esp_log_level_set("*", ESP_LOG_NONE);
+        if (strcmp(mode, "work") == 0) {
+            budget = cut ? atoll(cut) : -1;
+            workload();
+            printf("SPENT %lld\n", (long long)atomic_load(&spent));
+            for (int i = 0; i < atomic_load(&renames_count) && i < RENAMES_MAX; i++) {
+                printf("RENAME %lld\n", renames[i]);
+            }
+            rc = 0;
+        } else {
+            rc = check();
+        }
+    }
+    fflush(stdout);
+    exit(rc);
+}
@@ -0,0 +1,206 @@
+//
+// Created by deity on 17.10.2026.
+//
+// Сбои записи блоков лога: карта отвечает ошибкой посреди fwrite.
+//
+// fwrite обёрнут (--wrap): каждая FAIL_EVERY-я запись куска кольца (от 1 КБ)
+// задачей-писателем доходит до файла только наполовину или не доходит вовсе
+// и возвращает короткий счёт. Каждый третий такой сбой валит и следующую мелкую запись
+// (добивку нулями), так что выравнивание откладывается до следующего куска.
+// Писатель должен вернуть файл на смещение кольца, иначе все следующие
+// блоки сегмента съезжают и поиск по индексам блоков читает мусор.
+//
+// Проверяется после остановки писателя:
+// - все прочитанные записи верны, seq растут;
+// - потеряны только записи сбойных кусков: их seq обёртка берёт из
+//   заголовков в самом куске, все остальные записи должны прочитаться;
+// - хвост лога и последние записи находятся по индексам блоков;
+// - на каждый сбой одна ошибка в статистике писателя.
+//
+// Переменная окружения: WRITE_ERROR_KB (1024) - объём лога со сбоями.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sd_card_logic.h"
+#include "sd_segment.h"
+#include "sd_writer.h"
+
+#define LOG_DIR         SD_CARD_MOUNT_POINT "/werr"
+#define FAIL_EVERY      7
+#define CHUNK_MIN       1024    // меньше - манифест или добивка
+#define MIN_LEN         8
+#define MAX_LEN         200
+#define TAIL_KB         16      // без сбоев в конце, чтобы хвост был известен
+#define TAIL_CHECK      10
+#define SEQ_MAX         65536
+
+static atomic_bool failing;
+static atomic_int chunks;
+static atomic_int failures;
+static atomic_bool fail_next_small;
+static bool doomed[SEQ_MAX];    // запись была в сбойном куске
+static bool seen[SEQ_MAX];
+
+// Записи сбойного куска: кусок начинается с границы блока, записи идут подряд
+// до нулей добивки
+static void mark_doomed(const uint8_t *p, size_t len)
+{
+    sd_record_hdr_t hdr;
+    for (size_t pos = 0; pos + sizeof(hdr) <= len; pos += sizeof(hdr) + hdr.len) {
+        memcpy(&hdr, p + pos, sizeof(hdr));
+        if (hdr.magic != SD_RECORD_MAGIC) {
+            // добивка до конца блока
+            pos = (pos | (SD_RECORD_BLOCK_SIZE - 1)) + 1 - sizeof(hdr);
+            hdr.len = 0;
+            continue;
+        }
+        if (hdr.type != SD_REC_INDEX && hdr.seq < SEQ_MAX) doomed[hdr.seq] = true;
+    }
+}
+
+size_t __real_fwrite(const void *data, size_t size, size_t n, FILE *f);
+size_t __wrap_fwrite(const void *data, size_t size, size_t n, FILE *f)
+{
+    size_t bytes = size * n;
+    // компактация пишет свои файлы, сбоит только задача-писатель
+    if (!atomic_load(&failing) || strcmp(pcTaskGetName(NULL), "sd_writer") != 0) {
+        return __real_fwrite(data, size, n, f);
+    }
+
+    if (bytes < CHUNK_MIN) {
+        if (atomic_exchange(&fail_next_small, false)) return 0;
+        return __real_fwrite(data, size, n, f);
+    }
+    int k = atomic_fetch_add(&chunks, 1);
+    if (k % FAIL_EVERY != FAIL_EVERY - 1) return __real_fwrite(data, size, n, f);
+
+    mark_doomed(data, bytes);
+    int i = atomic_fetch_add(&failures, 1);
+    if (i % 3 == 2) atomic_store(&fail_next_small, true);
+    // до карты доходит половина куска или ничего
+    size_t ok = i & 1 ? bytes / 2 : 0;
+    return __real_fwrite(data, 1, ok, f) / (size ? size : 1);
+}
+
+static void fill(uint8_t *buf, size_t len, uint32_t seq)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)(seq + i * 7);
+    }
+}
+
+typedef struct {
+    uint32_t read;
+    uint32_t bad;
+    int64_t  last;
+    uint32_t first_seq;
+} check_t;
+
+static bool check_record(const sd_record_t *rec, void *arg)
+{
+    check_t *c = arg;
+    uint8_t buf[MAX_LEN];
+
+    if (!c->read) c->first_seq = rec->seq;
+    fill(buf, rec->len < sizeof(buf) ? rec->len : sizeof(buf), rec->seq);
+    if ((int64_t)rec->seq <= c->last || rec->len < MIN_LEN || rec->len > MAX_LEN
+        || memcmp(rec->data, buf, rec->len) != 0) {
+        if (!c->bad) printf("record %lu after %lld is wrong\n", (unsigned long)rec->seq, (long long)c->last);
+        c->bad++;
+    }
+    if (rec->seq < SEQ_MAX) seen[rec->seq] = true;
+    c->last = rec->seq;
+    c->read++;
+    return true;
+}
+
+static void wipe(void)
+{
+    DIR *d = opendir(LOG_DIR);
+    if (!d) return;
+    struct dirent *e;
+    char path[300];
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", LOG_DIR, e->d_name);
+        unlink(path);
+    }
+    closedir(d);
+}
+
+static uint32_t produce(uint32_t seq, size_t bytes)
+{
+    uint8_t buf[MAX_LEN];
+    for (size_t done = 0; done < bytes; seq++) {
+        size_t len = MIN_LEN + rand() % (MAX_LEN - MIN_LEN + 1);
+        fill(buf, len, seq);
+        while (sd_writer_write_record(SD_REC_RAW, buf, len) == ESP_ERR_NO_MEM) {
+            vTaskDelay(1);
+        }
+        done += SD_RECORD_HDR_SIZE + len;
+    }
+    return seq;
+}
+
+void app_main(void)
+{
+    const char *env = getenv("WRITE_ERROR_KB");
+    size_t kb = env ? (size_t)atoi(env) : 1024;
+
+    esp_log_level_set("*", ESP_LOG_NONE);
+    srand(1);
+    init_card("write_error");
+    mkdir(LOG_DIR, 0775);
+    wipe();
+
+    if (sd_segment_init(LOG_DIR) != ESP_OK || sd_writer_start() != ESP_OK) {
+        printf("start failed\n");
+        exit(1);
+    }
+    atomic_store(&failing, true);
+    uint32_t seq = produce(0, kb * 1024);
+    atomic_store(&failing, false);
+    // ring целиком уходит на карту без сбоев, дальше только хорошие блоки
+    uint32_t total = produce(seq, TAIL_KB * 1024);
+
+    sd_writer_stats_t st;
+    sd_writer_get_stats(&st);
+    sd_writer_stop();
+
+    check_t all = { .last = -1 };
+    sd_segment_read_last(UINT32_MAX, check_record, &all);
+    check_t tail = { .last = -1 };
+    sd_segment_read_last(TAIL_CHECK, check_record, &tail);
+    uint32_t next_seq = 0;
+    uint64_t last_ts;
+    sd_segment_tail(&next_seq, &last_ts);
+    sd_segment_deinit();
+
+    int fails = atomic_load(&failures);
+    uint32_t lost = 0, in_failed = 0, missing = 0;
+    for (uint32_t i = 0; i < total && i < SEQ_MAX; i++) {
+        lost += !seen[i];
+        in_failed += doomed[i];
+        if (!seen[i] && !doomed[i] && !missing++) printf("record %lu is lost\n", (unsigned long)i);
+    }
+
+    bool ok = fails > 0 && total <= SEQ_MAX && all.bad == 0 && tail.bad == 0 && missing == 0
+              && tail.read == TAIL_CHECK && tail.first_seq == total - TAIL_CHECK
+              && next_seq == total && st.errors == (uint32_t)fails;
+    printf("%zu KB, %lu records: %d failed writes, %lu writer errors, %lu records lost (%lu in failed "
+           "writes), %lu wrong, tail %lu of %lu: %s\n",
+           kb, (unsigned long)total, fails, (unsigned long)st.errors, (unsigned long)lost,
+           (unsigned long)in_failed, (unsigned long)all.bad, (unsigned long)next_seq,
+           (unsigned long)total, ok ? "OK" : "FAILED");
+    fflush(stdout);
+    exit(ok ? 0 : 1);
+}
@@ -0,0 +1,108 @@
+//
+// Created by deity on 17.10.2026.
+//
+#include "sd_card_logic.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_heap_caps.h"
+
+#define BENCH_FILE      SD_CARD_MOUNT_POINT "/BENCH.BIN"
+#define BENCH_CHUNK     4096
+#define BENCH_OPS       64              // 256 КБ на проход
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void fill_stat(sd_bench_stat_t *st, uint32_t *lat, int64_t total_us)
+{
+    qsort(lat, BENCH_OPS, sizeof(lat[0]), cmp_u32);
+    st->kbps = total_us > 0 ? (uint32_t)((uint64_t)BENCH_OPS * BENCH_CHUNK * 1000000 / 1024 / total_us) : 0;
+    st->p50_us = lat[BENCH_OPS * 50 / 100];
+    st->p90_us = lat[BENCH_OPS * 90 / 100];
+    st->p99_us = lat[BENCH_OPS * 99 / 100];
+    st->max_us = lat[BENCH_OPS - 1];
+}
+
+// Один проход: write - запись или чтение, random - случайные смещения.
+// fsync в конце записи входит в общее время, иначе замер врёт.
+static esp_err_t run_pass(FILE *f, uint8_t *buf, bool write, bool random, sd_bench_stat_t *st)
+{
+    uint32_t lat[BENCH_OPS];
+    int64_t start = esp_timer_get_time();
+
+    for (int i = 0; i < BENCH_OPS; i++) {
+        long chunk = random ? (long)(esp_random() % BENCH_OPS) : i;
+        int64_t t0 = esp_timer_get_time();
+
+        if (fseek(f, chunk * BENCH_CHUNK, SEEK_SET) != 0) return ESP_FAIL;
+        size_t n = write ? fwrite(buf, 1, BENCH_CHUNK, f) : fread(buf, 1, BENCH_CHUNK, f);
+        if (n != BENCH_CHUNK) return ESP_FAIL;
+
+        lat[i] = (uint32_t)(esp_timer_get_time() - t0);
+    }
+    if (write && fsync(fileno(f)) != 0) return ESP_FAIL;
+
+    fill_stat(st, lat, esp_timer_get_time() - start);
+    return ESP_OK;
+}
+
+static void log_stat(const char *TAG, const char *name, const sd_bench_stat_t *st)
+{
+    ESP_LOGI(TAG, "%-10s %5lu KB/s  p50 %6lu us  p90 %6lu us  p99 %6lu us  max %6lu us", name,
+             (unsigned long)st->kbps, (unsigned long)st->p50_us, (unsigned long)st->p90_us,
+             (unsigned long)st->p99_us, (unsigned long)st->max_us);
+}
+
+esp_err_t sd_card_benchmark(const char *TAG, sd_bench_result_t *res)
+{
+    sd_bench_result_t r = { .freq_khz = sd_card_freq_khz() };
+    esp_err_t ret = ESP_FAIL;
+
+    uint8_t *buf = heap_caps_malloc(BENCH_CHUNK, MALLOC_CAP_DMA);
+    if (!buf) return ESP_ERR_NO_MEM;
+    for (int i = 0; i < BENCH_CHUNK; i++) buf[i] = (uint8_t)(i * 7);
+
+    FILE *f = fopen(BENCH_FILE, "w+b");
+    if (!f) {
+        ESP_LOGE(TAG, "Не удалось создать %s", BENCH_FILE);
+        free(buf);
+        return ESP_FAIL;
+    }
+    setvbuf(f, NULL, _IONBF, 0);
+
+    // порядок важен: случайные проходы идут по уже записанному файлу
+    if (run_pass(f, buf, true, false, &r.seq_write) == ESP_OK
+        && run_pass(f, buf, false, false, &r.seq_read) == ESP_OK
+        && run_pass(f, buf, true, true, &r.rnd_write) == ESP_OK
+        && run_pass(f, buf, false, true, &r.rnd_read) == ESP_OK) {
+        ret = ESP_OK;
+    }
+
+    fclose(f);
+    unlink(BENCH_FILE);
+    free(buf);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Тест скорости SD прерван ошибкой ввода-вывода");
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Тест скорости SD, SPI %lu kHz, блок %d Б", (unsigned long)r.freq_khz, BENCH_CHUNK);
+    log_stat(TAG, "seq write", &r.seq_write);
+    log_stat(TAG, "seq read", &r.seq_read);
+    log_stat(TAG, "rnd write", &r.rnd_write);
+    log_stat(TAG, "rnd read", &r.rnd_read);
+
+    if (res) *res = r;
+    return ESP_OK;
+}
@@ -0,0 +1,41 @@
+//
+// Created by deity on 17.10.2026.
+//
+// Сборка под linux: вместо SD карты - каталог SD_CARD_MOUNT_POINT.
+// Лог, сегменты, приём файлов и бенчмарк работают с ним через тот же
+// stdio/POSIX, что и с FAT на устройстве.
+//
+#include "sd_card_logic.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "esp_log.h"
+
+static bool sd_card_mounted = false;
+
+esp_err_t init_card(const char *TAG)
+{
+    if (mkdir(SD_CARD_MOUNT_POINT, 0775) != 0 && errno != EEXIST) {
+        ESP_LOGE(TAG, "Не удалось создать %s: %s", SD_CARD_MOUNT_POINT, strerror(errno));
+        return ESP_FAIL;
+    }
+    sd_card_mounted = true;
+    ESP_LOGI(TAG, "✓ Каталог %s вместо SD карты", SD_CARD_MOUNT_POINT);
+    return ESP_OK;
+}
+
+esp_err_t cleanup_sd_card(const char *TAG)
+{
+    if (sd_card_mounted) {
+        sd_card_mounted = false;
+        ESP_LOGI(TAG, "✓ SD карта размонтирована");
+    }
+    return ESP_OK;
+}
+
+uint32_t sd_card_freq_khz(void)
+{
+    return 0;
+}
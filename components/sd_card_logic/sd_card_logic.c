@@ -2,25 +2,182 @@
 // Created by deity on 10.07.2025.
 //
 #include "sd_card_logic.h"
+#include "sd_writer.h"
+
+#include <string.h>
 
 #include "esp_log.h"
 #include "esp_vfs_fat.h"
+#include "esp_heap_caps.h"
+#include "nvs.h"
+#include "sdmmc_cmd.h"
 #include "sd_protocol_defs.h"
 #include "driver/sdspi_host.h"
 #include "driver/spi_common.h"
 
 
-#define MOUNT_POINT "/sdcard"
-
 static bool sd_card_mounted = false;
 static sdmmc_card_t *card = NULL;
 
+// Подбор частоты SPI: стартуем с заведомо рабочей, поднимаем по шагам,
+// пока чтение совпадает с эталоном и нет ошибок CRC. Итог храним в NVS.
+//
+// Монтируем с настоящим потолком хоста: тогда sdmmc_card_init() сам
+// переключает карту в High Speed (CMD6), если она умеет, и card->max_freq_khz
+// честно говорит 20 или 40 МГц. Частоту на время монтирования держит
+// обёртка set_card_clk - не выше clk_limit_khz.
+#define FREQ_BASE_KHZ   7500
+#define FREQ_HOST_MAX_KHZ   SDMMC_FREQ_HIGHSPEED
+#define FREQ_NVS_NS     "sd_card"
+#define FREQ_NVS_KEY    "freq_khz"
+#define PROBE_SECTORS   8               // 4 КБ на точку проверки
+#define PROBE_POINTS    2               // начало и середина карты
+#define PROBE_ROUNDS    4
+
+// делители 80 МГц APB
+static const uint32_t freq_steps_khz[] = { 10000, 13333, 16000, 20000, 26667, 40000 };
+
+static uint32_t freq_khz = FREQ_BASE_KHZ;
+static uint32_t clk_limit_khz = FREQ_BASE_KHZ;
+
 // Пины для подключения SD карты
 #define PIN_MISO    GPIO_NUM_19
 #define PIN_MOSI    GPIO_NUM_23
 #define PIN_CLK     GPIO_NUM_18
 #define PIN_CS      GPIO_NUM_5
 
+static uint32_t freq_load(void)
+{
+    nvs_handle_t nvs;
+    uint32_t khz = 0;
+    if (nvs_open(FREQ_NVS_NS, NVS_READONLY, &nvs) == ESP_OK) {
+        nvs_get_u32(nvs, FREQ_NVS_KEY, &khz);
+        nvs_close(nvs);
+    }
+    return khz;
+}
+
+static void freq_save(uint32_t khz)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(FREQ_NVS_NS, NVS_READWRITE, &nvs) != ESP_OK) return;
+    if (khz) {
+        nvs_set_u32(nvs, FREQ_NVS_KEY, khz);
+    } else {
+        nvs_erase_key(nvs, FREQ_NVS_KEY);
+    }
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+// host.set_card_clk: драйвер ставит min(карта, хост), мы - не выше лимита
+static esp_err_t set_card_clk_limited(int slot, uint32_t khz)
+{
+    return sdspi_host_set_card_clk(slot, khz < clk_limit_khz ? khz : clk_limit_khz);
+}
+
+// Потолок для подбора: что разрешает карта после монтирования
+static uint32_t clock_ceiling(void)
+{
+    uint32_t khz = FREQ_HOST_MAX_KHZ;
+    if (card->max_freq_khz && card->max_freq_khz < khz) khz = card->max_freq_khz;
+    return khz;
+}
+
+static esp_err_t set_clock(uint32_t khz)
+{
+    clk_limit_khz = khz;
+    esp_err_t ret = set_card_clk_limited(card->host.slot, khz);
+    if (ret != ESP_OK) return ret;
+
+    int real_khz;
+    if (sdspi_host_get_real_freq(card->host.slot, &real_khz) == ESP_OK) {
+        card->real_freq_khz = real_khz;
+    }
+    freq_khz = khz;
+    return ESP_OK;
+}
+
+static uint32_t probe_sector(int point)
+{
+    return point * (card->csd.capacity / PROBE_POINTS);
+}
+
+static esp_err_t read_probe(uint8_t *buf)
+{
+    for (int i = 0; i < PROBE_POINTS; i++) {
+        esp_err_t ret = sdmmc_read_sectors(card, buf + i * PROBE_SECTORS * 512, probe_sector(i), PROBE_SECTORS);
+        if (ret != ESP_OK) return ret;
+    }
+    return ESP_OK;
+}
+
+// Только чтение: на непроверенной частоте на карту ничего не пишем
+static bool probe_clock(const char *TAG, uint32_t khz, const uint8_t *ref, uint8_t *buf)
+{
+    if (set_clock(khz) != ESP_OK) return false;
+
+    for (int round = 0; round < PROBE_ROUNDS; round++) {
+        esp_err_t ret = read_probe(buf);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "%lu kHz: ошибка чтения %s", (unsigned long)khz, esp_err_to_name(ret));
+            return false;
+        }
+        if (memcmp(ref, buf, PROBE_POINTS * PROBE_SECTORS * 512) != 0) {
+            ESP_LOGW(TAG, "%lu kHz: данные не совпали с эталоном", (unsigned long)khz);
+            return false;
+        }
+    }
+    return sdmmc_get_status(card) == ESP_OK;
+}
+
+static void negotiate_clock(const char *TAG)
+{
+    size_t size = PROBE_POINTS * PROBE_SECTORS * 512;
+    uint8_t *ref = heap_caps_malloc(size, MALLOC_CAP_DMA);
+    uint8_t *buf = heap_caps_malloc(size, MALLOC_CAP_DMA);
+    if (!ref || !buf || read_probe(ref) != ESP_OK) {
+        ESP_LOGW(TAG, "Подбор частоты пропущен, остаёмся на %d kHz", FREQ_BASE_KHZ);
+        goto done;
+    }
+
+    // шаги выше 20 МГц - только если карта перешла в High Speed
+    uint32_t ceiling = clock_ceiling();
+    ESP_LOGI(TAG, "Потолок частоты %lu kHz%s", (unsigned long)ceiling,
+             ceiling > SDMMC_FREQ_DEFAULT ? " (High Speed)" : "");
+
+    // сохранённая частота уже проверялась - сначала пробуем её,
+    // если её разрешает эта карта (карту могли заменить)
+    uint32_t saved = freq_load();
+    if (saved && saved <= ceiling && probe_clock(TAG, saved, ref, buf)) {
+        ESP_LOGI(TAG, "Частота из NVS: %lu kHz", (unsigned long)saved);
+        goto done;
+    }
+
+    uint32_t best = FREQ_BASE_KHZ;
+    for (size_t i = 0; i < sizeof(freq_steps_khz) / sizeof(freq_steps_khz[0]); i++) {
+        uint32_t khz = freq_steps_khz[i];
+        if (khz <= best) continue;
+        if (khz > ceiling) break;
+        if (!probe_clock(TAG, khz, ref, buf)) break;
+        best = khz;
+    }
+
+    // откат на последнюю частоту без ошибок
+    set_clock(best);
+    freq_save(best);
+    ESP_LOGI(TAG, "Выбрана частота %lu kHz", (unsigned long)best);
+
+done:
+    free(ref);
+    free(buf);
+}
+
+uint32_t sd_card_freq_khz(void)
+{
+    return freq_khz;
+}
+
 esp_err_t init_card(const char *TAG) {
     spi_bus_config_t bus_cfg = {
         .mosi_io_num     = PIN_MOSI,
@@ -28,7 +185,7 @@ esp_err_t init_card(const char *TAG) {
         .sclk_io_num     = PIN_CLK,
         .quadwp_io_num   = -1,            // не используется
         .quadhd_io_num   = -1,            // не используется
-        .max_transfer_sz = 4000,          // достаточно 4 КБ
+        .max_transfer_sz = SD_WRITER_BLOCK_SIZE, // блок писателя целиком
     };
     ESP_ERROR_CHECK(spi_bus_initialize(SPI2_HOST, &bus_cfg, SPI_DMA_CH_AUTO));
 
@@ -47,10 +204,13 @@ esp_err_t init_card(const char *TAG) {
     };
     // Конфигурация хоста
     sdmmc_host_t host = SDSPI_HOST_DEFAULT();
-    host.max_freq_khz = 7500;  // Начинаем с 20MHz
+    host.max_freq_khz = FREQ_HOST_MAX_KHZ;      // чтобы драйвер включил High Speed
+    host.set_card_clk = set_card_clk_limited;   // а частота пока FREQ_BASE_KHZ
+    clk_limit_khz = FREQ_BASE_KHZ;
+    freq_khz = FREQ_BASE_KHZ;
 
     ESP_LOGI(TAG, "Монтирование SD карты...");
-    esp_err_t ret = esp_vfs_fat_sdspi_mount(MOUNT_POINT, &host, &slot_config, &mount_cfg, &card);
+    esp_err_t ret = esp_vfs_fat_sdspi_mount(SD_CARD_MOUNT_POINT, &host, &slot_config, &mount_cfg, &card);
 
     if (ret != ESP_OK) {
         if (ret == ESP_FAIL) {
@@ -65,6 +225,8 @@ esp_err_t init_card(const char *TAG) {
 
     sd_card_mounted = true;
 
+    negotiate_clock(TAG);
+
     // Информация о карте
     ESP_LOGI(TAG, "✓ SD карта успешно смонтирована");
     ESP_LOGI(TAG, "Название: %s", card->cid.name);
@@ -79,7 +241,7 @@ esp_err_t cleanup_sd_card(const char *TAG)
 {
     if (sd_card_mounted) {
         ESP_LOGI(TAG, "Размонтирование SD карты...");
-        esp_vfs_fat_sdcard_unmount(MOUNT_POINT, card);
+        esp_vfs_fat_sdcard_unmount(SD_CARD_MOUNT_POINT, card);
         sd_card_mounted = false;
         ESP_LOGI(TAG, "✓ SD карта размонтирована");
     }
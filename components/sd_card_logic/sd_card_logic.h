@@ -5,9 +5,47 @@
 
 #ifndef SD_CARD_LOGIC_H
 #define SD_CARD_LOGIC_H
+#include <stdint.h>
+#include "sdkconfig.h"
 #include "esp_err.h"
 
+#if CONFIG_IDF_TARGET_LINUX
+// сборка под linux: карта - каталог в рабочем каталоге процесса
+#define SD_CARD_MOUNT_POINT "sdcard"
+#else
+#define SD_CARD_MOUNT_POINT "/sdcard"
+#endif
+
+typedef struct {
+    uint32_t kbps;              // пропускная способность, КБ/с
+    uint32_t p50_us;            // задержка одной операции 4 КБ
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} sd_bench_stat_t;
+
+typedef struct {
+    uint32_t        freq_khz;
+    sd_bench_stat_t seq_write;
+    sd_bench_stat_t seq_read;
+    sd_bench_stat_t rnd_write;
+    sd_bench_stat_t rnd_read;
+} sd_bench_result_t;
+
 esp_err_t init_card(const char *TAG);
 esp_err_t cleanup_sd_card(const char *TAG);
 
+/**
+ * @brief SPI clock chosen by init_card (persisted in NVS)
+ */
+uint32_t sd_card_freq_khz(void);
+
+/**
+ * @brief Sequential/random 4 KB read/write benchmark on a scratch file
+ * @param TAG       log tag, results are logged
+ * @param[out] res  results, may be NULL
+ * @return ESP_OK on success
+ */
+esp_err_t sd_card_benchmark(const char *TAG, sd_bench_result_t *res);
+
 #endif //SD_CARD_LOGIC_H
@@ -0,0 +1,221 @@
+//
+// Created by deity on 17.10.2026.
+//
+#include "sd_log.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "sd_log";
+
+esp_err_t sd_log_open(sd_log_t *log, const char *path, const sd_log_config_t *cfg)
+{
+    if (!log || !path) return ESP_ERR_INVALID_ARG;
+
+    memset(log, 0, sizeof(*log));
+    if (cfg) {
+        log->cfg = *cfg;
+    } else {
+        sd_log_config_t def = SD_LOG_CONFIG_DEFAULT();
+        log->cfg = def;
+    }
+    if (log->cfg.flush_threshold == 0 || log->cfg.flush_threshold > log->cfg.buf_size) {
+        log->cfg.flush_threshold = log->cfg.buf_size;
+    }
+
+    if (log->cfg.buf_size) {
+        log->buf = malloc(log->cfg.buf_size);
+        if (!log->buf) return ESP_ERR_NO_MEM;
+    }
+
+    log->f = fopen(path, "ab");
+    if (!log->f) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        free(log->buf);
+        log->buf = NULL;
+        return ESP_FAIL;
+    }
+    // буферизуем сами, stdio-буфер только удвоит копирование
+    setvbuf(log->f, NULL, _IONBF, 0);
+
+    // размер узнаём один раз, дальше считаем в памяти
+    struct stat st;
+    if (fstat(fileno(log->f), &st) == 0) {
+        log->size = st.st_size;
+    } else if (fseek(log->f, 0, SEEK_END) == 0) {
+        log->size = ftell(log->f);
+    }
+    if (log->size < 0) log->size = 0;
+
+    log->last_flush_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "Opened %s, size %ld", path, log->size);
+    return ESP_OK;
+}
+
+static esp_err_t sd_log_write_buf(sd_log_t *log)
+{
+    if (log->buf_len == 0) return ESP_OK;
+
+    size_t written = fwrite(log->buf, 1, log->buf_len, log->f);
+    log->stats.flushes++;
+    log->stats.bytes += written;
+    if (written != log->buf_len) {
+        ESP_LOGE(TAG, "Short write: %u of %u", (unsigned)written, (unsigned)log->buf_len);
+        // недописанный хвост оставляем в буфере для следующей попытки
+        memmove(log->buf, log->buf + written, log->buf_len - written);
+        log->buf_len -= written;
+        return ESP_FAIL;
+    }
+    log->buf_len = 0;
+    return ESP_OK;
+}
+
+esp_err_t sd_log_flush(sd_log_t *log, bool sync)
+{
+    if (!log || !log->f) return ESP_ERR_INVALID_STATE;
+
+    esp_err_t ret = sd_log_write_buf(log);
+    log->last_flush_us = esp_timer_get_time();
+    if (ret != ESP_OK) return ret;
+
+    if (sync) {
+        if (fsync(fileno(log->f)) != 0) {
+            ESP_LOGE(TAG, "fsync failed");
+            return ESP_FAIL;
+        }
+        log->stats.syncs++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t sd_log_write(sd_log_t *log, const void *data, size_t len)
+{
+    if (!log || !log->f || (!data && len)) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t ret = sd_log_write_buf(log);
+    if (ret != ESP_OK) return ret;
+    if (len == 0) return ESP_OK;
+
+    size_t written = fwrite(data, 1, len, log->f);
+    log->stats.flushes++;
+    log->stats.bytes += written;
+    log->size += (long)written;
+    log->last_flush_us = esp_timer_get_time();
+    if (written != len) {
+        ESP_LOGE(TAG, "Short write: %u of %u", (unsigned)written, (unsigned)len);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t sd_log_append(sd_log_t *log, const void *data, size_t len)
+{
+    if (!log || !log->f || (!data && len)) return ESP_ERR_INVALID_ARG;
+    if (!log->buf) {
+        log->stats.appends++;
+        return sd_log_write(log, data, len);
+    }
+
+    const uint8_t *p = data;
+    log->stats.appends++;
+    log->size += (long)len;
+
+    while (len) {
+        size_t n = log->cfg.buf_size - log->buf_len;
+        if (n > len) n = len;
+        memcpy(log->buf + log->buf_len, p, n);
+        log->buf_len += n;
+        p += n;
+        len -= n;
+
+        if (log->buf_len >= log->cfg.flush_threshold) {
+            esp_err_t ret = sd_log_flush(log, len == 0 && log->cfg.sync_on_flush);
+            if (ret != ESP_OK) {
+                log->size -= (long)len;
+                return ret;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t sd_log_append_line(sd_log_t *log, const char *line)
+{
+    if (!line) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t ret = sd_log_append(log, line, strlen(line));
+    if (ret != ESP_OK) return ret;
+    return sd_log_append(log, "\n", 1);
+}
+
+esp_err_t sd_log_poll(sd_log_t *log)
+{
+    if (!log || !log->f) return ESP_ERR_INVALID_STATE;
+    if (log->buf_len == 0) return ESP_OK;
+
+    int64_t age_us = esp_timer_get_time() - log->last_flush_us;
+    if (age_us < (int64_t)log->cfg.flush_ms * 1000) return ESP_OK;
+
+    return sd_log_flush(log, log->cfg.sync_on_flush);
+}
+
+esp_err_t sd_log_resize(sd_log_t *log, long size)
+{
+    if (!log || !log->f || size < 0) return ESP_ERR_INVALID_ARG;
+
+    // после короткой записи счётчику верить нельзя, размер берём у файла
+    log->buf_len = 0;
+    struct stat st;
+    if (fstat(fileno(log->f), &st) != 0) return ESP_FAIL;
+    log->size = st.st_size;
+
+    if (log->size > size) {
+        if (ftruncate(fileno(log->f), size) != 0) {
+            ESP_LOGE(TAG, "Truncate to %ld failed", size);
+            return ESP_FAIL;
+        }
+        log->size = size;
+    }
+    // позицию ставим явно: после ftruncate или сбоя она могла остаться не в конце
+    if (fseek(log->f, log->size, SEEK_SET) != 0) return ESP_FAIL;
+
+    static const uint8_t zeros[64];
+    while (log->size < size) {
+        size_t n = size - log->size < (long)sizeof(zeros) ? (size_t)(size - log->size) : sizeof(zeros);
+        size_t written = fwrite(zeros, 1, n, log->f);
+        log->stats.bytes += written;
+        log->size += (long)written;
+        if (written != n) {
+            ESP_LOGE(TAG, "Padding to %ld failed at %ld", size, log->size);
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+long sd_log_size(const sd_log_t *log)
+{
+    return log ? log->size : -1;
+}
+
+esp_err_t sd_log_close(sd_log_t *log)
+{
+    if (!log || !log->f) return ESP_ERR_INVALID_STATE;
+
+    esp_err_t ret = sd_log_flush(log, true);
+    fclose(log->f);
+    log->f = NULL;
+    free(log->buf);
+    log->buf = NULL;
+
+    ESP_LOGI(TAG, "Closed: %lu appends, %lu flushes, %lu syncs",
+             (unsigned long)log->stats.appends,
+             (unsigned long)log->stats.flushes,
+             (unsigned long)log->stats.syncs);
+    return ret;
+}
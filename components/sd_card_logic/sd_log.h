@@ -0,0 +1,117 @@
+//
+// Created by deity on 17.10.2026.
+//
+#pragma once
+
+#ifndef SD_LOG_H
+#define SD_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// Пороги по умолчанию: 4 КБ буфера (размер сектора FAT) и сброс раз в 2 секунды
+#define SD_LOG_BUF_SIZE_DEFAULT     4096
+#define SD_LOG_FLUSH_MS_DEFAULT     2000
+
+#define SD_LOG_CONFIG_DEFAULT() { \
+    .buf_size        = SD_LOG_BUF_SIZE_DEFAULT, \
+    .flush_threshold = SD_LOG_BUF_SIZE_DEFAULT, \
+    .flush_ms        = SD_LOG_FLUSH_MS_DEFAULT, \
+    .sync_on_flush   = true, \
+}
+
+typedef struct {
+    size_t   buf_size;          // размер RAM-буфера, 0 - писать сразу в файл
+    size_t   flush_threshold;   // сколько байт накопить до записи на карту
+    uint32_t flush_ms;          // максимальное время жизни данных в буфере
+    bool     sync_on_flush;     // fsync после каждого сброса по порогу/таймеру
+} sd_log_config_t;
+
+typedef struct {
+    uint32_t appends;           // вызовов sd_log_append
+    uint32_t flushes;           // сколько раз буфер уходил в fwrite
+    uint32_t syncs;             // сколько раз делали fsync
+    uint64_t bytes;             // всего байт записано на карту
+} sd_log_stats_t;
+
+typedef struct {
+    FILE           *f;
+    long            size;       // размер файла вместе с буфером, без stat/ftell
+    uint8_t        *buf;
+    size_t          buf_len;
+    int64_t         last_flush_us;
+    sd_log_config_t cfg;
+    sd_log_stats_t  stats;
+} sd_log_t;
+
+/**
+ * @brief Open (or create) a log file for appending and keep it open
+ * @param log   log descriptor
+ * @param path  file path on the mounted card
+ * @param cfg   buffer/flush settings, NULL for SD_LOG_CONFIG_DEFAULT()
+ * @return ESP_OK on success
+ */
+esp_err_t sd_log_open(sd_log_t *log, const char *path, const sd_log_config_t *cfg);
+
+/**
+ * @brief Append bytes to the RAM buffer, writing to the card when the threshold is hit
+ * @return ESP_OK on success
+ */
+esp_err_t sd_log_append(sd_log_t *log, const void *data, size_t len);
+
+/**
+ * @brief Write bytes straight to the file, bypassing the RAM buffer
+ *
+ * Pending buffered bytes are written first so the order is preserved.
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sd_log_write(sd_log_t *log, const void *data, size_t len);
+
+/**
+ * @brief Append a string followed by '\n'
+ * @return ESP_OK on success
+ */
+esp_err_t sd_log_append_line(sd_log_t *log, const char *line);
+
+/**
+ * @brief Flush the buffer if it has been held longer than flush_ms
+ *
+ * Call it periodically from the owning task (e.g. on queue receive timeout).
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sd_log_poll(sd_log_t *log);
+
+/**
+ * @brief Write buffered data to the file
+ * @param log   log descriptor
+ * @param sync  also fsync() so the data survives power loss
+ * @return ESP_OK on success
+ */
+esp_err_t sd_log_flush(sd_log_t *log, bool sync);
+
+/**
+ * @brief Truncate or zero-pad the file to exactly \p size bytes
+ *
+ * Drops not yet flushed bytes. Used to get back to a known offset after a
+ * failed or short write.
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sd_log_resize(sd_log_t *log, long size);
+
+/**
+ * @brief Current file size including not yet flushed bytes
+ */
+long sd_log_size(const sd_log_t *log);
+
+/**
+ * @brief Flush, sync and close the file
+ * @return ESP_OK on success
+ */
+esp_err_t sd_log_close(sd_log_t *log);
+
+#endif //SD_LOG_H
@@ -0,0 +1,228 @@
+//
+// Created by deity on 17.10.2026.
+//
+#include "sd_record.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+static const char *TAG = "sd_record";
+
+static uint32_t record_crc(const sd_record_hdr_t *hdr, const void *data)
+{
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)hdr, offsetof(sd_record_hdr_t, crc));
+    if (hdr->len) {
+        crc = esp_rom_crc32_le(crc, data, hdr->len);
+    }
+    return crc;
+}
+
+void sd_record_encode(sd_record_hdr_t *hdr, sd_record_type_t type, uint32_t seq,
+                      uint64_t ts_ms, const void *data, uint16_t len)
+{
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = SD_RECORD_MAGIC;
+    hdr->type = type;
+    hdr->len = len;
+    hdr->seq = seq;
+    hdr->ts_ms = ts_ms;
+    hdr->crc = record_crc(hdr, data);
+}
+
+// Разбор одной записи в буфере блока. Возвращает размер записи или 0, если
+// дальше в блоке ничего полезного нет (нули, обрыв, битая crc).
+static size_t parse_record(const uint8_t *buf, size_t avail, sd_record_t *rec)
+{
+    sd_record_hdr_t hdr;
+    if (avail < SD_RECORD_HDR_SIZE) return 0;
+
+    memcpy(&hdr, buf, sizeof(hdr));
+    if (hdr.magic != SD_RECORD_MAGIC) return 0;
+    if (SD_RECORD_HDR_SIZE + hdr.len > avail) return 0;
+
+    const uint8_t *data = buf + SD_RECORD_HDR_SIZE;
+    if (record_crc(&hdr, data) != hdr.crc) {
+        ESP_LOGW(TAG, "CRC mismatch, seq %lu", (unsigned long)hdr.seq);
+        return 0;
+    }
+
+    rec->type = hdr.type;
+    rec->seq = hdr.seq;
+    rec->ts_ms = hdr.ts_ms;
+    rec->len = hdr.len;
+    rec->data = data;
+    return SD_RECORD_HDR_SIZE + hdr.len;
+}
+
+static size_t read_block(FILE *f, long block, uint8_t *buf)
+{
+    if (fseek(f, block * SD_RECORD_BLOCK_SIZE, SEEK_SET) != 0) return 0;
+    return fread(buf, 1, SD_RECORD_BLOCK_SIZE, f);
+}
+
+// Номер первой записи блока из его индексной записи
+static bool block_first_seq(FILE *f, long block, uint32_t *seq)
+{
+    uint8_t buf[SD_RECORD_HDR_SIZE];
+    sd_record_t rec;
+
+    if (fseek(f, block * SD_RECORD_BLOCK_SIZE, SEEK_SET) != 0) return false;
+    if (fread(buf, 1, sizeof(buf), f) != sizeof(buf)) return false;
+    if (parse_record(buf, sizeof(buf), &rec) == 0 || rec.type != SD_REC_INDEX) return false;
+
+    *seq = rec.seq;
+    return true;
+}
+
+static FILE *open_log(const char *path, long *blocks)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) return NULL;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return NULL;
+    }
+    // читаем целыми блоками, свой буфер stdio не нужен
+    setvbuf(f, NULL, _IONBF, 0);
+    *blocks = (st.st_size + SD_RECORD_BLOCK_SIZE - 1) / SD_RECORD_BLOCK_SIZE;
+    return f;
+}
+
+// Последняя валидная запись: идём от последнего блока назад до первого непустого
+static bool find_last(FILE *f, long blocks, uint8_t *buf, uint32_t *next_seq, uint64_t *last_ts)
+{
+    for (long b = blocks - 1; b >= 0; b--) {
+        size_t n = read_block(f, b, buf);
+        size_t pos = 0, len;
+        sd_record_t rec;
+        bool found = false;
+
+        while ((len = parse_record(buf + pos, n - pos, &rec)) != 0) {
+            *next_seq = rec.type == SD_REC_INDEX ? rec.seq : rec.seq + 1;
+            *last_ts = rec.ts_ms;
+            found = true;
+            pos += len;
+        }
+        if (found) return true;
+    }
+    return false;
+}
+
+esp_err_t sd_record_tail(const char *path, uint32_t *next_seq, uint64_t *last_ts)
+{
+    if (!path || !next_seq || !last_ts) return ESP_ERR_INVALID_ARG;
+
+    *next_seq = 0;
+    *last_ts = 0;
+
+    long blocks;
+    FILE *f = open_log(path, &blocks);
+    if (!f) return ESP_ERR_NOT_FOUND;
+
+    uint8_t *buf = malloc(SD_RECORD_BLOCK_SIZE);
+    if (!buf) {
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+
+    find_last(f, blocks, buf, next_seq, last_ts);
+
+    free(buf);
+    fclose(f);
+    return ESP_OK;
+}
+
+esp_err_t sd_record_head(const char *path, uint32_t *first_seq)
+{
+    if (!path || !first_seq) return ESP_ERR_INVALID_ARG;
+
+    long blocks;
+    FILE *f = open_log(path, &blocks);
+    if (!f) return ESP_ERR_NOT_FOUND;
+
+    bool ok = blocks > 0 && block_first_seq(f, 0, first_seq);
+    fclose(f);
+    return ok ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+// Чтение от записи first до конца файла, блок начала ищем бинпоиском по индексам
+static void read_from(FILE *f, long blocks, uint8_t *buf, uint32_t first, sd_record_cb_t cb, void *arg)
+{
+    // последний блок, у которого первая запись <= first. Блок без индекса
+    // (порча) считаем "слишком поздним" - лишь начнём чтение чуть раньше.
+    long lo = 0, hi = blocks - 1;
+    while (lo < hi) {
+        long mid = lo + (hi - lo + 1) / 2;
+        uint32_t seq;
+        if (block_first_seq(f, mid, &seq) && seq <= first) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    bool go = true;
+    for (long b = lo; b < blocks && go; b++) {
+        size_t n = read_block(f, b, buf);
+        size_t pos = 0, len;
+        sd_record_t rec;
+
+        while (go && (len = parse_record(buf + pos, n - pos, &rec)) != 0) {
+            pos += len;
+            if (rec.type == SD_REC_INDEX || rec.seq < first) continue;
+            go = cb(&rec, arg);
+        }
+    }
+}
+
+esp_err_t sd_record_read_from(const char *path, uint32_t first_seq, sd_record_cb_t cb, void *arg)
+{
+    if (!path || !cb) return ESP_ERR_INVALID_ARG;
+
+    long blocks;
+    FILE *f = open_log(path, &blocks);
+    if (!f) return ESP_ERR_NOT_FOUND;
+
+    uint8_t *buf = malloc(SD_RECORD_BLOCK_SIZE);
+    if (!buf) {
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+
+    read_from(f, blocks, buf, first_seq, cb, arg);
+
+    free(buf);
+    fclose(f);
+    return ESP_OK;
+}
+
+esp_err_t sd_record_read_last(const char *path, uint32_t count, sd_record_cb_t cb, void *arg)
+{
+    if (!path || !cb) return ESP_ERR_INVALID_ARG;
+
+    long blocks;
+    FILE *f = open_log(path, &blocks);
+    if (!f) return ESP_ERR_NOT_FOUND;
+
+    uint8_t *buf = malloc(SD_RECORD_BLOCK_SIZE);
+    if (!buf) {
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t total = 0;
+    uint64_t last_ts = 0;
+    find_last(f, blocks, buf, &total, &last_ts);
+    read_from(f, blocks, buf, total > count ? total - count : 0, cb, arg);
+
+    free(buf);
+    fclose(f);
+    return ESP_OK;
+}
@@ -0,0 +1,96 @@
+//
+// Created by deity on 17.10.2026.
+//
+#pragma once
+
+#ifndef SD_RECORD_H
+#define SD_RECORD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// Лог режется на блоки по SD_RECORD_BLOCK_SIZE. Каждый блок начинается с
+// индексной записи (номер первой записи блока), записи границу блока не
+// пересекают, хвост блока добивается нулями. Поэтому найти запись N или хвост
+// лога можно чтением заголовков блоков, не читая файл целиком.
+#define SD_RECORD_BLOCK_SIZE    4096
+#define SD_RECORD_MAGIC         0x5A46      // "FZ"
+
+typedef enum {
+    SD_REC_INDEX = 0,       // начало блока, seq = номер следующей записи
+    SD_REC_TEXT,            // текстовое сообщение без '\0'
+    SD_REC_RAW,
+} sd_record_type_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t  type;
+    uint8_t  flags;
+    uint16_t len;           // длина данных после заголовка
+    uint16_t reserved;
+    uint32_t seq;           // монотонный номер записи, сквозной между загрузками
+    uint64_t ts_ms;         // монотонное время, мс
+    uint32_t crc;           // crc32 заголовка (без этого поля) и данных
+} sd_record_hdr_t;
+
+#define SD_RECORD_HDR_SIZE      sizeof(sd_record_hdr_t)
+#define SD_RECORD_MAX_PAYLOAD   (SD_RECORD_BLOCK_SIZE - 2 * SD_RECORD_HDR_SIZE)
+
+typedef struct {
+    sd_record_type_t type;
+    uint32_t         seq;
+    uint64_t         ts_ms;
+    uint16_t         len;
+    const uint8_t   *data;  // действительно только внутри колбэка
+} sd_record_t;
+
+/**
+ * @brief Replay callback
+ * @return false to stop the replay
+ */
+typedef bool (*sd_record_cb_t)(const sd_record_t *rec, void *arg);
+
+/**
+ * @brief Fill in a record header, including the CRC
+ */
+void sd_record_encode(sd_record_hdr_t *hdr, sd_record_type_t type, uint32_t seq,
+                      uint64_t ts_ms, const void *data, uint16_t len);
+
+/**
+ * @brief Find where the log ends
+ * @param path          log file path
+ * @param[out] next_seq sequence number for the next record
+ * @param[out] last_ts  timestamp of the last valid record, 0 if none
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there is no file
+ */
+esp_err_t sd_record_tail(const char *path, uint32_t *next_seq, uint64_t *last_ts);
+
+/**
+ * @brief Sequence number of the first record, from the index of block 0
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there is no file or no index
+ */
+esp_err_t sd_record_head(const char *path, uint32_t *first_seq);
+
+/**
+ * @brief Replay the last \p count data records, oldest first
+ *
+ * Seeks to the right block by binary search over block indexes, so the
+ * cost does not depend on the log length. Index records are not reported.
+ *
+ * @param path  log file path
+ * @param count how many records to replay, UINT32_MAX for the whole log
+ * @param cb    callback for every record
+ * @param arg   callback argument
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there is no file
+ */
+esp_err_t sd_record_read_last(const char *path, uint32_t count, sd_record_cb_t cb, void *arg);
+
+/**
+ * @brief Replay data records starting at sequence number \p first_seq
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there is no file
+ */
+esp_err_t sd_record_read_from(const char *path, uint32_t first_seq, sd_record_cb_t cb, void *arg);
+
+#endif //SD_RECORD_H
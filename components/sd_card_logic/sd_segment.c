@@ -0,0 +1,547 @@
+//
+// Created by deity on 17.10.2026.
+//
+#include "sd_segment.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "sd_segment";
+
+#define MANIFEST_MAGIC  0x324D5A46      // "FZM2"
+#define MANIFEST_V1     0x464D5A46      // "FZMF", без packed[]
+#define MANIFEST_NAME   "MANIFEST.BIN"
+#define MANIFEST_TMP    "MANIFEST.TMP"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t gen;                       // растёт с каждым коммитом
+    uint32_t next_id;
+    uint32_t count;
+    uint32_t ids[SD_SEGMENT_MAX];       // от старого к новому, последний - активный
+    uint16_t packed[SD_SEGMENT_MAX];    // блоков после перепаковки, PACKED_UNKNOWN - не считали
+    uint32_t crc;
+} manifest_t;
+
+// Закрытый сегмент больше не меняется, поэтому его размер после перепаковки
+// считается один раз и дальше живёт в манифесте
+#define PACKED_UNKNOWN  UINT16_MAX
+
+static struct {
+    char              dir[SD_SEGMENT_PATH_LEN - 13];
+    manifest_t        m;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t done;
+    TaskHandle_t      compactor;
+    volatile bool     stop;
+} seg;
+
+static void seg_path(uint32_t id, char *path, size_t size)
+{
+    snprintf(path, size, "%s/SEG%05lu.BIN", seg.dir, (unsigned long)id);
+}
+
+static uint32_t manifest_crc(const manifest_t *m, size_t len)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)m, len);
+}
+
+static void packed_unknown(manifest_t *m)
+{
+    for (size_t i = 0; i < SD_SEGMENT_MAX; i++) {
+        m->packed[i] = PACKED_UNKNOWN;
+    }
+}
+
+static bool manifest_read(const char *name, manifest_t *m)
+{
+    char path[SD_SEGMENT_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s", seg.dir, name);
+
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    size_t n = fread(m, 1, sizeof(*m), f);
+    fclose(f);
+
+    bool ok;
+    if (m->magic == MANIFEST_V1) {
+        // старый формат: crc сразу за ids, размеры сегментов посчитаем заново
+        const size_t len = offsetof(manifest_t, packed);
+        uint32_t crc;
+        memcpy(&crc, (const uint8_t *)m + len, sizeof(crc));
+        ok = n == len + sizeof(crc) && crc == manifest_crc(m, len);
+        m->magic = MANIFEST_MAGIC;
+        packed_unknown(m);
+    } else {
+        ok = n == sizeof(*m)
+            && m->magic == MANIFEST_MAGIC
+            && m->crc == manifest_crc(m, offsetof(manifest_t, crc));
+    }
+    return ok && m->count >= 1 && m->count <= SD_SEGMENT_MAX;
+}
+
+// Запись во временный файл, fsync, затем подмена. На FAT rename не умеет
+// перезаписывать, поэтому между unlink и rename живёт только TMP - при
+// загрузке он подхватывается, см. manifest_recover().
+static esp_err_t manifest_commit(manifest_t *m)
+{
+    char tmp[SD_SEGMENT_PATH_LEN], path[SD_SEGMENT_PATH_LEN];
+    snprintf(tmp, sizeof(tmp), "%s/%s", seg.dir, MANIFEST_TMP);
+    snprintf(path, sizeof(path), "%s/%s", seg.dir, MANIFEST_NAME);
+
+    m->gen++;
+    m->crc = manifest_crc(m, offsetof(manifest_t, crc));
+
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to create %s", tmp);
+        return ESP_FAIL;
+    }
+    size_t n = fwrite(m, 1, sizeof(*m), f);
+    bool ok = n == sizeof(*m) && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    fclose(f);
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to write manifest");
+        unlink(tmp);
+        return ESP_FAIL;
+    }
+
+    unlink(path);
+    if (rename(tmp, path) != 0) {
+        ESP_LOGE(TAG, "Failed to rename manifest");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t manifest_recover(void)
+{
+    char tmp[SD_SEGMENT_PATH_LEN], path[SD_SEGMENT_PATH_LEN];
+    snprintf(tmp, sizeof(tmp), "%s/%s", seg.dir, MANIFEST_TMP);
+    snprintf(path, sizeof(path), "%s/%s", seg.dir, MANIFEST_NAME);
+
+    manifest_t a, b;
+    bool a_ok = manifest_read(MANIFEST_NAME, &a);
+    bool b_ok = manifest_read(MANIFEST_TMP, &b);
+
+    if (b_ok && (!a_ok || b.gen > a.gen)) {
+        // питание пропало посреди коммита: TMP уже полный, доводим rename
+        ESP_LOGW(TAG, "Recovering manifest gen %lu from %s", (unsigned long)b.gen, MANIFEST_TMP);
+        seg.m = b;
+        unlink(path);
+        return rename(tmp, path) == 0 ? ESP_OK : ESP_FAIL;
+    }
+
+    unlink(tmp);
+    if (a_ok) {
+        seg.m = a;
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "No manifest, starting a new log");
+    memset(&seg.m, 0, sizeof(seg.m));
+    seg.m.magic = MANIFEST_MAGIC;
+    packed_unknown(&seg.m);
+    seg.m.count = 1;
+    seg.m.ids[0] = 1;
+    seg.m.next_id = 2;
+    return manifest_commit(&seg.m);
+}
+
+static bool manifest_has(const manifest_t *m, uint32_t id)
+{
+    for (uint32_t i = 0; i < m->count; i++) {
+        if (m->ids[i] == id) return true;
+    }
+    return false;
+}
+
+// Удаляем сегменты, которых нет в манифесте: результат оборванной компактации
+// или хвосты уже удалённых по ротации
+static void collect_garbage(void)
+{
+    DIR *d = opendir(seg.dir);
+    if (!d) return;
+
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        unsigned long id;
+        if (sscanf(e->d_name, "SEG%05lu.BIN", &id) != 1) continue;
+        if (manifest_has(&seg.m, id)) continue;
+
+        char path[SD_SEGMENT_PATH_LEN];
+        seg_path(id, path, sizeof(path));
+        ESP_LOGW(TAG, "Removing orphan segment %s", path);
+        unlink(path);
+    }
+    closedir(d);
+}
+
+static uint32_t snapshot(uint32_t *ids, uint16_t *packed)
+{
+    xSemaphoreTake(seg.lock, portMAX_DELAY);
+    uint32_t n = seg.m.count;
+    memcpy(ids, seg.m.ids, n * sizeof(uint32_t));
+    if (packed) memcpy(packed, seg.m.packed, n * sizeof(uint16_t));
+    xSemaphoreGive(seg.lock);
+    return n;
+}
+
+/* ---------- Компактация ---------- */
+
+// Перепаковка записей в плотные блоки. Без файла считает только размер.
+typedef struct {
+    FILE    *f;
+    uint8_t *blk;
+    size_t   off;
+    uint32_t blocks;
+    bool     failed;
+} packer_t;
+
+static void packer_put(packer_t *p, const void *data, size_t len)
+{
+    if (p->blk && len) memcpy(p->blk + p->off, data, len);
+    p->off += len;
+}
+
+static void packer_emit(packer_t *p)
+{
+    if (p->off == 0) return;
+    if (p->f) {
+        memset(p->blk + p->off, 0, SD_RECORD_BLOCK_SIZE - p->off);
+        if (fwrite(p->blk, 1, SD_RECORD_BLOCK_SIZE, p->f) != SD_RECORD_BLOCK_SIZE) {
+            p->failed = true;
+        }
+    }
+    p->blocks++;
+    p->off = 0;
+}
+
+static bool packer_add(const sd_record_t *rec, void *arg)
+{
+    packer_t *p = arg;
+    sd_record_hdr_t hdr;
+    size_t need = SD_RECORD_HDR_SIZE + rec->len;
+
+    if (p->off && p->off + need > SD_RECORD_BLOCK_SIZE) {
+        packer_emit(p);
+    }
+    if (p->off == 0) {
+        sd_record_encode(&hdr, SD_REC_INDEX, rec->seq, rec->ts_ms, NULL, 0);
+        packer_put(p, &hdr, sizeof(hdr));
+    }
+    sd_record_encode(&hdr, rec->type, rec->seq, rec->ts_ms, rec->data, rec->len);
+    packer_put(p, &hdr, sizeof(hdr));
+    packer_put(p, rec->data, rec->len);
+
+    return !p->failed;
+}
+
+static long file_size(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 ? st.st_size : 0;
+}
+
+// Размер закрытого сегмента после перепаковки: из манифеста или одним чтением.
+// Посчитанное попадает на карту со следующим коммитом манифеста.
+static uint32_t packed_blocks(uint32_t id, uint16_t cached, const char *path)
+{
+    if (cached != PACKED_UNKNOWN) return cached;
+
+    packer_t dry = { 0 };
+    sd_record_read_from(path, 0, packer_add, &dry);
+    uint32_t blocks = dry.blocks + (dry.off ? 1 : 0);
+
+    xSemaphoreTake(seg.lock, portMAX_DELAY);
+    for (uint32_t i = 0; i + 1 < seg.m.count; i++) {
+        if (seg.m.ids[i] == id) seg.m.packed[i] = (uint16_t)blocks;
+    }
+    xSemaphoreGive(seg.lock);
+    return blocks;
+}
+
+// Сливает самые старые закрытые сегменты в один, если это экономит хотя бы
+// четверть места. Возвращает true, если что-то сжали.
+static bool compact_once(void)
+{
+    uint32_t ids[SD_SEGMENT_MAX];
+    uint16_t cached[SD_SEGMENT_MAX];
+    uint32_t n = snapshot(ids, cached);
+    char path[SD_SEGMENT_PATH_LEN];
+
+    // сколько старых сегментов влезет в один после перепаковки. Сумма по
+    // сегментам - оценка сверху: при слиянии хвостовые блоки могут ужаться.
+    uint32_t run = 0, blocks = 0;
+    long src_bytes = 0;
+    for (uint32_t i = 0; i + 1 < n && !seg.stop; i++) {
+        seg_path(ids[i], path, sizeof(path));
+        uint32_t b = packed_blocks(ids[i], cached[i], path);
+        if ((blocks + b) * SD_RECORD_BLOCK_SIZE > SD_SEGMENT_SIZE) break;
+        blocks += b;
+        run = i + 1;
+        src_bytes += file_size(path);
+    }
+    if (run < 2 || seg.stop) return false;
+
+    long packed = (long)blocks * SD_RECORD_BLOCK_SIZE;
+    if (packed * 4 > src_bytes * 3) return false;
+
+    xSemaphoreTake(seg.lock, portMAX_DELAY);
+    uint32_t new_id = seg.m.next_id++;
+    xSemaphoreGive(seg.lock);
+
+    char new_path[SD_SEGMENT_PATH_LEN];
+    seg_path(new_id, new_path, sizeof(new_path));
+
+    packer_t p = { 0 };
+    p.blk = malloc(SD_RECORD_BLOCK_SIZE);
+    p.f = p.blk ? fopen(new_path, "wb") : NULL;
+    if (!p.f) {
+        free(p.blk);
+        return false;
+    }
+    setvbuf(p.f, NULL, _IONBF, 0);
+
+    for (uint32_t i = 0; i < run && !p.failed; i++) {
+        seg_path(ids[i], path, sizeof(path));
+        sd_record_read_from(path, 0, packer_add, &p);
+    }
+    packer_emit(&p);
+    if (fsync(fileno(p.f)) != 0) p.failed = true;
+    fclose(p.f);
+    free(p.blk);
+
+    if (p.failed) {
+        ESP_LOGE(TAG, "Compaction write failed");
+        unlink(new_path);
+        return false;
+    }
+
+    // пока писали, ротация могла удалить самые старые сегменты
+    xSemaphoreTake(seg.lock, portMAX_DELAY);
+    bool same = seg.m.count > run && memcmp(seg.m.ids, ids, run * sizeof(uint32_t)) == 0;
+    esp_err_t ret = ESP_FAIL;
+    if (same) {
+        manifest_t m = seg.m;
+        m.ids[0] = new_id;
+        m.packed[0] = (uint16_t)p.blocks;
+        memmove(&m.ids[1], &m.ids[run], (m.count - run) * sizeof(uint32_t));
+        memmove(&m.packed[1], &m.packed[run], (m.count - run) * sizeof(uint16_t));
+        m.count -= run - 1;
+        ret = manifest_commit(&m);
+        if (ret == ESP_OK) seg.m = m;
+    }
+    xSemaphoreGive(seg.lock);
+
+    if (ret != ESP_OK) {
+        unlink(new_path);
+        return false;
+    }
+
+    // манифест уже не ссылается на старые файлы, обрыв здесь уберёт GC
+    for (uint32_t i = 0; i < run; i++) {
+        seg_path(ids[i], path, sizeof(path));
+        unlink(path);
+    }
+    ESP_LOGI(TAG, "Compacted %lu segments (%ld B) into SEG%05lu (%ld B)",
+             (unsigned long)run, src_bytes, (unsigned long)new_id,
+             (long)p.blocks * SD_RECORD_BLOCK_SIZE);
+    return true;
+}
+
+static void compact_task(void *arg)
+{
+    while (!seg.stop) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (!seg.stop && compact_once()) {
+        }
+    }
+    xSemaphoreGive(seg.done);
+    vTaskDelete(NULL);
+}
+
+/* ---------- API ---------- */
+
+esp_err_t sd_segment_init(const char *dir)
+{
+    if (!dir || strlen(dir) >= sizeof(seg.dir)) return ESP_ERR_INVALID_ARG;
+    if (seg.lock) return ESP_ERR_INVALID_STATE;
+
+    strcpy(seg.dir, dir);
+    mkdir(seg.dir, 0775);
+
+    esp_err_t ret = manifest_recover();
+    if (ret != ESP_OK) return ret;
+    collect_garbage();
+
+    seg.lock = xSemaphoreCreateMutex();
+    seg.done = xSemaphoreCreateBinary();
+    if (!seg.lock || !seg.done) goto fail;
+
+    seg.stop = false;
+    if (xTaskCreate(compact_task, "sd_compact", SD_SEGMENT_COMPACT_STACK, NULL,
+                    SD_SEGMENT_COMPACT_PRIO, &seg.compactor) != pdPASS) {
+        goto fail;
+    }
+
+    ESP_LOGI(TAG, "%lu segments, active SEG%05lu", (unsigned long)seg.m.count,
+             (unsigned long)seg.m.ids[seg.m.count - 1]);
+    return ESP_OK;
+
+fail:
+    if (seg.done) vSemaphoreDelete(seg.done);
+    if (seg.lock) vSemaphoreDelete(seg.lock);
+    seg.done = NULL;
+    seg.lock = NULL;
+    return ESP_ERR_NO_MEM;
+}
+
+void sd_segment_deinit(void)
+{
+    if (!seg.lock) return;
+
+    seg.stop = true;
+    xTaskNotifyGive(seg.compactor);
+    xSemaphoreTake(seg.done, portMAX_DELAY);
+
+    vSemaphoreDelete(seg.done);
+    vSemaphoreDelete(seg.lock);
+    seg.done = NULL;
+    seg.lock = NULL;
+}
+
+esp_err_t sd_segment_active_path(char *path, size_t size)
+{
+    if (!path) return ESP_ERR_INVALID_ARG;
+    if (!seg.lock) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(seg.lock, portMAX_DELAY);
+    seg_path(seg.m.ids[seg.m.count - 1], path, size);
+    xSemaphoreGive(seg.lock);
+    return ESP_OK;
+}
+
+esp_err_t sd_segment_reserve(uint32_t *id, char *path, size_t size)
+{
+    if (!id || !path) return ESP_ERR_INVALID_ARG;
+    if (!seg.lock) return ESP_ERR_INVALID_STATE;
+
+    // как у компактации: номер не коммитится, неиспользованный просто пропадёт
+    xSemaphoreTake(seg.lock, portMAX_DELAY);
+    *id = seg.m.next_id++;
+    xSemaphoreGive(seg.lock);
+
+    seg_path(*id, path, size);
+    return ESP_OK;
+}
+
+esp_err_t sd_segment_rotate(uint32_t id)
+{
+    if (!seg.lock) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(seg.lock, portMAX_DELAY);
+    manifest_t m = seg.m;
+    uint32_t dropped = 0;
+    if (m.count == SD_SEGMENT_MAX) {
+        dropped = m.ids[0];
+        memmove(&m.ids[0], &m.ids[1], (m.count - 1) * sizeof(uint32_t));
+        memmove(&m.packed[0], &m.packed[1], (m.count - 1) * sizeof(uint16_t));
+        m.count--;
+    }
+    m.ids[m.count] = id;
+    m.packed[m.count] = PACKED_UNKNOWN;
+    m.count++;
+
+    esp_err_t ret = manifest_commit(&m);
+    if (ret == ESP_OK) seg.m = m;
+    xSemaphoreGive(seg.lock);
+    if (ret != ESP_OK) return ret;
+
+    if (dropped) {
+        char old[SD_SEGMENT_PATH_LEN];
+        seg_path(dropped, old, sizeof(old));
+        unlink(old);
+    }
+    ESP_LOGI(TAG, "Rotated to SEG%05lu", (unsigned long)id);
+
+    xTaskNotifyGive(seg.compactor);
+    return ESP_OK;
+}
+
+esp_err_t sd_segment_tail(uint32_t *next_seq, uint64_t *last_ts)
+{
+    if (!next_seq || !last_ts) return ESP_ERR_INVALID_ARG;
+    if (!seg.lock) return ESP_ERR_INVALID_STATE;
+
+    uint32_t ids[SD_SEGMENT_MAX];
+    uint32_t n = snapshot(ids, NULL);
+    char path[SD_SEGMENT_PATH_LEN];
+
+    *next_seq = 0;
+    *last_ts = 0;
+    // активный сегмент может быть ещё пуст - берём предыдущий
+    for (uint32_t i = n; i-- > 0;) {
+        seg_path(ids[i], path, sizeof(path));
+        if (sd_record_tail(path, next_seq, last_ts) == ESP_OK && *last_ts != 0) break;
+    }
+    return ESP_OK;
+}
+
+typedef struct {
+    sd_record_cb_t cb;
+    void          *arg;
+    bool           stopped;
+} replay_ctx_t;
+
+static bool replay_cb(const sd_record_t *rec, void *arg)
+{
+    replay_ctx_t *ctx = arg;
+    if (!ctx->cb(rec, ctx->arg)) {
+        ctx->stopped = true;
+        return false;
+    }
+    return true;
+}
+
+esp_err_t sd_segment_read_last(uint32_t count, sd_record_cb_t cb, void *arg)
+{
+    if (!cb) return ESP_ERR_INVALID_ARG;
+
+    uint32_t total, ids[SD_SEGMENT_MAX];
+    uint64_t last_ts;
+    esp_err_t ret = sd_segment_tail(&total, &last_ts);
+    if (ret != ESP_OK) return ret;
+
+    uint32_t first = total > count ? total - count : 0;
+    uint32_t n = snapshot(ids, NULL);
+    char path[SD_SEGMENT_PATH_LEN];
+
+    // самый новый сегмент, который начинается не позже first
+    uint32_t start = 0;
+    for (uint32_t i = n; i-- > 0;) {
+        uint32_t head;
+        seg_path(ids[i], path, sizeof(path));
+        if (sd_record_head(path, &head) == ESP_OK && head <= first) {
+            start = i;
+            break;
+        }
+    }
+
+    replay_ctx_t ctx = { .cb = cb, .arg = arg };
+    for (uint32_t i = start; i < n && !ctx.stopped; i++) {
+        seg_path(ids[i], path, sizeof(path));
+        sd_record_read_from(path, first, replay_cb, &ctx);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,78 @@
+//
+// Created by deity on 17.10.2026.
+//
+#pragma once
+
+#ifndef SD_SEGMENT_H
+#define SD_SEGMENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sd_record.h"
+
+// Лог хранится сегментами фиксированного размера SEGnnnnn.BIN в одном
+// каталоге. Список живых сегментов - в MANIFEST.BIN, который всегда
+// переписывается через MANIFEST.TMP + rename, так что обрыв питания оставляет
+// либо старую, либо новую версию. Файлы, которых нет в манифесте, удаляются
+// при старте (недописанная компактация или ротация).
+#define SD_SEGMENT_SIZE         (64 * SD_RECORD_BLOCK_SIZE)    // 256 КБ
+#define SD_SEGMENT_MAX          32      // хранить не больше сегментов, старые удаляются
+#define SD_SEGMENT_PATH_LEN     48
+
+#define SD_SEGMENT_COMPACT_STACK    4096
+#define SD_SEGMENT_COMPACT_PRIO     1
+
+/**
+ * @brief Open the segment directory, recover the manifest and start compaction
+ * @param dir directory on the mounted card, e.g. "/sdcard/log"
+ * @return ESP_OK on success
+ */
+esp_err_t sd_segment_init(const char *dir);
+
+/**
+ * @brief Stop the compaction task
+ */
+void sd_segment_deinit(void);
+
+/**
+ * @brief Path of the segment currently being appended to
+ * @return ESP_OK on success
+ */
+esp_err_t sd_segment_active_path(char *path, size_t size);
+
+/**
+ * @brief Reserve an id for the next active segment
+ *
+ * The caller creates the file at \p path and then commits it with
+ * ::sd_segment_rotate(), so a failed open leaves the manifest untouched.
+ *
+ * @param[out] id   segment id for ::sd_segment_rotate()
+ * @param[out] path path of the segment file
+ * @return ESP_OK on success
+ */
+esp_err_t sd_segment_reserve(uint32_t *id, char *path, size_t size);
+
+/**
+ * @brief Seal the active segment and commit segment \p id as the new one
+ *
+ * Drops the oldest segments past SD_SEGMENT_MAX and wakes up compaction.
+ *
+ * @param id id from ::sd_segment_reserve()
+ * @return ESP_OK on success
+ */
+esp_err_t sd_segment_rotate(uint32_t id);
+
+/**
+ * @brief End of the log over all segments, see ::sd_record_tail()
+ * @return ESP_OK on success
+ */
+esp_err_t sd_segment_tail(uint32_t *next_seq, uint64_t *last_ts);
+
+/**
+ * @brief Replay the last \p count data records over all segments, oldest first
+ * @return ESP_OK on success
+ */
+esp_err_t sd_segment_read_last(uint32_t count, sd_record_cb_t cb, void *arg);
+
+#endif //SD_SEGMENT_H
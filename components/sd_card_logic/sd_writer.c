@@ -0,0 +1,375 @@
+//
+// Created by deity on 17.10.2026.
+//
+#include "sd_writer.h"
+#include "sd_log.h"
+#include "sd_record.h"
+#include "sd_segment.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "sd_writer";
+
+#define RING_SIZE   (SD_WRITER_BLOCK_SIZE * SD_WRITER_BLOCKS)
+#define RING_MASK   (RING_SIZE - 1)
+
+_Static_assert((RING_SIZE & RING_MASK) == 0, "ring size must be a power of two");
+_Static_assert(SD_WRITER_BLOCK_SIZE == SD_RECORD_BLOCK_SIZE, "record blocks must match writer blocks");
+_Static_assert(SD_SEGMENT_SIZE % RING_SIZE == 0, "segment must hold a whole number of rings");
+
+// Кольцо SPSC: head двигает только продюсер, tail - только задача-писатель.
+// Счётчики идут вместе со смещением в файле, поэтому граница блока в кольце
+// всегда совпадает с границей 4 КБ в файле и запись идёт целыми секторами.
+typedef struct {
+    uint8_t           ring[RING_SIZE];
+    atomic_uint_fast32_t head;
+    atomic_uint_fast32_t tail;
+    atomic_bool       flush_req;
+    atomic_bool       stop_req;
+    sd_log_t          log;
+    uint32_t          seg_base;     // позиция кольца, с которой начался текущий сегмент
+    bool              misaligned;   // размер файла разошёлся с позицией кольца
+    TaskHandle_t      task;
+    SemaphoreHandle_t done;
+    SemaphoreHandle_t space;        // писатель освободил место, см. space_wait
+    atomic_bool       space_wait;   // продюсер ждёт места в кольце
+    sd_writer_stats_t stats;
+    // состояние продюсера
+    uint32_t          seq;
+    uint64_t          ts_base;
+    uint64_t          last_ts;
+} sd_writer_t;
+
+static sd_writer_t *w = NULL;
+
+// Позиция в кольце должна совпадать со смещением в файле. Короткая или
+// неудачная запись их разводит, поэтому файл сразу подгоняем к концу куска
+// (хвост куска - нули, как добивка блока). Не вышло - пробуем перед следующей
+// записью, до этого данные в файл не пишем.
+static esp_err_t write_chunk(uint32_t tail, uint32_t len)
+{
+    esp_err_t ret = ESP_OK;
+
+    if (w->misaligned) {
+        ret = sd_log_resize(&w->log, (long)(tail - w->seg_base));
+        w->misaligned = ret != ESP_OK;
+    }
+    if (ret == ESP_OK) {
+        ret = sd_log_write(&w->log, w->ring + (tail & RING_MASK), len);
+    }
+    if (ret != ESP_OK) {
+        w->stats.errors++;
+        w->misaligned = sd_log_resize(&w->log, (long)(tail + len - w->seg_base)) != ESP_OK;
+    }
+    // при ошибке данные всё равно освобождаем, иначе продюсер встанет навсегда
+    atomic_store_explicit(&w->tail, tail + len, memory_order_release);
+    if (atomic_exchange(&w->space_wait, false)) {
+        xSemaphoreGive(w->space);
+    }
+    return ret;
+}
+
+// Текущий сегмент заполнен: новый открываем до закрытия старого. Если не
+// вышло, пишем дальше в старый и пробуем снова на следующем блоке.
+static bool rotate_segment(uint32_t tail)
+{
+    char path[SD_SEGMENT_PATH_LEN];
+    uint32_t id;
+    sd_log_t next;
+
+    if (sd_segment_reserve(&id, path, sizeof(path)) != ESP_OK
+        || sd_log_open(&next, path, &w->log.cfg) != ESP_OK) {
+        w->stats.errors++;
+        return false;
+    }
+    // старый сегмент на карте целиком до того, как манифест его закроет
+    sd_log_flush(&w->log, true);
+    if (sd_segment_rotate(id) != ESP_OK) {
+        sd_log_close(&next);
+        unlink(path);
+        w->stats.errors++;
+        return false;
+    }
+    sd_log_close(&w->log);
+    w->log = next;
+    w->seg_base = tail;
+    w->misaligned = false;
+    return true;
+}
+
+static void writer_task(void *arg)
+{
+    bool dirty = false;     // есть записанные, но не fsync-нутые данные
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SD_WRITER_FLUSH_MS));
+
+        uint32_t tail = atomic_load_explicit(&w->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&w->head, memory_order_acquire);
+
+        // сначала все полные блоки (первый может быть хвостом до границы)
+        while (true) {
+            uint32_t to_boundary = SD_WRITER_BLOCK_SIZE - (tail & (SD_WRITER_BLOCK_SIZE - 1));
+            if (head - tail < to_boundary) break;
+
+            write_chunk(tail, to_boundary);
+            tail += to_boundary;
+            w->stats.blocks++;
+            dirty = true;
+
+            if (tail - w->seg_base >= SD_SEGMENT_SIZE && rotate_segment(tail)) {
+                dirty = false;
+            }
+            head = atomic_load_explicit(&w->head, memory_order_acquire);
+        }
+
+        bool stop = atomic_load(&w->stop_req);
+        bool flush = atomic_exchange(&w->flush_req, false);
+        int64_t age_us = esp_timer_get_time() - w->log.last_flush_us;
+        bool timed_out = age_us >= (int64_t)SD_WRITER_FLUSH_MS * 1000;
+
+        // неполный блок отдаём только по таймеру, запросу или остановке
+        if (head != tail && (stop || flush || timed_out)) {
+            write_chunk(tail, head - tail);
+            w->stats.partial++;
+            dirty = true;
+        }
+
+        // один fsync на пачку блоков, когда кольцо опустело
+        if (dirty && (stop || flush || timed_out
+                      || atomic_load_explicit(&w->head, memory_order_acquire) == tail)) {
+            if (sd_log_flush(&w->log, true) != ESP_OK) {
+                w->stats.errors++;
+            }
+            dirty = false;
+        }
+
+        if (stop) break;
+    }
+
+    xSemaphoreGive(w->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t sd_writer_start(void)
+{
+    if (w) return ESP_ERR_INVALID_STATE;
+
+    w = calloc(1, sizeof(sd_writer_t));
+    if (!w) return ESP_ERR_NO_MEM;
+
+    // продолжаем нумерацию и время с конца существующего лога
+    esp_err_t ret = sd_segment_tail(&w->seq, &w->last_ts);
+    if (ret != ESP_OK) goto fail;
+    w->ts_base = w->last_ts + 1 - esp_timer_get_time() / 1000;
+
+    char path[SD_SEGMENT_PATH_LEN];
+    ret = sd_segment_active_path(path, sizeof(path));
+    if (ret != ESP_OK) goto fail;
+
+    // без RAM-буфера: буфером служит само кольцо
+    sd_log_config_t cfg = SD_LOG_CONFIG_DEFAULT();
+    cfg.buf_size = 0;
+    ret = sd_log_open(&w->log, path, &cfg);
+    if (ret != ESP_OK) goto fail;
+
+    // не вышло - остаёмся в старом, писатель повторит после первого блока
+    if (w->log.size >= SD_SEGMENT_SIZE) {
+        rotate_segment(0);
+    }
+
+    // хвост прошлой сессии мог оборваться посреди записи - начинаем с нового блока
+    uint32_t pos = (uint32_t)w->log.size;
+    uint32_t pad = (SD_WRITER_BLOCK_SIZE - (pos & (SD_WRITER_BLOCK_SIZE - 1))) & (SD_WRITER_BLOCK_SIZE - 1);
+    memset(w->ring + (pos & RING_MASK), 0, pad);
+
+    atomic_init(&w->head, pos + pad);
+    atomic_init(&w->tail, pos);
+    atomic_init(&w->flush_req, false);
+    atomic_init(&w->stop_req, false);
+
+    atomic_init(&w->space_wait, false);
+
+    w->done = xSemaphoreCreateBinary();
+    w->space = xSemaphoreCreateBinary();
+    if (!w->done || !w->space) {
+        ret = ESP_ERR_NO_MEM;
+        goto fail_sem;
+    }
+
+    if (xTaskCreate(writer_task, "sd_writer", SD_WRITER_TASK_STACK, NULL,
+                    SD_WRITER_TASK_PRIO, &w->task) != pdPASS) {
+        ret = ESP_ERR_NO_MEM;
+        goto fail_sem;
+    }
+
+    ESP_LOGI(TAG, "Started, %d x %d B blocks", SD_WRITER_BLOCKS, SD_WRITER_BLOCK_SIZE);
+    return ESP_OK;
+
+fail_sem:
+    if (w->done) vSemaphoreDelete(w->done);
+    if (w->space) vSemaphoreDelete(w->space);
+    sd_log_close(&w->log);
+fail:
+    free(w);
+    w = NULL;
+    return ret;
+}
+
+static void ring_put(uint32_t *pos, const void *data, size_t len)
+{
+    size_t at = *pos & RING_MASK;
+    size_t first = RING_SIZE - at;
+    if (first > len) first = len;
+
+    if (data) {
+        memcpy(w->ring + at, data, first);
+        memcpy(w->ring, (const uint8_t *)data + first, len - first);
+    } else {
+        memset(w->ring + at, 0, first);
+        memset(w->ring, 0, len - first);
+    }
+    *pos += len;
+}
+
+// Кладёт запись в кольцо, если есть место; отказ не считает
+static esp_err_t queue_record(sd_record_type_t type, const void *data, size_t len)
+{
+    uint32_t head = atomic_load_explicit(&w->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&w->tail, memory_order_acquire);
+
+    // запись не пересекает границу блока, а каждый блок открывается индексом
+    size_t need = SD_RECORD_HDR_SIZE + len;
+    size_t off = head & (SD_WRITER_BLOCK_SIZE - 1);
+    size_t pad = (off != 0 && off + need > SD_WRITER_BLOCK_SIZE) ? SD_WRITER_BLOCK_SIZE - off : 0;
+    size_t idx = (off == 0 || pad) ? SD_RECORD_HDR_SIZE : 0;
+
+    if (pad + idx + need > RING_SIZE - (head - tail)) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint64_t ts = w->ts_base + esp_timer_get_time() / 1000;
+    if (ts < w->last_ts) ts = w->last_ts;
+    w->last_ts = ts;
+
+    sd_record_hdr_t hdr;
+    uint32_t pos = head;
+    if (pad) {
+        ring_put(&pos, NULL, pad);
+    }
+    if (idx) {
+        sd_record_encode(&hdr, SD_REC_INDEX, w->seq, ts, NULL, 0);
+        ring_put(&pos, &hdr, sizeof(hdr));
+    }
+    sd_record_encode(&hdr, type, w->seq++, ts, data, (uint16_t)len);
+    ring_put(&pos, &hdr, sizeof(hdr));
+    ring_put(&pos, data, len);
+
+    // публикуем запись целиком одним сдвигом head
+    atomic_store_explicit(&w->head, pos, memory_order_release);
+    w->stats.records++;
+
+    // будим писателя только когда набрался полный блок
+    uint32_t block = SD_WRITER_BLOCK_SIZE - 1;
+    if ((pos & ~block) != (head & ~block)) {
+        xTaskNotifyGive(w->task);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t check_record(sd_record_type_t type, const void *data, size_t len)
+{
+    if (!w) return ESP_ERR_INVALID_STATE;
+    if ((!data && len) || type == SD_REC_INDEX) return ESP_ERR_INVALID_ARG;
+    if (len > SD_RECORD_MAX_PAYLOAD) return ESP_ERR_INVALID_SIZE;
+    return ESP_OK;
+}
+
+esp_err_t sd_writer_write_record(sd_record_type_t type, const void *data, size_t len)
+{
+    esp_err_t ret = check_record(type, data, len);
+    if (ret != ESP_OK) return ret;
+
+    ret = queue_record(type, data, len);
+    if (ret == ESP_ERR_NO_MEM) {
+        w->stats.dropped++;
+    }
+    return ret;
+}
+
+esp_err_t sd_writer_write_record_wait(sd_record_type_t type, const void *data, size_t len, TickType_t ticks)
+{
+    esp_err_t ret = check_record(type, data, len);
+    if (ret != ESP_OK) return ret;
+
+    TickType_t start = xTaskGetTickCount();
+    while ((ret = queue_record(type, data, len)) == ESP_ERR_NO_MEM) {
+        // флаг ставим до повторной проверки: место, освобождённое между ними,
+        // либо увидит повтор, либо писатель отдаст семафор
+        atomic_store(&w->space_wait, true);
+        if ((ret = queue_record(type, data, len)) != ESP_ERR_NO_MEM) break;
+
+        TickType_t waited = xTaskGetTickCount() - start;
+        if (ticks != portMAX_DELAY && waited >= ticks) break;
+        xSemaphoreTake(w->space, ticks == portMAX_DELAY ? portMAX_DELAY : ticks - waited);
+    }
+    if (ret == ESP_ERR_NO_MEM) {
+        w->stats.dropped++;
+    }
+    return ret;
+}
+
+esp_err_t sd_writer_write_text(const char *text)
+{
+    if (!text) return ESP_ERR_INVALID_ARG;
+    return sd_writer_write_record(SD_REC_TEXT, text, strlen(text));
+}
+
+esp_err_t sd_writer_flush(void)
+{
+    if (!w) return ESP_ERR_INVALID_STATE;
+
+    atomic_store(&w->flush_req, true);
+    xTaskNotifyGive(w->task);
+    return ESP_OK;
+}
+
+esp_err_t sd_writer_stop(void)
+{
+    if (!w) return ESP_ERR_INVALID_STATE;
+
+    atomic_store(&w->stop_req, true);
+    xTaskNotifyGive(w->task);
+    xSemaphoreTake(w->done, portMAX_DELAY);
+    vSemaphoreDelete(w->done);
+    vSemaphoreDelete(w->space);
+
+    ESP_LOGI(TAG, "Stopped: %lu records, %lu dropped, %lu blocks, %lu partial, %lu errors",
+             (unsigned long)w->stats.records, (unsigned long)w->stats.dropped,
+             (unsigned long)w->stats.blocks, (unsigned long)w->stats.partial,
+             (unsigned long)w->stats.errors);
+
+    esp_err_t ret = sd_log_close(&w->log);
+    free(w);
+    w = NULL;
+    return ret;
+}
+
+void sd_writer_get_stats(sd_writer_stats_t *stats)
+{
+    if (!stats) return;
+    if (!w) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = w->stats;
+}
@@ -0,0 +1,89 @@
+//
+// Created by deity on 17.10.2026.
+//
+#pragma once
+
+#ifndef SD_WRITER_H
+#define SD_WRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "sd_record.h"
+
+// Блок = 8 секторов SD и одна DMA-транзакция (max_transfer_sz в init_card).
+// Оба значения - степени двойки, позиция в кольце совпадает со смещением в файле
+#define SD_WRITER_BLOCK_SIZE    4096
+#define SD_WRITER_BLOCKS        2
+
+#define SD_WRITER_TASK_STACK    4096
+#define SD_WRITER_TASK_PRIO     5
+#define SD_WRITER_FLUSH_MS      2000
+
+typedef struct {
+    uint32_t records;           // принято записей от продюсера
+    uint32_t dropped;           // отказов ESP_ERR_NO_MEM: кольцо было полно (и повторы)
+    uint32_t blocks;            // полных блоков записано на карту
+    uint32_t partial;           // неполных сбросов по таймеру/запросу
+    uint32_t errors;            // ошибок fwrite/fsync
+} sd_writer_stats_t;
+
+/**
+ * @brief Open the active log segment and start the writer task
+ *
+ * ::sd_segment_init() must be called first.
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t sd_writer_start(void);
+
+/**
+ * @brief Frame a record (see sd_record.h) and queue it for writing, never blocks
+ *
+ * Must be called from a single producer task. The record is either queued
+ * whole or dropped whole.
+ *
+ * @param type  record type, not SD_REC_INDEX
+ * @param data  payload
+ * @param len   payload length, up to SD_RECORD_MAX_PAYLOAD
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the ring is full
+ */
+esp_err_t sd_writer_write_record(sd_record_type_t type, const void *data, size_t len);
+
+/**
+ * @brief Like ::sd_writer_write_record(), but waits for room in the ring
+ *
+ * The writer wakes the caller as soon as it has written a block, so the
+ * wait is as short as the card allows. Same single producer task as
+ * ::sd_writer_write_record().
+ *
+ * @param ticks how long to wait, portMAX_DELAY for as long as it takes
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the ring is still full after \p ticks
+ */
+esp_err_t sd_writer_write_record_wait(sd_record_type_t type, const void *data, size_t len, TickType_t ticks);
+
+/**
+ * @brief Queue a text record
+ * @return ESP_OK, or ESP_ERR_NO_MEM if the ring is full
+ */
+esp_err_t sd_writer_write_text(const char *text);
+
+/**
+ * @brief Ask the writer to push out the partial block and fsync
+ * @return ESP_OK on success
+ */
+esp_err_t sd_writer_flush(void);
+
+/**
+ * @brief Drain the ring, close the file and stop the task
+ * @return ESP_OK on success
+ */
+esp_err_t sd_writer_stop(void);
+
+/**
+ * @brief Copy current counters
+ */
+void sd_writer_get_stats(sd_writer_stats_t *stats);
+
+#endif //SD_WRITER_H
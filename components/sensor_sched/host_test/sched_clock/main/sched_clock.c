@@ -0,0 +1,211 @@
+//
+// Created by deity on 17.10.2026.
+//
+// sensor_sched на поддельных часах: задача планировщика настоящая, но
+// esp_timer_get_time() отдаёт счётчик, а её vTaskDelay() только сдвигает его
+// (--wrap), так что SCHED_CLOCK_MS (1000) мс расписания проходят мгновенно и
+// всегда одинаково.
+//
+// Четыре датчика, как на плате:
+// - 100 мс, преобразование 15 мс, чтение регистра запросом i2cdev (как bme680);
+// - 100 мс, 16 мс, чтение после байта команды (как sht3x);
+// - 10 мс, 1.3 мс, на другом порту (как ads111x);
+// - 1 с, 200 мс, без запроса, read() читает сам.
+// Запросы идут через настоящий рабочий поток i2cdev в эмуляцию шины; запуск
+// кладёт в регистры датчика номер преобразования, чтение сверяет его.
+//
+// Проверяется:
+// - каждый отсчёт: метка = запуск по сетке периода + время преобразования;
+// - число отсчётов каждого датчика: все преобразования, закончившиеся до конца;
+// - в проходе все запросы поставлены до первого ожидания (читаются вместе);
+// - нет опозданий на период и ошибок.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "i2c_mock.h"
+#include "msg_bus.h"
+#include "sensor_sched.h"
+
+#define TICK_US     (portTICK_PERIOD_MS * 1000)
+
+typedef struct {
+    const char *name;
+    uint32_t    period_ms;
+    uint32_t    conv_us;
+    i2c_port_t  port;
+    uint8_t     addr;
+    uint8_t     reg;        // регистр результата
+    bool        command;    // читать после байта команды, i2c_dev_read_async()
+    bool        async;      // чтение запросом i2cdev
+
+    i2c_dev_t   dev;
+    uint8_t     regs[256];
+    uint8_t     raw;
+    int         id;
+    uint32_t    starts;
+    uint32_t    samples;
+    uint32_t    bad;        // неверная метка или данные
+} fake_t;
+
+static fake_t fakes[] = {
+    { .name = "15 ms / 100 ms", .period_ms = 100, .conv_us = 15000, .port = 0, .addr = 0x77, .reg = 0x1d, .async = true },
+    { .name = "16 ms / 100 ms", .period_ms = 100, .conv_us = 16000, .port = 0, .addr = 0x44, .reg = 0x20,
+      .async = true, .command = true },
+    { .name = "1.3 ms / 10 ms", .period_ms = 10, .conv_us = 1300, .port = 1, .addr = 0x48, .reg = 0x00, .async = true },
+    { .name = "200 ms / 1 s",   .period_ms = 1000, .conv_us = 200000, .port = 0, .addr = 0x76, .reg = 0x10 },
+};
+#define FAKES   (sizeof(fakes) / sizeof(fakes[0]))
+
+static int64_t clock_us;
+static int64_t end_us;
+static bool waited;             // в этом проходе уже ждали запрос
+static uint32_t late_queue;     // запрос поставлен после ожидания другого
+
+int64_t __wrap_esp_timer_get_time(void)
+{
+    return clock_us;
+}
+
+static void finish(void);
+
+void __real_vTaskDelay(TickType_t ticks);
+void __wrap_vTaskDelay(TickType_t ticks)
+{
+    if (strcmp(pcTaskGetName(NULL), "sensor_sched") != 0) {
+        __real_vTaskDelay(ticks);
+        return;
+    }
+    // сон планировщика - граница прохода
+    clock_us += (int64_t)ticks * TICK_US;
+    waited = false;
+    if (clock_us > end_us) finish();
+}
+
+esp_err_t __real_i2c_dev_async_wait(i2c_dev_async_t *req, TickType_t ticks);
+esp_err_t __wrap_i2c_dev_async_wait(i2c_dev_async_t *req, TickType_t ticks)
+{
+    waited = true;
+    return __real_i2c_dev_async_wait(req, ticks);
+}
+
+esp_err_t __wrap_msg_bus_post(msg_topic_t topic, msg_type_t type, const void *data, size_t len)
+{
+    const sensor_sample_t *s = data;
+    if (topic != MSG_TOPIC_SENSOR || type != MSG_SENSOR_VALUE || len != sizeof(*s) || s->sensor >= FAKES) {
+        printf("unexpected message on topic %d\n", topic);
+        exit(1);
+    }
+    fake_t *f = &fakes[s->sensor];
+    int64_t expect = (int64_t)f->samples * f->period_ms * 1000 + f->conv_us;
+    if (s->timestamp_us != expect || s->count != 1 || s->value[0] != (float)(f->samples & 0xff)) {
+        if (!f->bad++) {
+            printf("%s: sample %lu at %lld us, value %.0f, expected %lld us, %lu\n", f->name,
+                   (unsigned long)f->samples, (long long)s->timestamp_us, s->value[0], (long long)expect,
+                   (unsigned long)(f->samples & 0xff));
+        }
+    }
+    f->samples++;
+    return ESP_OK;
+}
+
+static esp_err_t fake_start(void *ctx)
+{
+    fake_t *f = ctx;
+    // результат преобразования - его номер
+    f->regs[f->reg] = f->starts++ & 0xff;
+    return ESP_OK;
+}
+
+static uint32_t fake_conversion_us(void *ctx)
+{
+    return ((fake_t *)ctx)->conv_us;
+}
+
+static esp_err_t fake_queue_read(void *ctx, i2c_dev_async_t *req)
+{
+    fake_t *f = ctx;
+    if (waited) late_queue++;
+    if (f->command) return i2c_dev_read_async(req, &f->dev, &f->reg, 1, &f->raw, 1);
+    return i2c_dev_read_reg_async(req, &f->dev, f->reg, &f->raw, 1);
+}
+
+static esp_err_t fake_read(void *ctx, sensor_sample_t *sample)
+{
+    fake_t *f = ctx;
+    if (!f->async) f->raw = f->regs[f->reg];
+    sample->value[0] = f->raw;
+    sample->count = 1;
+    return ESP_OK;
+}
+
+static const sensor_ops_t async_ops = {
+    .start = fake_start,
+    .conversion_us = fake_conversion_us,
+    .queue_read = fake_queue_read,
+    .read = fake_read,
+};
+
+static const sensor_ops_t sync_ops = {
+    .start = fake_start,
+    .conversion_us = fake_conversion_us,
+    .read = fake_read,
+};
+
+static void finish(void)
+{
+    sensor_sched_stats_t st;
+    sensor_sched_get_stats(&st);
+
+    bool ok = st.overruns == 0 && st.errors == 0 && late_queue == 0;
+    uint32_t expected = 0;
+    for (size_t i = 0; i < FAKES; i++) {
+        fake_t *f = &fakes[i];
+        // все преобразования, закончившиеся до конца расписания
+        int64_t period = (int64_t)f->period_ms * 1000;
+        uint32_t due = end_us >= f->conv_us ? (uint32_t)((end_us - f->conv_us) / period) + 1 : 0;
+        expected += due;
+        bool good = f->samples == due && f->bad == 0;
+        ok = ok && good;
+        printf("%-16s %4lu samples (%lu expected), %lu wrong%s\n", f->name, (unsigned long)f->samples,
+               (unsigned long)due, (unsigned long)f->bad, good ? "" : "  <-");
+    }
+    ok = ok && st.samples == expected;
+    printf("%lld ms: %lu samples in %lu read passes, %lu overruns, %lu errors, %lu reads queued after a wait: %s\n",
+           (long long)(end_us / 1000), (unsigned long)st.samples, (unsigned long)st.passes,
+           (unsigned long)st.overruns, (unsigned long)st.errors, (unsigned long)late_queue, ok ? "OK" : "FAILED");
+    fflush(stdout);
+    exit(ok ? 0 : 1);
+}
+
+void app_main(void)
+{
+    const char *env = getenv("SCHED_CLOCK_MS");
+    end_us = (int64_t)(env ? atoi(env) : 1000) * 1000;
+
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    if (i2cdev_init() != ESP_OK) {
+        printf("i2cdev init failed\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < FAKES; i++) {
+        fake_t *f = &fakes[i];
+        f->dev.port = f->port;
+        f->dev.addr = f->addr;
+        f->dev.cfg.master.clk_speed = 400000;
+        f->id = sensor_sched_add(f->async ? &async_ops : &sync_ops, f, f->period_ms);
+        if (i2c_mock_add_device(f->port, f->addr, f->regs, sizeof(f->regs)) != ESP_OK || f->id != (int)i) {
+            printf("%s: setup failed\n", f->name);
+            exit(1);
+        }
+    }
+    if (sensor_sched_start() != ESP_OK) {
+        printf("scheduler start failed\n");
+        exit(1);
+    }
+}
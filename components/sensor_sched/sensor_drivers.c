@@ -0,0 +1,206 @@
+//
+// Created by deity on 17.10.2026.
+//
+#include "sensor_drivers.h"
+
+#include "freertos/FreeRTOS.h"
+
+#define TICKS_TO_US(t)  ((uint32_t)(t) * portTICK_PERIOD_MS * 1000)
+
+// ADS111x
+
+#define ADS111X_REG_CONVERSION  0
+#define ADS111X_MARGIN_US       100     // внутренний генератор может отставать
+
+static const uint16_t ads111x_sps[] = { 8, 16, 32, 64, 128, 250, 475, 860 };
+
+static esp_err_t ads_start(void *ctx)
+{
+    sensor_ads111x_t *s = ctx;
+    return ads111x_start_conversion(s->dev);
+}
+
+static uint32_t ads_conversion_us(void *ctx)
+{
+    sensor_ads111x_t *s = ctx;
+    return 1000000 / ads111x_sps[s->rate] + ADS111X_MARGIN_US;
+}
+
+static esp_err_t ads_queue_read(void *ctx, i2c_dev_async_t *req)
+{
+    sensor_ads111x_t *s = ctx;
+    return i2c_dev_read_reg_async(req, s->dev, ADS111X_REG_CONVERSION, s->raw, sizeof(s->raw));
+}
+
+static esp_err_t ads_read(void *ctx, sensor_sample_t *sample)
+{
+    sensor_ads111x_t *s = ctx;
+    int16_t raw = (int16_t)(s->raw[0] << 8 | s->raw[1]);
+
+    sample->value[0] = ads111x_gain_values[s->gain] / ADS111X_MAX_VALUE * raw;
+    sample->count = 1;
+    return ESP_OK;
+}
+
+const sensor_ops_t sensor_ads111x_ops = {
+    .start = ads_start,
+    .conversion_us = ads_conversion_us,
+    .queue_read = ads_queue_read,
+    .read = ads_read,
+};
+
+// Sensirion (SHT3x, SCD4x): every 16-bit word is followed by its CRC-8
+
+#define SENSIRION_CRC_POLY  0x31
+
+static uint8_t sensirion_crc8(const uint8_t *data)
+{
+    uint8_t crc = 0xff;
+    for (int i = 0; i < 2; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = crc & 0x80 ? (crc << 1) ^ SENSIRION_CRC_POLY : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static bool sensirion_words_ok(const uint8_t *raw, size_t words)
+{
+    for (size_t i = 0; i < words; i++) {
+        if (sensirion_crc8(raw + i*3) != raw[i*3 + 2]) return false;
+    }
+    return true;
+}
+
+// BME680
+
+static esp_err_t bme_start(void *ctx)
+{
+    sensor_bme680_t *s = ctx;
+    // прошлый результат не прочитан (ошибка шины) - иначе драйвер не даст запустить
+    s->dev->meas_started = false;
+    return bme680_force_measurement(s->dev);
+}
+
+static uint32_t bme_conversion_us(void *ctx)
+{
+    sensor_bme680_t *s = ctx;
+    uint32_t ticks = 0;
+    bme680_get_measurement_duration(s->dev, &ticks);
+    return TICKS_TO_US(ticks);
+}
+
+static esp_err_t bme_queue_read(void *ctx, i2c_dev_async_t *req)
+{
+    sensor_bme680_t *s = ctx;
+    return i2c_dev_read_reg_async(req, &s->dev->i2c_dev, BME680_RAW_DATA_REG, s->raw, sizeof(s->raw));
+}
+
+static esp_err_t bme_read(void *ctx, sensor_sample_t *sample)
+{
+    sensor_bme680_t *s = ctx;
+    bme680_values_float_t v;
+    esp_err_t err = bme680_compute_results_float(s->dev, s->raw, &v);
+    if (err != ESP_OK) return err;
+
+    sample->value[0] = v.temperature;
+    sample->value[1] = v.pressure;
+    sample->value[2] = v.humidity;
+    sample->value[3] = v.gas_resistance;
+    sample->count = 4;
+    return ESP_OK;
+}
+
+const sensor_ops_t sensor_bme680_ops = {
+    .start = bme_start,
+    .conversion_us = bme_conversion_us,
+    .queue_read = bme_queue_read,
+    .read = bme_read,
+};
+
+// SHT3x
+
+// Fetch Data, как в драйвере sht3x: им же читается и single shot
+static const uint8_t sht_fetch_cmd[2] = { 0xE0, 0x00 };
+
+static esp_err_t sht_start(void *ctx)
+{
+    sensor_sht3x_t *s = ctx;
+    return sht3x_start_measurement(s->dev, SHT3X_SINGLE_SHOT, SHT3X_HIGH);
+}
+
+static uint32_t sht_conversion_us(void *ctx)
+{
+    return TICKS_TO_US(sht3x_get_measurement_duration(SHT3X_HIGH));
+}
+
+static esp_err_t sht_queue_read(void *ctx, i2c_dev_async_t *req)
+{
+    sensor_sht3x_t *s = ctx;
+    return i2c_dev_read_async(req, &s->dev->i2c_dev, sht_fetch_cmd, sizeof(sht_fetch_cmd), s->raw, sizeof(s->raw));
+}
+
+static esp_err_t sht_read(void *ctx, sensor_sample_t *sample)
+{
+    sensor_sht3x_t *s = ctx;
+    if (!sensirion_words_ok(s->raw, 2)) return ESP_ERR_INVALID_CRC;
+
+    esp_err_t err = sht3x_compute_values(s->raw, &sample->value[0], &sample->value[1]);
+    if (err != ESP_OK) return err;
+
+    sample->count = 2;
+    return ESP_OK;
+}
+
+const sensor_ops_t sensor_sht3x_ops = {
+    .start = sht_start,
+    .conversion_us = sht_conversion_us,
+    .queue_read = sht_queue_read,
+    .read = sht_read,
+};
+
+// SCD4x
+
+#define SCD4X_READ_MEASUREMENT_CMD  0xEC05
+#define SCD4X_CMD_EXEC_US           1000    // после команды ответ готов через 1 мс
+
+// "Запуск" - команда read_measurement, через 1 мс ответ читается вместе с
+// остальными датчиками прохода
+static esp_err_t scd_start(void *ctx)
+{
+    sensor_scd4x_t *s = ctx;
+    static const uint8_t cmd[2] = { SCD4X_READ_MEASUREMENT_CMD >> 8, SCD4X_READ_MEASUREMENT_CMD & 0xff };
+    return i2c_dev_write(s->dev, NULL, 0, cmd, sizeof(cmd));
+}
+
+static uint32_t scd_conversion_us(void *ctx)
+{
+    return SCD4X_CMD_EXEC_US;
+}
+
+static esp_err_t scd_queue_read(void *ctx, i2c_dev_async_t *req)
+{
+    sensor_scd4x_t *s = ctx;
+    return i2c_dev_read_async(req, s->dev, NULL, 0, s->raw, sizeof(s->raw));
+}
+
+static esp_err_t scd_read(void *ctx, sensor_sample_t *sample)
+{
+    sensor_scd4x_t *s = ctx;
+    if (!sensirion_words_ok(s->raw, 3)) return ESP_ERR_INVALID_CRC;
+
+    // как scd4x_read_measurement()
+    sample->value[0] = (uint16_t)(s->raw[0] << 8 | s->raw[1]);
+    sample->value[1] = (uint16_t)(s->raw[3] << 8 | s->raw[4]) * 175.0f / 65536.0f - 45.0f;
+    sample->value[2] = (uint16_t)(s->raw[6] << 8 | s->raw[7]) * 100.0f / 65536.0f;
+    sample->count = 3;
+    return ESP_OK;
+}
+
+const sensor_ops_t sensor_scd4x_ops = {
+    .start = scd_start,
+    .conversion_us = scd_conversion_us,
+    .queue_read = scd_queue_read,
+    .read = scd_read,
+};
@@ -0,0 +1,56 @@
+//
+// Created by deity on 17.10.2026.
+//
+#pragma once
+
+#ifndef SENSOR_DRIVERS_H
+#define SENSOR_DRIVERS_H
+
+#include "sensor_sched.h"
+#include "ads111x.h"
+#include "bme680.h"
+#include "sht3x.h"
+
+// Готовые драйверы для sensor_sched_add(). Датчик должен быть уже
+// инициализирован своим драйвером.
+
+// ADS111x в режиме single-shot: value[0] - напряжение, В.
+// Результат читается запросом i2cdev, вместе с остальными датчиками прохода.
+typedef struct {
+    i2c_dev_t          *dev;
+    ads111x_data_rate_t rate;   // как настроено в датчике
+    ads111x_gain_t      gain;
+    uint8_t             raw[2];
+} sensor_ads111x_t;
+
+extern const sensor_ops_t sensor_ads111x_ops;
+
+// BME680: температура, давление, влажность, газ.
+// Регистры результата читаются запросом i2cdev
+typedef struct {
+    bme680_t *dev;
+    uint8_t   raw[BME680_RAW_DATA_LEN];
+} sensor_bme680_t;
+
+extern const sensor_ops_t sensor_bme680_ops;
+
+// SHT3x, single shot с высокой повторяемостью: температура, влажность.
+// Результат читается запросом i2cdev
+typedef struct {
+    sht3x_t *dev;
+    uint8_t  raw[6];
+} sensor_sht3x_t;
+
+extern const sensor_ops_t sensor_sht3x_ops;
+
+// SCD4x после scd4x_start_periodic_measurement() (новые данные раз в 5 с,
+// период не меньше): CO2, температура, влажность. Команда чтения уходит при
+// запуске, ответ читается запросом i2cdev через 1 мс
+typedef struct {
+    i2c_dev_t *dev;
+    uint8_t    raw[9];
+} sensor_scd4x_t;
+
+extern const sensor_ops_t sensor_scd4x_ops;
+
+#endif //SENSOR_DRIVERS_H
@@ -0,0 +1,191 @@
+//
+// Created by deity on 17.10.2026.
+//
+#include "sensor_sched.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "msg_bus.h"
+
+static const char *TAG = "sensor_sched";
+
+_Static_assert(sizeof(sensor_sample_t) <= MSG_BUS_PAYLOAD, "sample must fit a bus message");
+
+typedef struct {
+    const sensor_ops_t *ops;
+    void               *ctx;
+    int64_t             period_us;
+    int64_t             next_start;     // следующий запуск по расписанию
+    int64_t             ready;          // конец текущего преобразования
+    bool                converting;
+    i2c_dev_async_t    *req;            // только для драйверов с queue_read
+} sensor_t;
+
+static struct {
+    sensor_t     sensors[SENSOR_SCHED_MAX];
+    size_t       count;
+    TaskHandle_t task;
+    sensor_sched_stats_t stats;
+} sched;
+
+int sensor_sched_add(const sensor_ops_t *ops, void *ctx, uint32_t period_ms)
+{
+    if (!ops || !ops->read || !period_ms || sched.task) return -1;
+    if (ops->start && !ops->conversion_us) return -1;
+    if (sched.count >= SENSOR_SCHED_MAX) return -1;
+
+    sensor_t *s = &sched.sensors[sched.count];
+    memset(s, 0, sizeof(*s));
+    if (ops->queue_read) {
+        s->req = malloc(sizeof(*s->req));
+        if (!s->req || i2c_dev_async_init(s->req, NULL, NULL) != ESP_OK) {
+            free(s->req);
+            return -1;
+        }
+    }
+    s->ops = ops;
+    s->ctx = ctx;
+    s->period_us = (int64_t)period_ms * 1000;
+    return (int)sched.count++;
+}
+
+static void schedule_next(sensor_t *s, int64_t now)
+{
+    // по сетке периода, чтобы частота не плыла от задержек чтения
+    s->next_start += s->period_us;
+    if (s->next_start <= now - s->period_us) {
+        sched.stats.overruns++;
+        s->next_start = now + s->period_us;
+    }
+}
+
+// Все, кому пора, запускаются подряд: их ожидания идут одновременно
+static void start_due(int64_t now)
+{
+    for (size_t i = 0; i < sched.count; i++) {
+        sensor_t *s = &sched.sensors[i];
+        if (s->converting || s->next_start > now) continue;
+
+        if (s->ops->start) {
+            if (s->ops->start(s->ctx) != ESP_OK) {
+                sched.stats.errors++;
+                schedule_next(s, now);
+                continue;
+            }
+            s->ready = now + s->ops->conversion_us(s->ctx);
+        } else {
+            s->ready = now;
+        }
+        s->converting = true;
+        schedule_next(s, now);
+    }
+}
+
+static void publish(size_t id, sensor_t *s)
+{
+    sensor_sample_t sample = {
+        .timestamp_us = s->ready,
+        .sensor = id,
+    };
+    if (s->ops->read(s->ctx, &sample) != ESP_OK) {
+        sched.stats.errors++;
+        return;
+    }
+    msg_bus_post(MSG_TOPIC_SENSOR, MSG_SENSOR_VALUE, &sample, sizeof(sample));
+    sched.stats.samples++;
+}
+
+// Один проход по всем готовым: сначала все сырые чтения уходят в очереди
+// i2cdev (датчики на разных портах читаются параллельно, на одном - без
+// пауз между запросами), потом разбор и остальные драйверы
+static void read_ready(int64_t now)
+{
+    bool any = false;
+
+    for (size_t i = 0; i < sched.count; i++) {
+        sensor_t *s = &sched.sensors[i];
+        if (!s->converting || s->ready > now || !s->req) continue;
+        if (s->ops->queue_read(s->ctx, s->req) != ESP_OK) {
+            sched.stats.errors++;
+            s->converting = false;
+        }
+    }
+
+    for (size_t i = 0; i < sched.count; i++) {
+        sensor_t *s = &sched.sensors[i];
+        if (!s->converting || s->ready > now) continue;
+
+        any = true;
+        s->converting = false;
+        if (s->req && i2c_dev_async_wait(s->req, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT)) != ESP_OK) {
+            sched.stats.errors++;
+            continue;
+        }
+        publish(i, s);
+    }
+    if (any) sched.stats.passes++;
+}
+
+// Ближайшее событие, сдвинутое так, чтобы захватить и те, что наступают
+// в пределах SENSOR_SCHED_SLACK_US после него
+static int64_t next_wake(void)
+{
+    int64_t first = INT64_MAX;
+    for (size_t i = 0; i < sched.count; i++) {
+        sensor_t *s = &sched.sensors[i];
+        int64_t t = s->converting ? s->ready : s->next_start;
+        if (t < first) first = t;
+    }
+
+    int64_t wake = first;
+    for (size_t i = 0; i < sched.count; i++) {
+        sensor_t *s = &sched.sensors[i];
+        int64_t t = s->converting ? s->ready : s->next_start;
+        if (t > wake && t <= first + SENSOR_SCHED_SLACK_US) wake = t;
+    }
+    return wake;
+}
+
+static void sched_task(void *arg)
+{
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < sched.count; i++) {
+        sched.sensors[i].next_start = now;
+    }
+
+    for (;;) {
+        now = esp_timer_get_time();
+        start_due(now);
+        read_ready(esp_timer_get_time());
+
+        int64_t wait = next_wake() - esp_timer_get_time();
+        if (wait > 0) {
+            // вверх до тика: проснуться раньше готовности бесполезно
+            TickType_t ticks = (wait + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000);
+            vTaskDelay(ticks);
+        }
+    }
+}
+
+esp_err_t sensor_sched_start(void)
+{
+    if (sched.task) return ESP_ERR_INVALID_STATE;
+    if (!sched.count) return ESP_ERR_NOT_FOUND;
+
+    if (xTaskCreate(sched_task, "sensor_sched", SENSOR_SCHED_TASK_STACK, NULL,
+                    SENSOR_SCHED_TASK_PRIO, &sched.task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "%u sensors", (unsigned)sched.count);
+    return ESP_OK;
+}
+
+void sensor_sched_get_stats(sensor_sched_stats_t *out)
+{
+    if (out) *out = sched.stats;
+}
@@ -0,0 +1,71 @@
+//
+// Created by deity on 17.10.2026.
+//
+#pragma once
+
+#ifndef SENSOR_SCHED_H
+#define SENSOR_SCHED_H
+
+#include <stdint.h>
+#include <esp_err.h>
+#include "i2cdev.h"
+
+// Опрос датчиков по расписанию. Все датчики, которым пора, запускаются
+// подряд, задача спит до ближайшего конца преобразования и читает все
+// готовые за один проход: запросы драйверов с queue_read уходят очередью
+// в i2cdev одновременно. Отсчёты с меткой времени идут на шину сообщений,
+// тема MSG_TOPIC_SENSOR, тип MSG_SENSOR_VALUE, данные - sensor_sample_t.
+#define SENSOR_SCHED_MAX        8
+#define SENSOR_SCHED_VALUES     4
+#define SENSOR_SCHED_SLACK_US   2000    // на столько можно отложить чтение, чтобы прочитать вместе
+#define SENSOR_SCHED_TASK_STACK 4096
+#define SENSOR_SCHED_TASK_PRIO  6
+
+typedef struct {
+    int64_t  timestamp_us;  // end of the conversion, esp_timer clock
+    uint8_t  sensor;        // id from sensor_sched_add()
+    uint8_t  count;         // values used
+    float    value[SENSOR_SCHED_VALUES];
+} sensor_sample_t;
+
+// Драйвер датчика для планировщика; ctx передаётся как есть
+typedef struct {
+    // запуск преобразования; NULL - датчик меряет сам, читаем раз в период
+    esp_err_t (*start)(void *ctx);
+    // время от запуска до готовности результата
+    uint32_t (*conversion_us)(void *ctx);
+    // необязательно: сырое чтение запросом i2cdev, разбирает его read()
+    esp_err_t (*queue_read)(void *ctx, i2c_dev_async_t *req);
+    // результат в sample->value / count
+    esp_err_t (*read)(void *ctx, sensor_sample_t *sample);
+} sensor_ops_t;
+
+typedef struct {
+    uint32_t passes;        // read passes, each reads every ready sensor
+    uint32_t samples;       // samples published
+    uint32_t errors;        // failed starts and reads
+    uint32_t overruns;      // starts later than a whole period
+} sensor_sched_stats_t;
+
+/**
+ * @brief Add a sensor; call before sensor_sched_start()
+ * @param ops        driver callbacks, must outlive the scheduler
+ * @param ctx        driver context
+ * @param period_ms  sampling period
+ * @return sensor id (>= 0) or -1 if SENSOR_SCHED_MAX sensors are added
+ */
+int sensor_sched_add(const sensor_ops_t *ops, void *ctx, uint32_t period_ms);
+
+/**
+ * @brief Start the scheduler task
+ * @return ESP_OK on success
+ */
+esp_err_t sensor_sched_start(void);
+
+/**
+ * @brief Get counters since start
+ * @param out  filled with the counters
+ */
+void sensor_sched_get_stats(sensor_sched_stats_t *out);
+
+#endif //SENSOR_SCHED_H
@@ -0,0 +1,214 @@
+//
+// Created by deity on 17.10.2026.
+//
+// Сообщение по SPP -> запись в логе на диске, для приложения под linux.
+// Приложение уже запущено: SPP - его TCP порт, карта - каталог sdcard.
+// Клиент шлёт текстовые сообщения с меткой прогона, а лог читается прямо
+// из файлов сегментов (только чтение, CRC отсекает недописанный хвост):
+//
+// 1. Задержка: SPP_TO_DISK_SINGLE сообщений по одному, для каждого время от
+//    отправки до появления записи в файле.
+// 2. Поток: SPP_TO_DISK_COUNT сообщений подряд, время до последнего ACK и до
+//    последней записи на диске.
+//
+// Переменные окружения: SPP_TO_DISK_LOG (sdcard/log, каталог лога
+// приложения), SPP_TO_DISK_COUNT (10000), SPP_TO_DISK_SINGLE (50),
+// SPP_TO_DISK_LEN (64, байт в сообщении).
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ble.h"
+#include "sd_card_logic.h"
+#include "sd_record.h"
+#include "spp_client.h"
+
+#define WAIT_DISK_MS    30000
+#define MSG_MAX         512
+
+typedef struct {
+    const char *dir;
+    uint32_t    seg;            // сегмент, в котором ждём следующую запись
+    uint32_t    next_seq;       // следующая непрочитанная запись
+    char        tag[16];        // метка прогона в начале сообщения
+    uint8_t    *found;
+    uint32_t    count;
+    uint32_t    found_count;
+} scan_t;
+
+// Сегменты с номером не меньше from, по возрастанию
+static int list_segments(const char *dir, uint32_t from, uint32_t *ids, int max)
+{
+    DIR *d = opendir(dir);
+    if (!d) return 0;
+    int n = 0;
+    struct dirent *e;
+    unsigned long id;
+    while ((e = readdir(d)) != NULL && n < max) {
+        if (sscanf(e->d_name, "SEG%5lu.BIN", &id) == 1 && id >= from) ids[n++] = id;
+    }
+    closedir(d);
+    for (int i = 1; i < n; i++) {
+        for (int j = i; j > 0 && ids[j - 1] > ids[j]; j--) {
+            uint32_t t = ids[j];
+            ids[j] = ids[j - 1];
+            ids[j - 1] = t;
+        }
+    }
+    return n;
+}
+
+static bool on_record(const sd_record_t *rec, void *arg)
+{
+    scan_t *s = arg;
+    size_t tag_len = strlen(s->tag);
+    unsigned long i;
+
+    s->next_seq = rec->seq + 1;
+    if (rec->type != SD_REC_TEXT || rec->len <= tag_len || memcmp(rec->data, s->tag, tag_len) != 0) {
+        return true;
+    }
+    char num[12] = { 0 };
+    memcpy(num, rec->data + tag_len, rec->len - tag_len < sizeof(num) - 1 ? rec->len - tag_len : sizeof(num) - 1);
+    if (sscanf(num, "%lu", &i) == 1 && i < s->count && !s->found[i]) {
+        s->found[i] = 1;
+        s->found_count++;
+    }
+    return true;
+}
+
+// Дочитываем лог от next_seq: новые записи активного сегмента и следующих
+static void scan(scan_t *s)
+{
+    uint32_t ids[64];
+    char path[300];
+    int n = list_segments(s->dir, s->seg, ids, 64);
+    for (int i = 0; i < n; i++) {
+        snprintf(path, sizeof(path), "%s/SEG%05lu.BIN", s->dir, (unsigned long)ids[i]);
+        sd_record_read_from(path, s->next_seq, on_record, s);
+        s->seg = ids[i];
+    }
+}
+
+// Хвост лога до прогона: с него и читаем
+static void scan_start(scan_t *s)
+{
+    uint32_t ids[64];
+    char path[300];
+    uint64_t ts;
+    int n = list_segments(s->dir, 0, ids, 64);
+    s->seg = n ? ids[n - 1] : 0;
+    s->next_seq = 0;
+    if (n) {
+        snprintf(path, sizeof(path), "%s/SEG%05lu.BIN", s->dir, (unsigned long)s->seg);
+        sd_record_tail(path, &s->next_seq, &ts);
+    }
+}
+
+static bool wait_disk(scan_t *s, uint32_t count)
+{
+    int64_t deadline = esp_timer_get_time() + WAIT_DISK_MS * 1000LL;
+    for (;;) {
+        scan(s);
+        if (s->found_count >= count) return true;
+        if (esp_timer_get_time() > deadline) return false;
+        vTaskDelay(1);
+    }
+}
+
+static int message(char *buf, const scan_t *s, uint32_t i, size_t len)
+{
+    int n = snprintf(buf, MSG_MAX, "%s%lu ", s->tag, (unsigned long)i);
+    while ((size_t)n < len) {
+        buf[n] = 'a' + (n % 26);
+        n++;
+    }
+    return n;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+void app_main(void)
+{
+    const char *env = getenv("SPP_TO_DISK_COUNT");
+    uint32_t count = env ? (uint32_t)atoi(env) : 10000;
+    env = getenv("SPP_TO_DISK_SINGLE");
+    uint32_t single = env ? (uint32_t)atoi(env) : 50;
+    env = getenv("SPP_TO_DISK_LEN");
+    size_t len = env ? (size_t)atoi(env) : 64;
+    if (len < 24) len = 24;
+    if (len > MSG_MAX) len = MSG_MAX;
+
+    scan_t s = { .dir = getenv("SPP_TO_DISK_LOG") };
+    if (!s.dir) s.dir = SD_CARD_MOUNT_POINT "/log";
+    esp_log_level_set("*", ESP_LOG_ERROR);
+
+    spp_client_t *c = spp_client_connect(BT_SPP_HOST_PORT);
+    if (!c) {
+        printf("connect to 127.0.0.1:%d failed, is the app running?\n", BT_SPP_HOST_PORT);
+        exit(1);
+    }
+    char buf[MSG_MAX];
+    uint32_t *lat = calloc(single ? single : 1, sizeof(*lat));
+    s.found = calloc(count > single ? count : single, 1);
+    if (!lat || !s.found) exit(1);
+
+    // 1. по одному сообщению
+    snprintf(s.tag, sizeof(s.tag), "L%lx:", (unsigned long)(esp_timer_get_time() & 0xfffff));
+    s.count = single;
+    scan_start(&s);
+    for (uint32_t i = 0; i < single; i++) {
+        int64_t start = esp_timer_get_time();
+        if (spp_client_send(c, buf, message(buf, &s, i, len)) != ESP_OK || spp_client_flush(c) != ESP_OK
+            || !wait_disk(&s, i + 1)) {
+            printf("message %lu did not reach the disk\n", (unsigned long)i);
+            exit(1);
+        }
+        lat[i] = (uint32_t)(esp_timer_get_time() - start);
+    }
+    qsort(lat, single, sizeof(*lat), cmp_u32);
+
+    // 2. поток
+    snprintf(s.tag, sizeof(s.tag), "T%lx:", (unsigned long)(esp_timer_get_time() & 0xfffff));
+    s.count = count;
+    s.found_count = 0;
+    memset(s.found, 0, count);
+    scan_start(&s);
+
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = ESP_OK;
+    for (uint32_t i = 0; i < count && ret == ESP_OK; i++) {
+        ret = spp_client_send(c, buf, message(buf, &s, i, len));
+    }
+    if (ret == ESP_OK) ret = spp_client_flush(c);
+    int64_t acked_us = esp_timer_get_time() - start;
+    bool all = ret == ESP_OK && wait_disk(&s, count);
+    int64_t disk_us = esp_timer_get_time() - start;
+
+    spp_client_stats_t st;
+    spp_client_get_stats(c, &st);
+    spp_client_close(c);
+
+    if (single) {
+        printf("latency to disk, %lu single messages: median %.1f ms, max %.1f ms\n",
+               (unsigned long)single, lat[single / 2] / 1000.0, lat[single - 1] / 1000.0);
+    }
+    printf("%lu messages x %u B: acked in %lld ms (%.0f msg/s), on disk in %lld ms (%.0f msg/s, %.0f KB/s); "
+           "%lu of %lu found, %lu resent%s\n",
+           (unsigned long)count, (unsigned)len, (long long)acked_us / 1000, count / (acked_us / 1e6),
+           (long long)disk_us / 1000, count / (disk_us / 1e6), count * len / 1024.0 / (disk_us / 1e6),
+           (unsigned long)s.found_count, (unsigned long)count, (unsigned long)st.resent,
+           ret == ESP_OK ? "" : ", CLIENT ERROR");
+    fflush(stdout);
+    exit(all ? 0 : 1);
+}
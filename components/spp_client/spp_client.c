@@ -0,0 +1,418 @@
+//
+// Created by deity on 17.10.2026.
+//
+#include "spp_client.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "ble.h"
+
+// В полёте считаем с запасом на заголовок элемента кольца устройства
+#define FRAME_COST(len)     ((len) + 16)
+#define CTL_PAYLOAD_MAX     16
+#define TEXT_LINE_MAX       256
+
+typedef enum {
+    RX_IDLE,        // текст или начало кадра
+    RX_HDR,
+    RX_PAYLOAD,
+} rx_state_t;
+
+typedef struct {
+    uint8_t  type;
+    uint16_t len;
+    uint8_t *data;
+} frame_t;
+
+struct spp_client {
+    int                  fd;
+    uint16_t             base;          // первый неподтверждённый
+    uint16_t             next;          // следующий к отправке (после отката < end)
+    uint16_t             end;           // следующий новый seq
+    uint32_t             credit;
+    bool                 have_credit;
+    bool                 rewound;       // откатились, ждём движения base
+    bool                 probing;
+    bool                 tail_probed;   // PROBE после последнего кадра уже послан
+    int64_t              last_ack_us;
+    int64_t              progress_us;
+    frame_t              win[SPP_CLIENT_WINDOW];
+    uint8_t             *pool;
+
+    rx_state_t           state;
+    uint8_t              hdr[BT_SPP_HDR_SIZE];
+    size_t               hdr_len;
+    uint16_t             pl_len;
+    size_t               pl_got;
+    uint8_t              pl[CTL_PAYLOAD_MAX];
+    char                 line[TEXT_LINE_MAX];
+    size_t               line_len;
+
+    bool                 status_ready;
+    uint8_t              status;
+    bool                 aborted;       // устройство отвергло кадр, ещё не сообщили
+    bool                 dead;
+
+    spp_client_text_cb_t text_cb;
+    void                *text_arg;
+    spp_client_stats_t   stats;
+};
+
+static int64_t now_us(void)
+{
+    return esp_timer_get_time();
+}
+
+static esp_err_t write_all(spp_client_t *c, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    while (len) {
+        ssize_t n = send(c->fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            c->dead = true;
+            return ESP_FAIL;
+        }
+        p += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t write_frame(spp_client_t *c, uint8_t type, uint16_t seq, const void *data, uint16_t len)
+{
+    uint8_t hdr[BT_SPP_HDR_SIZE] = {
+        BT_SPP_MAGIC, type, seq & 0xff, seq >> 8, len & 0xff, len >> 8,
+    };
+    esp_err_t ret = write_all(c, hdr, sizeof(hdr));
+    if (ret == ESP_OK && len) ret = write_all(c, data, len);
+    return ret;
+}
+
+static void on_ack(spp_client_t *c, uint16_t acked, uint16_t credit)
+{
+    uint16_t base = acked + 1;
+    uint16_t moved = base - c->base;
+
+    c->stats.acks++;
+    c->credit = credit;
+    c->have_credit = true;
+    c->last_ack_us = now_us();
+
+    if (moved && moved <= (uint16_t)(c->end - c->base)) {
+        c->base = base;
+        if ((int16_t)(c->next - base) < 0) c->next = base;
+        c->rewound = false;
+        c->probing = false;
+        c->progress_us = c->last_ack_us;
+        return;
+    }
+    // ACK без движения: ответ на PROBE или кадр отброшен (кольцо полно).
+    // После отката на каждый следующий кадр в полёте приходит такой же ACK -
+    // их пропускаем до движения base. ACK об освобождении места приходит
+    // с большим credit и откат не нужен.
+    bool dropped = !c->rewound && credit < 2 * BT_SPP_FRAME_MAX;
+    if (c->base != c->next && (c->probing || dropped)) {
+        c->stats.resent += (uint16_t)(c->next - c->base);
+        c->next = c->base;
+        c->rewound = true;
+    }
+    c->probing = false;
+}
+
+// Кадр seq не будет принят никогда: выбрасываем его и всё, что за ним
+static void on_abort(spp_client_t *c, uint16_t seq)
+{
+    if ((uint16_t)(seq - c->base) >= (uint16_t)(c->end - c->base)) return;
+    c->stats.aborted += (uint16_t)(c->end - seq);
+    c->base = c->next = c->end = seq;
+    c->rewound = false;
+    c->probing = false;
+    c->aborted = true;
+}
+
+static void on_frame(spp_client_t *c)
+{
+    uint8_t type = c->hdr[1];
+    uint16_t seq = c->hdr[2] | (c->hdr[3] << 8);
+
+    if (type == BT_SPP_ACK && c->pl_len == 2) {
+        on_ack(c, seq, c->pl[0] | (c->pl[1] << 8));
+    } else if (type == BT_SPP_FILE_STATUS && c->pl_len >= 1) {
+        c->status = c->pl[0];
+        c->status_ready = true;
+    } else if (type == BT_SPP_ABORT) {
+        on_abort(c, seq);
+    }
+}
+
+static void on_text(spp_client_t *c, uint8_t b)
+{
+    if (b == '\n' || c->line_len == sizeof(c->line) - 1) {
+        c->line[c->line_len] = '\0';
+        if (c->text_cb) c->text_cb(c->line, c->text_arg);
+        c->line_len = 0;
+        if (b == '\n') return;
+    }
+    c->line[c->line_len++] = (char)b;
+}
+
+static void parse(spp_client_t *c, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        uint8_t b = data[i];
+        switch (c->state) {
+            case RX_IDLE:
+                if (b == BT_SPP_MAGIC) {
+                    c->hdr[0] = b;
+                    c->hdr_len = 1;
+                    c->state = RX_HDR;
+                } else {
+                    on_text(c, b);
+                }
+                break;
+            case RX_HDR:
+                c->hdr[c->hdr_len++] = b;
+                if (c->hdr_len == BT_SPP_HDR_SIZE) {
+                    c->pl_len = c->hdr[4] | (c->hdr[5] << 8);
+                    c->pl_got = 0;
+                    c->state = c->pl_len ? RX_PAYLOAD : RX_IDLE;
+                    if (!c->pl_len) on_frame(c);
+                }
+                break;
+            case RX_PAYLOAD:
+                if (c->pl_got < sizeof(c->pl)) c->pl[c->pl_got] = b;
+                if (++c->pl_got == c->pl_len) {
+                    c->state = RX_IDLE;
+                    on_frame(c);
+                }
+                break;
+        }
+    }
+}
+
+void spp_client_poll(spp_client_t *c, int ms)
+{
+    struct pollfd pfd = { .fd = c->fd, .events = POLLIN };
+    int ret = poll(&pfd, 1, ms);
+    if (ret < 0 && errno == EINTR) return;
+    if (ret <= 0) return;
+
+    uint8_t buf[1024];
+    ssize_t n;
+    while ((n = recv(c->fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+        parse(c, buf, n);
+    }
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        c->dead = true;
+    }
+}
+
+static uint32_t in_flight(spp_client_t *c)
+{
+    uint32_t bytes = 0;
+    for (uint16_t s = c->base; s != c->next; s++) {
+        bytes += FRAME_COST(c->win[s % SPP_CLIENT_WINDOW].len);
+    }
+    return bytes;
+}
+
+// Без ACK дольше SPP_CLIENT_PROBE_MS - PROBE, без движения дольше тайм-аута - ошибка
+static esp_err_t wait_ack(spp_client_t *c)
+{
+    spp_client_poll(c, SPP_CLIENT_PROBE_MS / 4);
+    if (c->dead) return ESP_FAIL;
+
+    int64_t t = now_us();
+    if (t - c->progress_us > (int64_t)SPP_CLIENT_TIMEOUT_MS * 1000) return ESP_ERR_TIMEOUT;
+    if (t - c->last_ack_us > (int64_t)SPP_CLIENT_PROBE_MS * 1000) {
+        c->stats.probes++;
+        c->probing = true;
+        c->last_ack_us = t;
+        return write_frame(c, BT_SPP_PROBE, 0, NULL, 0);
+    }
+    return ESP_OK;
+}
+
+// Отправляем кадры от next до end, пока позволяет credit
+static esp_err_t pump(spp_client_t *c)
+{
+    while (c->next != c->end && c->have_credit) {
+        frame_t *f = &c->win[c->next % SPP_CLIENT_WINDOW];
+        if (in_flight(c) + FRAME_COST(f->len) > c->credit) break;
+        esp_err_t ret = write_frame(c, f->type, c->next, f->data, f->len);
+        if (ret != ESP_OK) return ret;
+        c->next++;
+        c->tail_probed = false;
+    }
+    return ESP_OK;
+}
+
+// Отвергнутые устройством кадры уже выброшены из окна, вызывающему - ошибка
+static esp_err_t take_abort(spp_client_t *c)
+{
+    if (!c->aborted) return ESP_OK;
+    c->aborted = false;
+    return ESP_ERR_INVALID_RESPONSE;
+}
+
+static esp_err_t queue_frame(spp_client_t *c, uint8_t type, const void *data, size_t len)
+{
+    if (len > BT_SPP_FRAME_MAX) return ESP_ERR_INVALID_SIZE;
+
+    // ждём места в окне: и в своём буфере, и по credit устройства
+    c->progress_us = now_us();
+    while ((uint16_t)(c->end - c->base) >= SPP_CLIENT_WINDOW) {
+        esp_err_t ret = pump(c);
+        if (ret == ESP_OK) ret = wait_ack(c);
+        if (ret != ESP_OK) return ret;
+    }
+
+    frame_t *f = &c->win[c->end % SPP_CLIENT_WINDOW];
+    f->type = type;
+    f->len = (uint16_t)len;
+    memcpy(f->data, data, len);
+    c->end++;
+    c->stats.frames++;
+    c->stats.bytes += len;
+
+    esp_err_t ret = pump(c);
+    spp_client_poll(c, 0);
+    if (c->dead) return ESP_FAIL;
+    return ret == ESP_OK ? take_abort(c) : ret;
+}
+
+spp_client_t *spp_client_connect(uint16_t port)
+{
+    spp_client_t *c = calloc(1, sizeof(*c));
+    if (!c) return NULL;
+    c->pool = malloc((size_t)SPP_CLIENT_WINDOW * BT_SPP_FRAME_MAX);
+    c->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (!c->pool || c->fd < 0) goto fail;
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    int ret;
+    do {
+        ret = connect(c->fd, (struct sockaddr *)&addr, sizeof(addr));
+    } while (ret != 0 && errno == EINTR);
+    if (ret != 0) goto fail;
+
+    int one = 1;
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    for (size_t i = 0; i < SPP_CLIENT_WINDOW; i++) {
+        c->win[i].data = c->pool + i * BT_SPP_FRAME_MAX;
+    }
+    c->last_ack_us = c->progress_us = now_us();
+    // credit до первого кадра берём из ответа на PROBE
+    c->stats.probes++;
+    if (write_frame(c, BT_SPP_PROBE, 0, NULL, 0) != ESP_OK) goto fail;
+    return c;
+
+fail:
+    if (c->fd >= 0) close(c->fd);
+    free(c->pool);
+    free(c);
+    return NULL;
+}
+
+void spp_client_close(spp_client_t *c)
+{
+    if (!c) return;
+    close(c->fd);
+    free(c->pool);
+    free(c);
+}
+
+void spp_client_on_text(spp_client_t *c, spp_client_text_cb_t cb, void *arg)
+{
+    c->text_cb = cb;
+    c->text_arg = arg;
+}
+
+esp_err_t spp_client_send(spp_client_t *c, const void *data, size_t len)
+{
+    if (!c || !data || !len) return ESP_ERR_INVALID_ARG;
+    return queue_frame(c, BT_SPP_DATA, data, len);
+}
+
+esp_err_t spp_client_flush(spp_client_t *c)
+{
+    c->progress_us = now_us();
+    while (c->base != c->end) {
+        esp_err_t ret = pump(c);
+        // устройство подтверждает раз в несколько кадров, и хвост ждал бы
+        // тайм-аута. PROBE идёт за кадрами, ответ на него покроет их все
+        if (ret == ESP_OK && c->next == c->end && !c->tail_probed) {
+            c->stats.probes++;
+            c->probing = true;
+            c->tail_probed = true;
+            c->last_ack_us = now_us();
+            ret = write_frame(c, BT_SPP_PROBE, 0, NULL, 0);
+        }
+        if (ret == ESP_OK) ret = wait_ack(c);
+        if (ret != ESP_OK) return ret;
+    }
+    return take_abort(c);
+}
+
+esp_err_t spp_client_send_file(spp_client_t *c, const char *name, const void *data, uint32_t size,
+                               uint8_t *status)
+{
+    size_t name_len = strlen(name);
+    uint8_t open[8 + 12];
+    if (!c || !status || name_len == 0 || name_len > 12) return ESP_ERR_INVALID_ARG;
+
+    uint32_t crc = esp_rom_crc32_le(0, data, size);
+    for (int i = 0; i < 4; i++) {
+        open[i] = size >> (8 * i);
+        open[4 + i] = crc >> (8 * i);
+    }
+    memcpy(open + 8, name, name_len);
+
+    c->status_ready = false;
+    esp_err_t ret = queue_frame(c, BT_SPP_FILE_OPEN, open, 8 + name_len);
+    for (uint32_t off = 0; ret == ESP_OK && off < size && !c->status_ready; off += BT_SPP_FRAME_MAX) {
+        uint32_t n = size - off < BT_SPP_FRAME_MAX ? size - off : BT_SPP_FRAME_MAX;
+        ret = queue_frame(c, BT_SPP_DATA, (const uint8_t *)data + off, n);
+    }
+    if (ret == ESP_OK && !c->status_ready) ret = spp_client_flush(c);
+
+    // FILE_STATUS приходит после fsync на стороне устройства
+    int64_t deadline = now_us() + (int64_t)SPP_CLIENT_TIMEOUT_MS * 1000;
+    while (ret == ESP_OK && !c->status_ready && !c->dead && now_us() < deadline) {
+        spp_client_poll(c, SPP_CLIENT_PROBE_MS);
+    }
+    // ошибку передачи (и ABORT за ней) устройство сообщило статусом
+    if (c->status_ready) {
+        c->aborted = false;
+        *status = c->status;
+        return ESP_OK;
+    }
+    if (ret != ESP_OK) return ret;
+    return c->dead ? ESP_FAIL : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t spp_client_write_raw(spp_client_t *c, const void *data, size_t len)
+{
+    if (!c || (!data && len)) return ESP_ERR_INVALID_ARG;
+    return write_all(c, data, len);
+}
+
+void spp_client_get_stats(spp_client_t *c, spp_client_stats_t *stats)
+{
+    if (c && stats) *stats = c->stats;
+}
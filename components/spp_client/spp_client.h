@@ -0,0 +1,89 @@
+//
+// Created by deity on 17.10.2026.
+//
+#pragma once
+
+#ifndef SPP_CLIENT_H
+#define SPP_CLIENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// Клиент кадрированного протокола SPP из ble.h поверх TCP (сборка под linux,
+// порт BT_SPP_HOST_PORT). Держит в полёте не больше credit байт из последнего
+// ACK, неподтверждённые кадры хранит у себя и при пропуске шлёт заново с
+// первого неподтверждённого (go-back-N). Без ACK дольше SPP_CLIENT_PROBE_MS
+// шлёт PROBE.
+#define SPP_CLIENT_WINDOW       256     // кадров в полёте, не больше
+#define SPP_CLIENT_PROBE_MS     200
+#define SPP_CLIENT_TIMEOUT_MS   10000
+
+typedef struct {
+    uint32_t frames;        // новых кадров отправлено
+    uint32_t resent;        // кадров отправлено повторно
+    uint32_t acks;
+    uint32_t probes;
+    uint32_t aborted;       // кадров выброшено по ABORT устройства
+    uint64_t bytes;         // байт данных в новых кадрах
+} spp_client_stats_t;
+
+// Строка текста без кадра от устройства (ответы команд, "OK\n")
+typedef void (*spp_client_text_cb_t)(const char *line, void *arg);
+
+typedef struct spp_client spp_client_t;
+
+/**
+ * @brief Connect to the SPP stand-in on 127.0.0.1
+ * @param port  usually BT_SPP_HOST_PORT
+ * @return client, or NULL if the connection failed
+ */
+spp_client_t *spp_client_connect(uint16_t port);
+
+/**
+ * @brief Close the connection; frames not yet acked are lost
+ */
+void spp_client_close(spp_client_t *c);
+
+/**
+ * @brief Receive unframed text lines through \p cb
+ */
+void spp_client_on_text(spp_client_t *c, spp_client_text_cb_t cb, void *arg);
+
+/**
+ * @brief Queue one DATA frame, waiting for window space
+ * @param len  1..BT_SPP_FRAME_MAX
+ * @return ESP_OK, ESP_ERR_TIMEOUT if the device stopped acking, ESP_FAIL if disconnected,
+ *         ESP_ERR_INVALID_RESPONSE if the device sent ABORT (the rejected frames are dropped)
+ */
+esp_err_t spp_client_send(spp_client_t *c, const void *data, size_t len);
+
+/**
+ * @brief Wait until every sent frame is acked
+ * @return ESP_OK, ESP_ERR_TIMEOUT, ESP_FAIL or ESP_ERR_INVALID_RESPONSE
+ */
+esp_err_t spp_client_flush(spp_client_t *c);
+
+/**
+ * @brief Send a whole file with FILE_OPEN and wait for FILE_STATUS
+ * @param name      8.3 name
+ * @param[out] status BT_SPP_FILE_* from the device
+ * @return ESP_OK if a status was received
+ */
+esp_err_t spp_client_send_file(spp_client_t *c, const char *name, const void *data, uint32_t size,
+                               uint8_t *status);
+
+/**
+ * @brief Write bytes to the socket as is, bypassing framing and the window
+ */
+esp_err_t spp_client_write_raw(spp_client_t *c, const void *data, size_t len);
+
+/**
+ * @brief Process whatever the device sent, waiting up to \p ms for it
+ */
+void spp_client_poll(spp_client_t *c, int ms);
+
+void spp_client_get_stats(spp_client_t *c, spp_client_stats_t *stats);
+
+#endif //SPP_CLIENT_H
@@ -0,0 +1,123 @@
+//
+// Created by deity on 17.10.2026.
+//
+#include "uart_ingest.h"
+#include "uart_ingest_port.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "msg_bus.h"
+
+static const char *TAG = "uart_ingest";
+
+uart_ring_t uart_ring;
+
+static struct {
+    TaskHandle_t task;
+    int64_t      start_us;
+    atomic_uint  lines;
+
+    char         line[MSG_BUS_PAYLOAD];
+    size_t       fill;
+} in;
+
+static void emit_line(void)
+{
+    if (!in.fill) return;
+
+    in.line[in.fill] = '\0';
+    in.fill = 0;
+    if (msg_bus_post_text(MSG_TOPIC_UART, in.line) == ESP_OK) {
+        atomic_fetch_add(&in.lines, 1);
+    }
+}
+
+// Разбор всего, что накопилось в кольце; место освобождается кусками,
+// чтобы прерывание могло писать, пока строка ещё собирается
+static void drain(void)
+{
+    unsigned tail = atomic_load_explicit(&uart_ring.tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&uart_ring.head, memory_order_acquire);
+
+    while (tail != head) {
+        size_t pos = tail & (UART_INGEST_RING_SIZE - 1);
+        size_t n = head - tail;
+        if (n > UART_INGEST_RING_SIZE - pos) n = UART_INGEST_RING_SIZE - pos;
+
+        const uint8_t *p = uart_ring.buf + pos;
+        for (size_t i = 0; i < n; i++) {
+            if (p[i] == '\r' || p[i] == '\n') {
+                emit_line();
+                continue;
+            }
+            in.line[in.fill++] = (char)p[i];
+            // длинная строка уходит кусками по размеру блока шины
+            if (in.fill == sizeof(in.line) - 1) emit_line();
+        }
+
+        tail += n;
+        atomic_store_explicit(&uart_ring.tail, tail, memory_order_release);
+        head = atomic_load_explicit(&uart_ring.head, memory_order_acquire);
+    }
+}
+
+static void ingest_task(void *arg)
+{
+    for (;;) {
+        // пока строка не закончена, ждём не дольше паузы: пауза - тоже граница
+        TickType_t wait = in.fill ? pdMS_TO_TICKS(UART_INGEST_IDLE_MS) : portMAX_DELAY;
+        if (ulTaskNotifyTake(pdTRUE, wait) == 0) {
+            emit_line();
+            continue;
+        }
+        drain();
+    }
+}
+
+esp_err_t uart_ingest_start(const uart_ingest_config_t *cfg)
+{
+    if (!cfg) return ESP_ERR_INVALID_ARG;
+    if (in.task) return ESP_ERR_INVALID_STATE;
+
+    memset(&uart_ring, 0, sizeof(uart_ring));
+    in.fill = 0;
+    atomic_store(&in.lines, 0);
+
+    if (xTaskCreate(ingest_task, "uart_ingest", UART_INGEST_TASK_STACK, NULL,
+                    UART_INGEST_TASK_PRIO, &in.task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = uart_port_start(cfg, in.task);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start UART%d: %s", cfg->port, esp_err_to_name(err));
+        vTaskDelete(in.task);
+        in.task = NULL;
+        return err;
+    }
+    in.start_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "UART%d at %lu baud", cfg->port, (unsigned long)cfg->baud);
+    return ESP_OK;
+}
+
+void uart_ingest_get_stats(uart_ingest_stats_t *out)
+{
+    if (!out) return;
+
+    memset(out, 0, sizeof(*out));
+    out->interrupts = atomic_load(&uart_ring.interrupts);
+    out->bytes = atomic_load(&uart_ring.bytes);
+    out->dropped = atomic_load(&uart_ring.dropped);
+    out->fifo_ovf = atomic_load(&uart_ring.fifo_ovf);
+    out->lines = atomic_load(&in.lines);
+
+    if (out->bytes) {
+        out->isr_per_kb = (uint32_t)((uint64_t)out->interrupts * 1024 / out->bytes);
+    }
+    int64_t us = in.task ? esp_timer_get_time() - in.start_us : 0;
+    if (us > 0) {
+        out->bytes_per_sec = (uint32_t)((uint64_t)out->bytes * 1000000 / us);
+    }
+}
@@ -0,0 +1,53 @@
+//
+// Created by deity on 17.10.2026.
+//
+
+#ifndef UART_INGEST_H
+#define UART_INGEST_H
+
+#include <stdint.h>
+#include <esp_err.h>
+
+// Приём строк с UART. Прерывание забирает весь FIFO за раз (по заполнению
+// до порога или по паузе в приёме) в кольцо без блокировок, задача режет
+// поток на строки по '\r'/'\n' или по паузе и публикует их на шину
+// сообщений текстом в MSG_TOPIC_UART; main подписан на топик и выводит
+// их как остальной текст.
+#define UART_INGEST_RING_SIZE   4096    // степень двойки
+#define UART_INGEST_FIFO_THR    96      // прерывание при стольких байтах в FIFO
+#define UART_INGEST_RX_TOUT     10      // ...или после паузы в столько символов
+#define UART_INGEST_IDLE_MS     50      // неполная строка уходит после паузы
+#define UART_INGEST_TASK_STACK  3072
+#define UART_INGEST_TASK_PRIO   6
+
+// Сборка под linux: вместо UART читается stdin
+typedef struct {
+    int      port;          // номер UART
+    uint32_t baud;
+    int      rx_pin;        // -1 - не менять
+} uart_ingest_config_t;
+
+typedef struct {
+    uint32_t interrupts;    // RX interrupts taken
+    uint32_t bytes;         // bytes read from the FIFO
+    uint32_t dropped;       // bytes lost because the ring was full
+    uint32_t fifo_ovf;      // hardware FIFO overflows
+    uint32_t lines;         // lines published
+    uint32_t isr_per_kb;    // interrupts per 1024 bytes received
+    uint32_t bytes_per_sec; // average rate since start
+} uart_ingest_stats_t;
+
+/**
+ * @brief Configure the UART and start receiving
+ * @param cfg  port, baud rate and RX pin
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if already started
+ */
+esp_err_t uart_ingest_start(const uart_ingest_config_t *cfg);
+
+/**
+ * @brief Get counters since start
+ * @param out  filled with the counters
+ */
+void uart_ingest_get_stats(uart_ingest_stats_t *out);
+
+#endif //UART_INGEST_H
@@ -0,0 +1,60 @@
+//
+// Created by deity on 17.10.2026.
+//
+// Сборка под linux: вместо UART - stdin. Каждое чтение считается одним
+// прерыванием, так что счётчики сравнимы с устройством.
+//
+#include "uart_ingest_port.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+
+static const char *TAG = "uart_host";
+
+#define POLL_MS         100
+
+static TaskHandle_t consumer;
+
+static void stdin_task(void *arg)
+{
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+
+    for (;;) {
+        int ret = poll(&pfd, 1, POLL_MS);
+        if (ret < 0 && errno != EINTR) break;
+        if (ret <= 0) continue;
+
+        uint8_t *dst;
+        size_t room = uart_ring_space(&dst);
+        if (room == 0) {
+            // как FIFO устройства: ждём, пока задача приёма освободит место
+            xTaskNotifyGive(consumer);
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        ssize_t n = read(STDIN_FILENO, dst, room);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        atomic_fetch_add_explicit(&uart_ring.interrupts, 1, memory_order_relaxed);
+        uart_ring_commit(n);
+        xTaskNotifyGive(consumer);
+    }
+
+    ESP_LOGI(TAG, "stdin closed");
+    vTaskDelete(NULL);
+}
+
+esp_err_t uart_port_start(const uart_ingest_config_t *cfg, TaskHandle_t task)
+{
+    consumer = task;
+    if (xTaskCreate(stdin_task, "uart_host", 3072, NULL, UART_INGEST_TASK_PRIO, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "UART%d stand-in reads stdin", cfg->port);
+    return ESP_OK;
+}
@@ -0,0 +1,58 @@
+//
+// Created by deity on 17.10.2026.
+//
+
+#ifndef UART_INGEST_PORT_H
+#define UART_INGEST_PORT_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "uart_ingest.h"
+
+// Кольцо приёма: пишет только источник (прерывание UART, на linux - задача
+// чтения stdin), читает только задача приёма. Индексы растут без обрезки,
+// позиция в буфере - младшие биты, поэтому хватает двух атомиков.
+_Static_assert((UART_INGEST_RING_SIZE & (UART_INGEST_RING_SIZE - 1)) == 0,
+               "ring size must be a power of two");
+
+typedef struct {
+    uint8_t     buf[UART_INGEST_RING_SIZE];
+    atomic_uint head;           // пишет источник
+    atomic_uint tail;           // пишет задача приёма
+
+    atomic_uint interrupts;
+    atomic_uint bytes;
+    atomic_uint dropped;
+    atomic_uint fifo_ovf;
+} uart_ring_t;
+
+extern uart_ring_t uart_ring;
+
+// Непрерывный свободный кусок кольца, до конца буфера
+static inline size_t uart_ring_space(uint8_t **dst)
+{
+    unsigned head = atomic_load_explicit(&uart_ring.head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&uart_ring.tail, memory_order_acquire);
+    size_t pos = head & (UART_INGEST_RING_SIZE - 1);
+    size_t room = UART_INGEST_RING_SIZE - (head - tail);
+    size_t to_end = UART_INGEST_RING_SIZE - pos;
+
+    *dst = uart_ring.buf + pos;
+    return room < to_end ? room : to_end;
+}
+
+// n байт из uart_ring_space() записаны
+static inline void uart_ring_commit(size_t n)
+{
+    unsigned head = atomic_load_explicit(&uart_ring.head, memory_order_relaxed);
+    atomic_store_explicit(&uart_ring.head, head + n, memory_order_release);
+    atomic_fetch_add_explicit(&uart_ring.bytes, n, memory_order_relaxed);
+}
+
+// Запуск источника: после каждой порции данных он будит consumer
+esp_err_t uart_port_start(const uart_ingest_config_t *cfg, TaskHandle_t consumer);
+
+#endif //UART_INGEST_PORT_H
@@ -0,0 +1,92 @@
+//
+// Created by deity on 17.10.2026.
+//
+// UART без драйвера uart_driver_install: своё прерывание вычитывает FIFO
+// целиком прямо в кольцо. Прерывание - по заполнению FIFO до
+// UART_INGEST_FIFO_THR байт или по паузе в UART_INGEST_RX_TOUT символов,
+// то есть одно на порцию, а не на байт.
+//
+#include "uart_ingest_port.h"
+
+#include "driver/uart.h"
+#include "esp_attr.h"
+#include "esp_intr_alloc.h"
+#include "hal/uart_ll.h"
+#include "soc/uart_periph.h"
+
+#define RX_INTR     (UART_INTR_RXFIFO_FULL | UART_INTR_RXFIFO_TOUT | UART_INTR_RXFIFO_OVF)
+
+static uart_dev_t *hw;
+static TaskHandle_t consumer;
+static intr_handle_t intr;
+
+static void IRAM_ATTR rx_isr(void *arg)
+{
+    uint32_t st = uart_ll_get_intsts_mask(hw);
+    if (!(st & RX_INTR)) return;
+
+    atomic_fetch_add_explicit(&uart_ring.interrupts, 1, memory_order_relaxed);
+    if (st & UART_INTR_RXFIFO_OVF) {
+        atomic_fetch_add_explicit(&uart_ring.fifo_ovf, 1, memory_order_relaxed);
+    }
+
+    // пока читаем, могут прийти ещё байты: читаем до пустого FIFO
+    uint32_t n;
+    while ((n = uart_ll_get_rxfifo_len(hw)) > 0) {
+        uint8_t *dst;
+        size_t room = uart_ring_space(&dst);
+        if (room == 0) {
+            // кольцо полно: FIFO всё равно надо опустошить, иначе
+            // прерывание по заполнению будет приходить снова и снова
+            uint8_t junk[16];
+            uint32_t chunk = n < sizeof(junk) ? n : sizeof(junk);
+            uart_ll_read_rxfifo(hw, junk, chunk);
+            atomic_fetch_add_explicit(&uart_ring.dropped, chunk, memory_order_relaxed);
+            continue;
+        }
+        uint32_t chunk = n < room ? n : room;
+        uart_ll_read_rxfifo(hw, dst, chunk);
+        uart_ring_commit(chunk);
+    }
+    uart_ll_clr_intsts_mask(hw, st & RX_INTR);
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(consumer, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+esp_err_t uart_port_start(const uart_ingest_config_t *cfg, TaskHandle_t task)
+{
+    if (cfg->port < 0 || cfg->port >= UART_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    const uart_config_t uart_cfg = {
+        .baud_rate = (int)cfg->baud,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    esp_err_t err = uart_param_config(cfg->port, &uart_cfg);
+    if (err != ESP_OK) return err;
+    if (cfg->rx_pin >= 0) {
+        err = uart_set_pin(cfg->port, UART_PIN_NO_CHANGE, cfg->rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+        if (err != ESP_OK) return err;
+    }
+    if ((err = uart_set_rx_full_threshold(cfg->port, UART_INGEST_FIFO_THR)) != ESP_OK) return err;
+    if ((err = uart_set_rx_timeout(cfg->port, UART_INGEST_RX_TOUT)) != ESP_OK) return err;
+
+    hw = UART_LL_GET_HW(cfg->port);
+    consumer = task;
+
+    uart_ll_disable_intr_mask(hw, UART_LL_INTR_MASK);
+    uart_ll_rxfifo_rst(hw);
+    uart_ll_clr_intsts_mask(hw, UART_LL_INTR_MASK);
+
+    err = esp_intr_alloc(uart_periph_signal[cfg->port].irq, ESP_INTR_FLAG_IRAM,
+                         rx_isr, NULL, &intr);
+    if (err != ESP_OK) return err;
+
+    uart_ll_ena_intr_mask(hw, RX_INTR);
+    return ESP_OK;
+}
@@ -1,21 +1,53 @@
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/stat.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "esp_system.h"
 #include "esp_log.h"
 #include "mono_lcd.h"
 #include "nvs_flash.h"
-#include "esp_bt.h"
-#include "esp_gap_ble_api.h"
 #include "sd_card_logic.h"
+#include "sd_writer.h"
+#include "sd_segment.h"
 #include "ble.h"
-#include "soc/uart_struct.h"
+#include "msg_bus.h"
+#include "uart_ingest.h"
+#include "i2cdev.h"
+#include "sensor_sched.h"
+#if CONFIG_FIZZY_SENSORS
+#include "sensor_drivers.h"
+#include "scd4x.h"
+#endif
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_system.h"
+#include "esp_bt.h"
+#include "esp_gap_ble_api.h"
+#endif
 
-#define MOUNT_POINT "/sdcard"
+#define MOUNT_POINT SD_CARD_MOUNT_POINT
+#define LOG_DIR     MOUNT_POINT "/log"
+#define RX_DIR      MOUNT_POINT "/rx"
+
+// Сколько последних сообщений показать при загрузке
+#define REPLAY_LAST 20
+#define REPLAY_STEP_MS 150
+
+// Подписчик main: сообщений в очереди и глубина темы SPP. Уведомлений SPP
+// много не нужно, данные всё равно лежат в кольце ble
+#define MAIN_SUB_DEPTH  16
+#define SPP_TOPIC_DEPTH 2
+
+// Команда по SPP: замер скорости SD карты
+#define CMD_SD_BENCH "/sdbench"
+// Команда по UART: счётчики приёма UART на экран
+#define CMD_UART_STATS "/uartstat"
+// Команда по SPP или UART: счётчики шины I2C на карту и клиенту SPP
+#define CMD_I2C_STATS "/i2cstat"
+
+// Приём строк с UART0 вместо консольного ввода
+#define UART_PORT   0
+#define UART_BAUD   115200
 
 // Пины для подключения SD карты
 #define PIN_MISO    GPIO_NUM_19
@@ -26,57 +58,192 @@
 const char* TAG = "fizzy_wair";
 TaskHandle_t  MAIN_CYCLE_DESC = NULL;
 
-typedef enum {
-    DISP_TEXT,
-    DISP_ICON,
-    DISP_CLEAR,
-} disp_msg_type_t;
-
-typedef struct {
-    disp_msg_type_t type;
-    union {
-        struct { char text[32]; } txt;
-        struct { uint8_t icon_id; } icon;
-    } payload;
-} disp_msg_t;
-
-QueueHandle_t q;
+static msg_sub_t *sub;
 
 const char* texts[] = {
     "[NEXT YEAR] Gas has been smoked again",
     NULL
 };
 
-void IRAM_ATTR uart_isr(void)
+static bool replay_record(const sd_record_t *rec, void *arg)
 {
-    uint8_t byte = UART0.fifo.rw_byte;
-    xQueueSendFromISR(q, &byte, NULL);
+    if (rec->type != SD_REC_TEXT) return true;
+
+    char line[128];
+    size_t n = rec->len < sizeof(line) - 1 ? rec->len : sizeof(line) - 1;
+    memcpy(line, rec->data, n);
+    line[n] = '\0';
+
+    // лог идёт лентой: на строку уходит только новая страница экрана
+    mono_lcd_scroll_line(line);
+
+    vTaskDelay(pdMS_TO_TICKS(REPLAY_STEP_MS));
+    return true;
 }
 
-bool check_file_exists_std(const char* filename) {
-    struct stat st;
-    return (stat(filename, &st) == 0);
+static void run_sd_benchmark(void)
+{
+    sd_bench_result_t res;
+    char line[32];
+
+    mono_lcd_clear();
+    mono_lcd_draw_text("SD bench...");
+    if (sd_card_benchmark(TAG, &res) != ESP_OK) {
+        mono_lcd_clear();
+        mono_lcd_draw_text("SD bench failed");
+        return;
+    }
+
+    snprintf(line, sizeof(line), "W %lu R %lu KB/s",
+             (unsigned long)res.seq_write.kbps, (unsigned long)res.seq_read.kbps);
+    mono_lcd_clear();
+    mono_lcd_draw_text(line);
 }
 
-long get_file_size(const char *path) {
-    FILE *f = fopen(path, "rb");
-    if (!f) {
-        perror("fopen");
-        return -1;
+static void show_uart_stats(void)
+{
+    uart_ingest_stats_t st;
+    char line[64];
+
+    uart_ingest_get_stats(&st);
+    snprintf(line, sizeof(line), "UART %lu irq/KB %lu B/s drop %lu",
+             (unsigned long)st.isr_per_kb, (unsigned long)st.bytes_per_sec, (unsigned long)st.dropped);
+    mono_lcd_clear();
+    mono_lcd_draw_text(line);
+}
+
+#if CONFIG_FIZZY_SENSORS
+#define SCD4X_MIN_PERIOD_MS 5000    // периодический режим: новые данные раз в 5 с
+
+static bme680_t bme680;
+static sht3x_t sht3x;
+static i2c_dev_t scd4x;
+static sensor_bme680_t bme680_sensor = { .dev = &bme680 };
+static sensor_sht3x_t sht3x_sensor = { .dev = &sht3x };
+static sensor_scd4x_t scd4x_sensor = { .dev = &scd4x };
+
+// датчики на своём порту, опрашивает задача sensor_sched, отсчёты приходят
+// в основной цикл через шину сообщений
+static void start_sensors(void)
+{
+    const i2c_port_t port = CONFIG_FIZZY_SENSOR_PORT;
+    const gpio_num_t sda = CONFIG_FIZZY_SENSOR_SDA_GPIO, scl = CONFIG_FIZZY_SENSOR_SCL_GPIO;
+
+    if (i2cdev_init() != ESP_OK) {
+        ESP_LOGE(TAG, "I2C init failed, no sensors");
+        return;
+    }
+#if CONFIG_FIZZY_SENSOR_BME680
+    if (bme680_init_desc(&bme680, BME680_I2C_ADDR_1, port, sda, scl) == ESP_OK && bme680_init_sensor(&bme680) == ESP_OK) {
+        sensor_sched_add(&sensor_bme680_ops, &bme680_sensor, CONFIG_FIZZY_SENSOR_PERIOD_MS);
+    } else {
+        ESP_LOGE(TAG, "BME680 not found");
+    }
+#endif
+#if CONFIG_FIZZY_SENSOR_SHT3X
+    if (sht3x_init_desc(&sht3x, SHT3X_I2C_ADDR_GND, port, sda, scl) == ESP_OK && sht3x_init(&sht3x) == ESP_OK) {
+        sensor_sched_add(&sensor_sht3x_ops, &sht3x_sensor, CONFIG_FIZZY_SENSOR_PERIOD_MS);
+    } else {
+        ESP_LOGE(TAG, "SHT3x not found");
+    }
+#endif
+#if CONFIG_FIZZY_SENSOR_SCD4X
+    if (scd4x_init_desc(&scd4x, port, sda, scl) == ESP_OK && scd4x_start_periodic_measurement(&scd4x) == ESP_OK) {
+        uint32_t period = CONFIG_FIZZY_SENSOR_PERIOD_MS < SCD4X_MIN_PERIOD_MS ? SCD4X_MIN_PERIOD_MS : CONFIG_FIZZY_SENSOR_PERIOD_MS;
+        sensor_sched_add(&sensor_scd4x_ops, &scd4x_sensor, period);
+    } else {
+        ESP_LOGE(TAG, "SCD4x not found");
+    }
+#endif
+    if (sensor_sched_start() != ESP_OK) {
+        ESP_LOGE(TAG, "Sensor scheduler not started");
     }
-    if (fseek(f, 0, SEEK_END) != 0) {
-        perror("fseek");
-        fclose(f);
-        return -1;
+}
+#endif
+
+// отсчёт датчика - строкой в лог, экран остаётся сообщениям
+static void log_sample(const sensor_sample_t *sample)
+{
+    char line[64];
+    int n = snprintf(line, sizeof(line), "s%u", sample->sensor);
+    for (int i = 0; i < sample->count && n < (int)sizeof(line); i++) {
+        n += snprintf(line + n, sizeof(line) - n, " %.1f", sample->value[i]);
     }
-    long size = ftell(f);
-    if (size < 0) {
-        perror("ftell");
+    if (sd_writer_write_text(line) != ESP_OK) {
+        ESP_LOGW(TAG, "Отсчёт датчика не записан");
     }
-    fclose(f);
+}
 
-    ESP_LOGI(TAG, "File size: %ld", size);
-    return size;
+static void i2c_stat_line(const char *line, void *arg)
+{
+    char text[224];
+    unsigned *lines = arg;
+
+    ESP_LOGI(TAG, "%s", line);
+    if (sd_writer_write_text(line) != ESP_OK) {
+        ESP_LOGE(TAG, "Буфер записи на карту переполнен, сообщение потеряно");
+    }
+    snprintf(text, sizeof(text), "%s\n", line);
+    bt_spp_send_text(text);
+    (*lines)++;
+}
+
+// По строке на устройство: видно, какой драйвер занимает шину
+static void dump_i2c_stats(void)
+{
+    char line[32];
+    unsigned lines = 0;
+
+    mono_lcd_clear();
+    if (i2c_dev_trace_dump(i2c_stat_line, &lines) != ESP_OK) {
+        mono_lcd_draw_text("I2C trace is off");
+        return;
+    }
+    sd_writer_flush();
+
+    snprintf(line, sizeof(line), "I2C: %u devices", lines);
+    mono_lcd_draw_text(line);
+}
+
+// Забираем всё, что лежит в кольце приёма SPP: пакеты пишутся на карту
+// прямо из кольца и целиком, на экран идёт только последний
+static void handle_spp_data(void)
+{
+    char line[32];
+    size_t len, shown = 0;
+    uint8_t *data;
+
+    while ((data = bt_spp_receive(&len, 0)) != NULL) {
+        if (len == strlen(CMD_SD_BENCH) && memcmp(data, CMD_SD_BENCH, len) == 0) {
+            bt_spp_return(data);
+            run_sd_benchmark();
+            shown = 0;
+            continue;
+        }
+        if (len == strlen(CMD_I2C_STATS) && memcmp(data, CMD_I2C_STATS, len) == 0) {
+            bt_spp_return(data);
+            dump_i2c_stats();
+            shown = 0;
+            continue;
+        }
+
+        // ACK клиенту уже ушёл: при полном буфере ждём, пока писатель освободит
+        // место. Пакет держит кольцо SPP, а окно кредитов придерживает клиента
+        esp_err_t err = sd_writer_write_record_wait(SD_REC_TEXT, data, len, portMAX_DELAY);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Сообщение не записано на карту: %s", esp_err_to_name(err));
+        }
+
+        shown = len < sizeof(line) - 1 ? len : sizeof(line) - 1;
+        memcpy(line, data, shown);
+        line[shown] = '\0';
+        bt_spp_return(data);
+    }
+
+    if (shown) {
+        mono_lcd_clear();
+        mono_lcd_draw_text(line);
+    }
 }
 
 void main_cycle(void *pvParameters) {
@@ -102,89 +269,106 @@ void main_cycle(void *pvParameters) {
 
     vTaskDelay(pdMS_TO_TICKS(5000));
 
-    const char *filename = "/sdcard/test.txt";
+    if (sd_segment_init(LOG_DIR) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open log directory");
+        return;
+    }
 
-    if (check_file_exists_std(filename)) {
-        ESP_LOGI(TAG, "Reading file");
+    ESP_LOGI(TAG, "Reading log");
+    // сразу к хвосту лога по индексу блоков, без чтения файлов целиком
+    sd_segment_read_last(REPLAY_LAST, replay_record, NULL);
 
-        FILE *f = fopen(filename, "r");
-        if (f == NULL) {
-            ESP_LOGE(TAG, "Failed to open file for reading");
-            return;
-        }
-
-        char line[512];
-        while (fgets(line, sizeof(line), f) != NULL) {
-            char *pos = strchr(line, '\n');
-            if (pos) *pos = '\0';
+    ESP_LOGI(TAG, "Тестирование завершено");
+    ESP_LOGI(TAG, "Перезагрузка через 5 секунд...");
 
-            mono_lcd_clear();
-            mono_lcd_draw_text(line);
+    vTaskDelay(pdMS_TO_TICKS(5000));
 
-            vTaskDelay(pdMS_TO_TICKS(1000));
-        }
+    if (sd_writer_start() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start SD writer");
+        return;
+    }
 
-        fclose(f);
-    } else {
-        FILE *f = fopen(filename, "wb");
-        if (f == NULL) {
-            perror("fopen");
-            ESP_LOGE(TAG, "Failed to open file");
-            return;
-        }
-        fprintf(f, "Hello, world!\n");
-        fclose(f);
-        ESP_LOGI(TAG, "File written");
+    // файлы по SPP пишутся на карту мимо очереди сообщений
+    if (bt_spp_file_init(RX_DIR) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to enable SPP file transfer");
     }
 
-    ESP_LOGI(TAG, "Тестирование завершено");
-    ESP_LOGI(TAG, "Перезагрузка через 5 секунд...");
+    // строки с UART идут тем же путём, что и текст по SPP: экран и лог
+    const uart_ingest_config_t uart_cfg = {
+        .port = UART_PORT,
+        .baud = UART_BAUD,
+        .rx_pin = -1,
+    };
+    if (uart_ingest_start(&uart_cfg) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start UART ingest");
+    }
 
-    vTaskDelay(pdMS_TO_TICKS(5000));
+#if CONFIG_FIZZY_SENSORS
+    start_sensors();
+#endif
 
-    disp_msg_t msg;
+    msg_t *msg;
 
-    while (xQueueReceive(q, &msg, portMAX_DELAY) == pdPASS)
+    while ((msg = msg_bus_receive(sub, portMAX_DELAY)) != NULL)
     {
-        switch (msg.type) {
-            case DISP_TEXT:
-                mono_lcd_clear();
-                mono_lcd_draw_text(msg.payload.txt.text);
-
-                long old_size = get_file_size(filename);
-                ESP_LOGI(TAG, "OLD File size: %ld", old_size);
-
-                FILE *f = fopen(filename, "ab");
+        const char *text = (const char *)msg->data;
 
-                // todo; mv to var впадлу щас(
-                size_t written = fwrite(msg.payload.txt.text, 1, strlen(msg.payload.txt.text), f);
-                if (written != strlen(msg.payload.txt.text)) {
-                    perror("fwrite");
+        switch (msg->type) {
+            case MSG_TEXT:
+                if (strcmp(text, CMD_SD_BENCH) == 0) {
+                    run_sd_benchmark();
+                    break;
                 }
-                fwrite("\n", 1, 1, f);
-                fclose(f);
-
-                long new_size = get_file_size(filename);
-                if (new_size != old_size + (long)strlen(msg.payload.txt.text) + 1) { // +1 для '\n'
-                    ESP_LOGE(TAG, "Записано не так много, как ожидалось");
+                if (strcmp(text, CMD_UART_STATS) == 0) {
+                    show_uart_stats();
+                    break;
+                }
+                if (strcmp(text, CMD_I2C_STATS) == 0) {
+                    dump_i2c_stats();
+                    break;
                 }
 
-                ESP_LOGI(TAG, "NEW File size: %ld", new_size);
+                // запись на карту идёт в своей задаче, здесь только очередь
+                if (sd_writer_write_text(text) != ESP_OK) {
+                    ESP_LOGE(TAG, "Буфер записи на карту переполнен, сообщение потеряно");
+                }
 
-                vTaskDelay(pdMS_TO_TICKS(1000));
+                mono_lcd_clear();
+                mono_lcd_draw_text(text);
+                break;
+            case MSG_SPP_DATA:
+                handle_spp_data();
+                break;
+            case MSG_SENSOR_VALUE:
+                log_sample((const sensor_sample_t *)msg->data);
                 break;
             default:
                 mono_lcd_clear();
                 break;
         }
+        msg_bus_release(msg);
     }
 
+    sd_writer_stop();
+    sd_segment_deinit();
     cleanup_sd_card(TAG);
 }
 
 void app_main(void)
 {
-    q = xQueueCreate(10, sizeof(disp_msg_t));
+    ESP_ERROR_CHECK(msg_bus_init());
+    sub = msg_bus_sub_create(MAIN_SUB_DEPTH);
+    if (!sub) {
+        ESP_LOGE(TAG, "No memory for the message queue");
+        return;
+    }
+    msg_bus_subscribe(sub, MSG_TOPIC_DISPLAY);
+    msg_bus_subscribe(sub, MSG_TOPIC_SPP);
+    msg_bus_subscribe(sub, MSG_TOPIC_UART);
+#if CONFIG_FIZZY_SENSORS
+    msg_bus_subscribe(sub, MSG_TOPIC_SENSOR);
+#endif
+    msg_bus_set_depth(MSG_TOPIC_SPP, SPP_TOPIC_DEPTH);
 
     esp_err_t err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -202,5 +386,5 @@ void app_main(void)
         &MAIN_CYCLE_DESC
     );
 
-    bt_app_gatt_start(q);
+    bt_app_gatt_start();
 }